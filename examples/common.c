@@ -152,6 +152,7 @@ dctool_event_cb (dc_device_t *device, dc_event_type_t event, const void *data, v
 	const dc_event_devinfo_t *devinfo = (const dc_event_devinfo_t *) data;
 	const dc_event_clock_t *clock = (const dc_event_clock_t *) data;
 	const dc_event_vendor_t *vendor = (const dc_event_vendor_t *) data;
+	const dc_event_stats_t *stats = (const dc_event_stats_t *) data;
 
 	switch (event) {
 	case DC_EVENT_WAITING:
@@ -178,6 +179,12 @@ dctool_event_cb (dc_device_t *device, dc_event_type_t event, const void *data, v
 			message ("%02X", vendor->data[i]);
 		message ("\n");
 		break;
+	case DC_EVENT_STATS:
+		message ("Event: read=%u, written=%u, calls=%u, retries=%u, checksums=%u, naks=%u, sleep=%u\n",
+			stats->nread, stats->nwritten, stats->ncalls,
+			stats->nretries, stats->nchecksums, stats->nnaks,
+			stats->sleeptime);
+		break;
 	default:
 		break;
 	}
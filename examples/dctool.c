@@ -60,6 +60,7 @@ static const dctool_command_t *g_commands[] = {
 	&dctool_list,
 	&dctool_download,
 	&dctool_dump,
+	&dctool_bench,
 	&dctool_parse,
 	&dctool_read,
 	&dctool_write,
@@ -110,6 +111,10 @@ dctool_command_showhelp (const dctool_command_t *command)
 			"   -f, --family <family>     Device family type\n"
 			"   -m, --model <model>       Device model number\n"
 			"   -l, --logfile <logfile>   Logfile\n"
+			"   -r, --record <tracefile>  Record the I/O traffic\n"
+			"   -p, --replay <tracefile>  Replay the I/O traffic\n"
+			"   -s, --speed <speed>       Replay speed (0 for no delays)\n"
+			"   -c, --cache <directory>   Memory cache directory\n"
 			"   -q, --quiet               Quiet mode\n"
 			"   -v, --verbose             Verbose mode\n"
 #else
@@ -118,6 +123,10 @@ dctool_command_showhelp (const dctool_command_t *command)
 			"   -f <family>    Family type\n"
 			"   -m <model>     Model number\n"
 			"   -l <logfile>   Logfile\n"
+			"   -r <tracefile> Record the I/O traffic\n"
+			"   -p <tracefile> Replay the I/O traffic\n"
+			"   -s <speed>     Replay speed (0 for no delays)\n"
+			"   -c <directory> Memory cache directory\n"
 			"   -q             Quiet mode\n"
 			"   -v             Verbose mode\n"
 #endif
@@ -177,10 +186,14 @@ main (int argc, char *argv[])
 	dc_family_t family = DC_FAMILY_NULL;
 	unsigned int model = 0;
 	unsigned int have_family = 0, have_model = 0;
+	dc_trace_mode_t tracemode = DC_TRACE_NONE;
+	const char *tracefile = NULL;
+	unsigned int speed = 1;
+	const char *cachedir = NULL;
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = NOPERMUTATION "hd:f:m:l:qv";
+	const char *optstring = NOPERMUTATION "hd:f:m:l:r:p:s:c:qv";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
@@ -188,6 +201,10 @@ main (int argc, char *argv[])
 		{"family",      required_argument, 0, 'f'},
 		{"model",       required_argument, 0, 'm'},
 		{"logfile",     required_argument, 0, 'l'},
+		{"record",      required_argument, 0, 'r'},
+		{"replay",      required_argument, 0, 'p'},
+		{"speed",       required_argument, 0, 's'},
+		{"cache",       required_argument, 0, 'c'},
 		{"quiet",       no_argument,       0, 'q'},
 		{"verbose",     no_argument,       0, 'v'},
 		{0,             0,                 0,  0 }
@@ -214,6 +231,20 @@ main (int argc, char *argv[])
 		case 'l':
 			logfile = optarg;
 			break;
+		case 'r':
+			tracemode = DC_TRACE_RECORD;
+			tracefile = optarg;
+			break;
+		case 'p':
+			tracemode = DC_TRACE_REPLAY;
+			tracefile = optarg;
+			break;
+		case 's':
+			speed = strtoul (optarg, NULL, 0);
+			break;
+		case 'c':
+			cachedir = optarg;
+			break;
 		case 'q':
 			loglevel = DC_LOGLEVEL_NONE;
 			break;
@@ -275,6 +306,12 @@ main (int argc, char *argv[])
 	dc_context_set_loglevel (context, loglevel);
 	dc_context_set_logfunc (context, logfunc, NULL);
 
+	// Setup the I/O tracing.
+	dc_context_set_trace (context, tracemode, tracefile, speed);
+
+	// Setup the memory cache.
+	dc_context_set_cache (context, cachedir);
+
 	if (command->config & DCTOOL_CONFIG_DESCRIPTOR) {
 		// Check mandatory arguments.
 		if (device == NULL && family == DC_FAMILY_NULL) {
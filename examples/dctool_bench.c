@@ -0,0 +1,376 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef HAVE_GETOPT_H
+#include <getopt.h>
+#endif
+#ifdef _WIN32
+#include <windows.h>
+#elif defined (HAVE_CLOCK_GETTIME)
+#include <time.h>
+#else
+#include <sys/time.h>
+#endif
+
+#include <libdivecomputer/context.h>
+#include <libdivecomputer/descriptor.h>
+#include <libdivecomputer/device.h>
+#include <libdivecomputer/parser.h>
+
+#include "dctool.h"
+#include "common.h"
+#include "utils.h"
+
+typedef struct bench_result_t {
+	dc_status_t status;
+	unsigned int ndives;
+	unsigned long long nbytes;
+	double open;
+	double firstdive;
+	double transfer;
+	double parse;
+	double total;
+	dc_event_stats_t stats;
+} bench_result_t;
+
+typedef struct bench_data_t {
+	dc_device_t *device;
+	double start;
+	bench_result_t *result;
+} bench_data_t;
+
+/*
+ * Get the value of a monotonic clock in seconds. The system time can
+ * change during a run, and is only used as a fallback.
+ */
+static double
+bench_now (void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER now, frequency;
+	QueryPerformanceCounter (&now);
+	QueryPerformanceFrequency (&frequency);
+	return (double) now.QuadPart / frequency.QuadPart;
+#elif defined (HAVE_CLOCK_GETTIME)
+	struct timespec now;
+	clock_gettime (CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1000000000.0;
+#else
+	struct timeval now;
+	gettimeofday (&now, NULL);
+	return now.tv_sec + now.tv_usec / 1000000.0;
+#endif
+}
+
+static void
+sample_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+}
+
+static int
+dive_cb (const unsigned char *data, unsigned int size, const unsigned char *fingerprint, unsigned int fsize, void *userdata)
+{
+	bench_data_t *benchdata = (bench_data_t *) userdata;
+	bench_result_t *result = benchdata->result;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_parser_t *parser = NULL;
+	dc_datetime_t datetime = {0};
+	unsigned int divetime = 0;
+	double maxdepth = 0.0;
+
+	double start = bench_now ();
+
+	if (result->ndives == 0)
+		result->firstdive = start - benchdata->start;
+
+	result->ndives++;
+	result->nbytes += size;
+
+	// Parse the dive data.
+	rc = dc_parser_new (&parser, benchdata->device);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR ("Error creating the parser.");
+		goto cleanup;
+	}
+
+	rc = dc_parser_set_data (parser, data, size);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR ("Error registering the data.");
+		goto cleanup;
+	}
+
+	dc_parser_get_datetime (parser, &datetime);
+	dc_parser_get_field (parser, DC_FIELD_DIVETIME, 0, &divetime);
+	dc_parser_get_field (parser, DC_FIELD_MAXDEPTH, 0, &maxdepth);
+
+	rc = dc_parser_samples_foreach (parser, sample_cb, NULL);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR ("Error parsing the sample data.");
+		goto cleanup;
+	}
+
+cleanup:
+	dc_parser_destroy (parser);
+	result->parse += bench_now () - start;
+	return 1;
+}
+
+static dc_status_t
+bench (dc_context_t *context, dc_descriptor_t *descriptor, const char *devname, bench_result_t *result)
+{
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	dc_device_t *device = NULL;
+	bench_data_t benchdata = {0};
+
+	double start = bench_now ();
+
+	// Open the device. Most backends perform the handshake with the
+	// device in the open call, so this also measures the handshake.
+	rc = dc_device_open (&device, context, descriptor, devname);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR ("Error opening the device.");
+		goto cleanup;
+	}
+
+	result->open = bench_now () - start;
+
+	benchdata.device = device;
+	benchdata.result = result;
+
+	// Register the cancellation handler.
+	rc = dc_device_set_cancel (device, dctool_cancel_cb, NULL);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR ("Error registering the cancellation handler.");
+		goto cleanup;
+	}
+
+	// Download the dives.
+	benchdata.start = bench_now ();
+	rc = dc_device_foreach (device, dive_cb, &benchdata);
+	result->transfer = bench_now () - benchdata.start - result->parse;
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR ("Error downloading the dives.");
+		goto cleanup;
+	}
+
+cleanup:
+	dc_device_get_stats (device, &result->stats);
+	dc_device_close (device);
+	result->total = bench_now () - start;
+	result->status = rc;
+	return rc;
+}
+
+static void
+bench_print_string (FILE *fp, const char *str)
+{
+	fputc ('"', fp);
+	for (const char *p = str; p && *p; ++p) {
+		if (*p == '"' || *p == '\\')
+			fputc ('\\', fp);
+		fputc (*p, fp);
+	}
+	fputc ('"', fp);
+}
+
+static void
+bench_print (FILE *fp, dc_descriptor_t *descriptor, const bench_result_t results[], unsigned int count)
+{
+	fprintf (fp, "{\n");
+	fprintf (fp, "\t\"vendor\": ");
+	bench_print_string (fp, dc_descriptor_get_vendor (descriptor));
+	fprintf (fp, ",\n");
+	fprintf (fp, "\t\"product\": ");
+	bench_print_string (fp, dc_descriptor_get_product (descriptor));
+	fprintf (fp, ",\n");
+	fprintf (fp, "\t\"runs\": [");
+	for (unsigned int i = 0; i < count; ++i) {
+		const bench_result_t *result = results + i;
+		double throughput = result->transfer > 0.0 ? result->nbytes / result->transfer : 0.0;
+		fprintf (fp, "%s\n\t\t{\n", i ? "," : "");
+		fprintf (fp, "\t\t\t\"status\": ");
+		bench_print_string (fp, dctool_errmsg (result->status));
+		fprintf (fp, ",\n");
+		fprintf (fp, "\t\t\t\"dives\": %u,\n", result->ndives);
+		fprintf (fp, "\t\t\t\"bytes\": %llu,\n", result->nbytes);
+		fprintf (fp, "\t\t\t\"throughput\": %.1f,\n", throughput);
+		fprintf (fp, "\t\t\t\"open\": %.6f,\n", result->open);
+		fprintf (fp, "\t\t\t\"firstdive\": %.6f,\n", result->firstdive);
+		fprintf (fp, "\t\t\t\"transfer\": %.6f,\n", result->transfer);
+		fprintf (fp, "\t\t\t\"parse\": %.6f,\n", result->parse);
+		fprintf (fp, "\t\t\t\"total\": %.6f,\n", result->total);
+		fprintf (fp, "\t\t\t\"read\": %u,\n", result->stats.nread);
+		fprintf (fp, "\t\t\t\"written\": %u,\n", result->stats.nwritten);
+		fprintf (fp, "\t\t\t\"calls\": %u,\n", result->stats.ncalls);
+		fprintf (fp, "\t\t\t\"retries\": %u,\n", result->stats.nretries);
+		fprintf (fp, "\t\t\t\"checksums\": %u,\n", result->stats.nchecksums);
+		fprintf (fp, "\t\t\t\"naks\": %u,\n", result->stats.nnaks);
+		fprintf (fp, "\t\t\t\"sleeptime\": %u\n", result->stats.sleeptime);
+		fprintf (fp, "\t\t}");
+	}
+	fprintf (fp, "\n\t]\n");
+	fprintf (fp, "}\n");
+}
+
+static int
+dctool_bench_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t *descriptor)
+{
+	int exitcode = EXIT_SUCCESS;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	bench_result_t *results = NULL;
+	FILE *fp = stdout;
+
+	// Default option values.
+	unsigned int help = 0;
+	const char *filename = NULL;
+	unsigned int count = 1;
+
+	// Parse the command-line options.
+	int opt = 0;
+	const char *optstring = "ho:n:";
+#ifdef HAVE_GETOPT_LONG
+	struct option options[] = {
+		{"help",        no_argument,       0, 'h'},
+		{"output",      required_argument, 0, 'o'},
+		{"count",       required_argument, 0, 'n'},
+		{0,             0,                 0,  0 }
+	};
+	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
+#else
+	while ((opt = getopt (argc, argv, optstring)) != -1) {
+#endif
+		switch (opt) {
+		case 'h':
+			help = 1;
+			break;
+		case 'o':
+			filename = optarg;
+			break;
+		case 'n':
+			count = strtoul (optarg, NULL, 0);
+			break;
+		default:
+			return EXIT_FAILURE;
+		}
+	}
+
+	argc -= optind;
+	argv += optind;
+
+	// Show help message.
+	if (help) {
+		dctool_command_showhelp (&dctool_bench);
+		return EXIT_SUCCESS;
+	}
+
+	if (count == 0)
+		count = 1;
+
+	results = (bench_result_t *) calloc (count, sizeof (bench_result_t));
+	if (results == NULL) {
+		message ("Out of memory.\n");
+		exitcode = EXIT_FAILURE;
+		goto cleanup;
+	}
+
+	// Reuse the same parser for all dives.
+	dc_context_set_parserpool (context, 1);
+
+	// Run the benchmark.
+	unsigned int n = 0;
+	while (n < count) {
+		status = bench (context, descriptor, argv[0], results + n);
+		n++;
+		if (status != DC_STATUS_SUCCESS) {
+			message ("ERROR: %s\n", dctool_errmsg (status));
+			exitcode = EXIT_FAILURE;
+			break;
+		}
+	}
+
+	dc_context_set_parserpool (context, 0);
+
+	// Write the results.
+	if (filename) {
+		fp = fopen (filename, "w");
+		if (fp == NULL) {
+			message ("Failed to open the output file.\n");
+			exitcode = EXIT_FAILURE;
+			goto cleanup;
+		}
+	}
+
+	bench_print (fp, descriptor, results, n);
+
+	if (fp != stdout)
+		fclose (fp);
+
+cleanup:
+	free (results);
+	return exitcode;
+}
+
+const dctool_command_t dctool_bench = {
+	dctool_bench_run,
+	DCTOOL_CONFIG_DESCRIPTOR,
+	"bench",
+	"Benchmark the download of the dives",
+	"Usage:\n"
+	"   dctool bench [options] <devname>\n"
+	"\n"
+	"Options:\n"
+#ifdef HAVE_GETOPT_LONG
+	"   -h, --help                 Show help message\n"
+	"   -o, --output <filename>    Output filename\n"
+	"   -n, --count <count>        Number of runs\n"
+#else
+	"   -h                 Show help message\n"
+	"   -o <filename>      Output filename\n"
+	"   -n <count>         Number of runs\n"
+#endif
+	"\n"
+	"The dives are downloaded and parsed, and the timing results are\n"
+	"written in JSON format. Combined with the --replay option, the\n"
+	"download runs against a recorded trace instead of the hardware.\n"
+	"With a replay speed of 0, the transfer time then only contains the\n"
+	"processing in the library. For example, for the Shearwater Petrel\n"
+	"and Perdix families, which download compressed dives, it measures\n"
+	"the LRE decompression and XOR decoding:\n"
+	"\n"
+	"   dctool -f petrel -r petrel.trace bench <devname>\n"
+	"   dctool -f petrel -p petrel.trace -s 0 bench -n 10 <devname>\n"
+	"\n"
+	"Reported figures (times in seconds):\n"
+	"\n"
+	"   open         Time to open the device, including the handshake\n"
+	"   firstdive    Time until the first dive is available\n"
+	"   transfer     Time spent in the download, excluding parsing\n"
+	"   parse        Time spent parsing the dives\n"
+	"   throughput   Transfer rate of the dive data (bytes/s)\n"
+};
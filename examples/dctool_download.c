@@ -179,7 +179,7 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, const char *devnam
 
 	// Register the event handler.
 	message ("Registering the event handler.\n");
-	int events = DC_EVENT_WAITING | DC_EVENT_PROGRESS | DC_EVENT_DEVINFO | DC_EVENT_CLOCK | DC_EVENT_VENDOR;
+	int events = DC_EVENT_WAITING | DC_EVENT_PROGRESS | DC_EVENT_DEVINFO | DC_EVENT_CLOCK | DC_EVENT_VENDOR | DC_EVENT_STATS;
 	rc = dc_device_set_events (device, events, event_cb, &eventdata);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error registering the event handler.");
@@ -211,6 +211,9 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, const char *devnam
 	divedata.number = 0;
 	divedata.output = output;
 
+	// Reuse the same parser for all dives.
+	dc_context_set_parserpool (context, 1);
+
 	// Download the dives.
 	message ("Downloading the dives.\n");
 	rc = dc_device_foreach (device, dive_cb, &divedata);
@@ -234,6 +237,7 @@ download (dc_context_t *context, dc_descriptor_t *descriptor, const char *devnam
 	}
 
 cleanup:
+	dc_context_set_parserpool (context, 0);
 	dc_buffer_free (ofingerprint);
 	dc_device_close (device);
 	return rc;
@@ -40,7 +40,7 @@
 #include "utils.h"
 
 static dc_status_t
-dump (dc_context_t *context, dc_descriptor_t *descriptor, const char *devname, dc_buffer_t *fingerprint, dc_buffer_t *buffer)
+dump (dc_context_t *context, dc_descriptor_t *descriptor, const char *devname, dc_buffer_t *fingerprint, dc_buffer_t *previous, dc_buffer_t *buffer)
 {
 	dc_status_t rc = DC_STATUS_SUCCESS;
 	dc_device_t *device = NULL;
@@ -58,7 +58,7 @@ dump (dc_context_t *context, dc_descriptor_t *descriptor, const char *devname, d
 
 	// Register the event handler.
 	message ("Registering the event handler.\n");
-	int events = DC_EVENT_WAITING | DC_EVENT_PROGRESS | DC_EVENT_DEVINFO | DC_EVENT_CLOCK | DC_EVENT_VENDOR;
+	int events = DC_EVENT_WAITING | DC_EVENT_PROGRESS | DC_EVENT_DEVINFO | DC_EVENT_CLOCK | DC_EVENT_VENDOR | DC_EVENT_STATS;
 	rc = dc_device_set_events (device, events, dctool_event_cb, NULL);
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error registering the event handler.");
@@ -85,7 +85,11 @@ dump (dc_context_t *context, dc_descriptor_t *descriptor, const char *devname, d
 
 	// Download the memory dump.
 	message ("Downloading the memory dump.\n");
-	rc = dc_device_dump (device, buffer);
+	if (previous) {
+		rc = dc_device_dump_incremental (device, previous, buffer);
+	} else {
+		rc = dc_device_dump (device, buffer);
+	}
 	if (rc != DC_STATUS_SUCCESS) {
 		ERROR ("Error downloading the memory dump.");
 		goto cleanup;
@@ -102,21 +106,24 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	int exitcode = EXIT_SUCCESS;
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_buffer_t *fingerprint = NULL;
+	dc_buffer_t *previous = NULL;
 	dc_buffer_t *buffer = NULL;
 
 	// Default option values.
 	unsigned int help = 0;
 	const char *fphex = NULL;
 	const char *filename = NULL;
+	const char *incremental = NULL;
 
 	// Parse the command-line options.
 	int opt = 0;
-	const char *optstring = "ho:p:";
+	const char *optstring = "ho:p:i:";
 #ifdef HAVE_GETOPT_LONG
 	struct option options[] = {
 		{"help",        no_argument,       0, 'h'},
 		{"output",      required_argument, 0, 'o'},
 		{"fingerprint", required_argument, 0, 'p'},
+		{"incremental", required_argument, 0, 'i'},
 		{0,             0,                 0,  0 }
 	};
 	while ((opt = getopt_long (argc, argv, optstring, options, NULL)) != -1) {
@@ -133,6 +140,9 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 		case 'p':
 			fphex = optarg;
 			break;
+		case 'i':
+			incremental = optarg;
+			break;
 		default:
 			return EXIT_FAILURE;
 		}
@@ -150,11 +160,21 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 	// Convert the fingerprint to binary.
 	fingerprint = dctool_convert_hex2bin (fphex);
 
+	// Read the previous memory dump.
+	if (incremental) {
+		previous = dctool_file_read (incremental);
+		if (previous == NULL) {
+			message ("ERROR: Failed to read the previous memory dump.\n");
+			exitcode = EXIT_FAILURE;
+			goto cleanup;
+		}
+	}
+
 	// Allocate a memory buffer.
 	buffer = dc_buffer_new (0);
 
 	// Download the memory dump.
-	status = dump (context, descriptor, argv[0], fingerprint, buffer);
+	status = dump (context, descriptor, argv[0], fingerprint, previous, buffer);
 	if (status != DC_STATUS_SUCCESS) {
 		message ("ERROR: %s\n", dctool_errmsg (status));
 		exitcode = EXIT_FAILURE;
@@ -166,6 +186,7 @@ dctool_dump_run (int argc, char *argv[], dc_context_t *context, dc_descriptor_t
 
 cleanup:
 	dc_buffer_free (buffer);
+	dc_buffer_free (previous);
 	dc_buffer_free (fingerprint);
 	return exitcode;
 }
@@ -183,9 +204,11 @@ const dctool_command_t dctool_dump = {
 	"   -h, --help                 Show help message\n"
 	"   -o, --output <filename>    Output filename\n"
 	"   -p, --fingerprint <data>   Fingerprint data (hexadecimal)\n"
+	"   -i, --incremental <file>   Previous memory dump\n"
 #else
 	"   -h                 Show help message\n"
 	"   -o <filename>      Output filename\n"
 	"   -p <fingerprint>   Fingerprint data (hexadecimal)\n"
+	"   -i <filename>      Previous memory dump\n"
 #endif
 };
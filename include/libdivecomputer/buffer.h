@@ -24,6 +24,8 @@
 
 #include <stddef.h>
 
+#include "context.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif /* __cplusplus */
@@ -33,6 +35,15 @@ typedef struct dc_buffer_t dc_buffer_t;
 dc_buffer_t *
 dc_buffer_new (size_t capacity);
 
+/*
+ * Create a new buffer that allocates its memory through the allocator
+ * of the context (see #dc_context_set_allocator). The views of the
+ * buffer use the same allocator. The buffer must be freed before the
+ * context.
+ */
+dc_buffer_t *
+dc_buffer_new2 (dc_context_t *context, size_t capacity);
+
 void
 dc_buffer_free (dc_buffer_t *buffer);
 
@@ -48,12 +59,36 @@ dc_buffer_resize (dc_buffer_t *buffer, size_t size);
 int
 dc_buffer_append (dc_buffer_t *buffer, const unsigned char data[], size_t size);
 
+/*
+ * Grow the buffer with size bytes, and return a pointer to the new
+ * (uninitialized) bytes, such that the caller can write the data in
+ * place. Returns NULL on failure.
+ */
+unsigned char *
+dc_buffer_append_uninit (dc_buffer_t *buffer, size_t size);
+
 int
 dc_buffer_prepend (dc_buffer_t *buffer, const unsigned char data[], size_t size);
 
 int
 dc_buffer_slice (dc_buffer_t *buffer, size_t offset, size_t size);
 
+/*
+ * Create a new buffer that refers to a range of the data of an existing
+ * buffer, without copying the data. The data is reference counted, and
+ * remains valid until both buffers are freed. Modifying either buffer
+ * with one of the dc_buffer functions gives it a private copy first.
+ * The data must not be modified through the dc_buffer_get_data pointer
+ * while it is shared.
+ *
+ * The reference count is not thread-safe. A buffer and all of its views
+ * must be used from a single thread at a time, including the calls to
+ * dc_buffer_free. To hand the data to another thread, pass a copy
+ * instead of a view.
+ */
+dc_buffer_t *
+dc_buffer_view (dc_buffer_t *buffer, size_t offset, size_t size);
+
 size_t
 dc_buffer_get_size (dc_buffer_t *buffer);
 
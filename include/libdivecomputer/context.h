@@ -22,6 +22,8 @@
 #ifndef DC_CONTEXT_H
 #define DC_CONTEXT_H
 
+#include <stddef.h>
+
 #include "common.h"
 
 #ifdef __cplusplus
@@ -41,6 +43,18 @@ typedef enum dc_loglevel_t {
 
 typedef void (*dc_logfunc_t) (dc_context_t *context, dc_loglevel_t loglevel, const char *file, unsigned int line, const char *function, const char *message, void *userdata);
 
+typedef struct dc_allocator_t {
+	void *(*allocate) (size_t size, void *userdata);
+	void *(*reallocate) (void *ptr, size_t size, void *userdata);
+	void (*deallocate) (void *ptr, void *userdata);
+} dc_allocator_t;
+
+typedef enum dc_trace_mode_t {
+	DC_TRACE_NONE,
+	DC_TRACE_RECORD,
+	DC_TRACE_REPLAY
+} dc_trace_mode_t;
+
 dc_status_t
 dc_context_new (dc_context_t **context);
 
@@ -50,9 +64,66 @@ dc_context_free (dc_context_t *context);
 dc_status_t
 dc_context_set_loglevel (dc_context_t *context, dc_loglevel_t loglevel);
 
+/*
+ * A context can be used from multiple threads at once, for example
+ * with dc_parser_batch. The log function is never invoked concurrently,
+ * and may be called from any of those threads. It must not log through
+ * the same context. The configuration functions must not be called
+ * while other threads use the context.
+ */
 dc_status_t
 dc_context_set_logfunc (dc_context_t *context, dc_logfunc_t logfunc, void *userdata);
 
+/*
+ * Route the memory allocations of the objects created with the context
+ * through a custom allocator. The allocator is copied, and a NULL
+ * allocator restores the standard C library functions. The allocator
+ * can only be changed while no objects are alive, and before any pacing
+ * or shared data has been stored in the context.
+ */
+dc_status_t
+dc_context_set_allocator (dc_context_t *context, const dc_allocator_t *allocator, void *userdata);
+
+/*
+ * Keep up to size unused parsers in the context. A parser that is
+ * destroyed is returned to the pool, and handed out again by the next
+ * dc_parser_new or dc_parser_new2 call with the same family, model and
+ * clock. All parsers must be destroyed before the context is freed. A
+ * size of zero (the default) disables the pool.
+ */
+dc_status_t
+dc_context_set_parserpool (dc_context_t *context, unsigned int size);
+
+/*
+ * Record all traffic of the serial and USB HID I/O streams opened with
+ * the context to a trace file, or replay a previously recorded trace
+ * file instead of talking to the hardware. During replay, the recorded
+ * duration of every operation is divided by speed, and a speed of zero
+ * replays without any delays. The DC_TRACE_NONE mode (the default)
+ * disables tracing, and only affects I/O streams opened afterwards.
+ *
+ * Every I/O stream gets its own trace file, numbered in the order the
+ * streams are opened: the first stream uses the filename as is, the
+ * next ones append ".1", ".2" and so on. Replay opens the files in the
+ * same order. Once all files have been replayed, replay starts again
+ * with the first file, so a trace of a single stream can be replayed
+ * repeatedly.
+ */
+dc_status_t
+dc_context_set_trace (dc_context_t *context, dc_trace_mode_t mode, const char *filename, unsigned int speed);
+
+/*
+ * Keep a copy of the memory of the devices opened with the context in
+ * the given directory. Backends that download the entire memory can
+ * re-use the unchanged pages during the next session, and only read
+ * the parts that may have changed from the device. Backends that adapt
+ * the communication to the device also keep the learned parameters
+ * there, so the next session starts with them. A NULL directory (the
+ * default) disables the cache.
+ */
+dc_status_t
+dc_context_set_cache (dc_context_t *context, const char *directory);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
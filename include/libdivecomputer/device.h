@@ -37,7 +37,8 @@ typedef enum dc_event_type_t {
 	DC_EVENT_PROGRESS = (1 << 1),
 	DC_EVENT_DEVINFO = (1 << 2),
 	DC_EVENT_CLOCK = (1 << 3),
-	DC_EVENT_VENDOR = (1 << 4)
+	DC_EVENT_VENDOR = (1 << 4),
+	DC_EVENT_STATS = (1 << 5)
 } dc_event_type_t;
 
 typedef struct dc_device_t dc_device_t;
@@ -63,6 +64,21 @@ typedef struct dc_event_vendor_t {
 	unsigned int size;
 } dc_event_vendor_t;
 
+/*
+ * Transfer statistics. The byte counts and the number of read and write
+ * calls are collected on the I/O stream, and therefore do not match the
+ * protocol packets of the backend. The sleep time is in milliseconds.
+ */
+typedef struct dc_event_stats_t {
+	unsigned int nread;
+	unsigned int nwritten;
+	unsigned int ncalls;
+	unsigned int nretries;
+	unsigned int nchecksums;
+	unsigned int nnaks;
+	unsigned int sleeptime;
+} dc_event_stats_t;
+
 typedef int (*dc_cancel_callback_t) (void *userdata);
 
 typedef void (*dc_event_callback_t) (dc_device_t *device, dc_event_type_t event, const void *data, void *userdata);
@@ -81,6 +97,9 @@ dc_device_set_cancel (dc_device_t *device, dc_cancel_callback_t callback, void *
 dc_status_t
 dc_device_set_events (dc_device_t *device, unsigned int events, dc_event_callback_t callback, void *userdata);
 
+dc_status_t
+dc_device_get_stats (dc_device_t *device, dc_event_stats_t *stats);
+
 dc_status_t
 dc_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size);
 
@@ -93,6 +112,15 @@ dc_device_write (dc_device_t *device, unsigned int address, const unsigned char
 dc_status_t
 dc_device_dump (dc_device_t *device, dc_buffer_t *buffer);
 
+/*
+ * Download a memory dump, using a previous memory dump of the same
+ * device to avoid reading the parts of the memory that did not change.
+ * The result is always a complete memory dump. Backends without
+ * support for incremental downloads simply read the entire memory.
+ */
+dc_status_t
+dc_device_dump_incremental (dc_device_t *device, dc_buffer_t *previous, dc_buffer_t *buffer);
+
 dc_status_t
 dc_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
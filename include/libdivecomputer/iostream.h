@@ -82,6 +82,16 @@ typedef enum dc_line_t {
 	DC_LINE_RNG = 0x08, /**< Ring indicator */
 } dc_line_t;
 
+/**
+ * Completion callback for an asynchronous transfer.
+ *
+ * @param[in]  iostream  The I/O stream.
+ * @param[in]  status    The result of the transfer.
+ * @param[in]  actual    The actual number of bytes transferred.
+ * @param[in]  userdata  The user data passed when starting the transfer.
+ */
+typedef void (*dc_iostream_callback_t) (dc_iostream_t *iostream, dc_status_t status, size_t actual, void *userdata);
+
 /**
  * Set the read timeout.
  *
@@ -197,6 +207,22 @@ dc_iostream_get_lines (dc_iostream_t *iostream, unsigned int *value);
 dc_status_t
 dc_iostream_get_available (dc_iostream_t *iostream, size_t *value);
 
+/**
+ * Get the native handle of the I/O stream.
+ *
+ * The handle is a file descriptor that can be added to an external event
+ * loop (select, poll, epoll, ...) to wait for incoming data. It remains
+ * owned by the I/O stream and must not be closed by the caller.
+ *
+ * @param[in]   iostream  A valid I/O stream.
+ * @param[out]  value     A location to store the native handle.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if the
+ * I/O stream has no pollable handle, or another #dc_status_t code on
+ * failure.
+ */
+dc_status_t
+dc_iostream_get_handle (dc_iostream_t *iostream, int *value);
+
 /**
  * Configure the line settings.
  *
@@ -240,6 +266,71 @@ dc_iostream_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actu
 dc_status_t
 dc_iostream_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
 
+/**
+ * Start an asynchronous read from the I/O stream.
+ *
+ * The read never blocks. Whatever data is already available is consumed
+ * immediately, and the remainder is picked up by subsequent calls to
+ * #dc_iostream_process, typically after the native handle became
+ * readable. Once the requested number of bytes has been received, or an
+ * error occurred, the callback is invoked exactly once. The memory buffer
+ * must remain valid until then. Only one read can be pending at a time.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @param[out] data      The memory buffer to read the data into.
+ * @param[in]  size      The number of bytes to read.
+ * @param[in]  callback  The completion callback.
+ * @param[in]  userdata  User data passed to the callback.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure. On failure, the callback is not invoked.
+ */
+dc_status_t
+dc_iostream_read_async (dc_iostream_t *iostream, void *data, size_t size, dc_iostream_callback_t callback, void *userdata);
+
+/**
+ * Write data to the I/O stream, with a completion callback.
+ *
+ * Despite the name, the write is synchronous. It is a blocking
+ * #dc_iostream_write, which can take up to the timeout of the stream,
+ * and the callback is invoked before this function returns. It only
+ * offers the same callback style as #dc_iostream_read_async, for code
+ * that drives the reads asynchronously. Outgoing packets are small, so
+ * the write normally completes without waiting.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @param[in]  data      The memory buffer to write the data from.
+ * @param[in]  size      The number of bytes to write.
+ * @param[in]  callback  The completion callback.
+ * @param[in]  userdata  User data passed to the callback.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure. On failure, the callback is not invoked.
+ */
+dc_status_t
+dc_iostream_write_async (dc_iostream_t *iostream, const void *data, size_t size, dc_iostream_callback_t callback, void *userdata);
+
+/**
+ * Make progress on the pending asynchronous read, without blocking.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_iostream_process (dc_iostream_t *iostream);
+
+/**
+ * Cancel the pending asynchronous read.
+ *
+ * The callback is invoked with #DC_STATUS_CANCELLED and the number of
+ * bytes received so far.
+ *
+ * @param[in]  iostream  A valid I/O stream.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_iostream_cancel (dc_iostream_t *iostream);
+
 /**
  * Flush the internal output buffer and wait until the data has been
  * transmitted.
@@ -27,6 +27,7 @@
 #include "descriptor.h"
 #include "device.h"
 #include "datetime.h"
+#include "iterator.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -219,10 +220,168 @@ typedef union dc_sample_value_t {
 	unsigned int gasmix; /* Gas mix index */
 } dc_sample_value_t;
 
+#define DC_SAMPLE_MAXTANKS   8
+#define DC_SAMPLE_MAXEVENTS  8
+#define DC_SAMPLE_MAXSENSORS 4
+
+/*
+ * Assembled sample
+ *
+ * All the values reported between two consecutive DC_SAMPLE_TIME
+ * values are collected into a single record. The fields member is a
+ * bitmap with a (1 << type) bit set for each dc_sample_type_t present
+ * in the sample. Values that are not present are zero. Values that can
+ * appear multiple times in a single sample (tank pressures, events and
+ * ppO2 sensors) are stored as an array with a counter. For all other
+ * types, the last reported value wins. The vendor data points into the
+ * dive data, and remains valid as long as that data is valid.
+ */
+typedef struct dc_sample_t {
+	unsigned int fields;
+	unsigned int time;
+	double depth;
+	unsigned int npressures;
+	struct {
+		unsigned int tank;
+		double value;
+	} pressure[DC_SAMPLE_MAXTANKS];
+	double temperature;
+	unsigned int nevents;
+	struct {
+		unsigned int type;
+		unsigned int time;
+		unsigned int flags;
+		unsigned int value;
+	} event[DC_SAMPLE_MAXEVENTS];
+	unsigned int rbt;
+	unsigned int heartbeat;
+	unsigned int bearing;
+	struct {
+		unsigned int type;
+		unsigned int size;
+		const void *data;
+	} vendor;
+	double setpoint;
+	unsigned int nppo2;
+	double ppo2[DC_SAMPLE_MAXSENSORS];
+	double cns;
+	struct {
+		unsigned int type;
+		unsigned int time;
+		double depth;
+	} deco;
+	unsigned int gasmix; /* Gas mix index */
+} dc_sample_t;
+
+/*
+ * Sample columns
+ *
+ * Caller-owned structure-of-arrays buffers, filled in with one row per
+ * sample. Each column has room for capacity rows, except for the
+ * pressure column, which contains ntanks consecutive columns (the
+ * pressure of tank i in row j is stored at index i * capacity + j).
+ * Columns that are not needed can be set to NULL. Values that are not
+ * present in a sample are set to NAN (floating point columns) or zero
+ * (integer columns), and the fields column contains the same bitmap as
+ * the dc_sample_t structure. For the ppo2 column, the values of
+ * multiple sensors are averaged.
+ *
+ * The count member is always set to the total number of samples in the
+ * profile. If that exceeds the capacity, only the first capacity rows
+ * are filled in, and the call still succeeds: the caller detects this
+ * by comparing the count with the capacity. Thus a call with a zero
+ * capacity returns the required capacity, and a single allocation can
+ * be reused for many dives. DC_STATUS_NOMEMORY is only returned when
+ * the library fails to allocate memory.
+ */
+typedef struct dc_sample_columns_t {
+	unsigned int capacity;
+	unsigned int ntanks;
+	unsigned int count;
+	unsigned int *fields;
+	unsigned int *time;
+	double *depth;
+	double *temperature;
+	double *pressure;
+	double *ppo2;
+	double *cns;
+	unsigned int *deco_type;
+	unsigned int *deco_time;
+	double *deco_depth;
+} dc_sample_columns_t;
+
+#define DC_STATISTICS_MAXTHRESHOLDS 4
+#define DC_STATISTICS_NASCENTRATES  8
+#define DC_STATISTICS_ASCENTRATE    3.0 /* Width of a histogram bin (meter/minute) */
+
+/*
+ * Dive statistics
+ *
+ * Statistics calculated from the samples, in a single pass over the
+ * profile. The depth thresholds (in meter) are the only input, and
+ * need to be filled in by the caller. The time spent below each of the
+ * thresholds is returned in the below array (time above equals the dive
+ * time minus the time below). The average depth is time-weighted.
+ *
+ * The ascent rate histogram contains the time spent ascending in each
+ * bin, where bin i covers the rates from i * DC_STATISTICS_ASCENTRATE
+ * up to (i + 1) * DC_STATISTICS_ASCENTRATE meter per minute. The last
+ * bin also contains all faster ascents.
+ *
+ * The surface temperature is the first temperature in the profile.
+ * Temperatures and pressures that are not available are set to NAN. The
+ * surface air consumption (in liter per minute) is only available for
+ * tanks with a known volume, and for imperial tanks also a known working
+ * pressure.
+ */
+typedef struct dc_statistics_t {
+	unsigned int nthresholds;
+	double threshold[DC_STATISTICS_MAXTHRESHOLDS];
+	unsigned int nsamples;
+	unsigned int divetime;
+	double maxdepth;
+	double avgdepth;
+	double temperature_surface;
+	double temperature_minimum;
+	double temperature_maximum;
+	unsigned int ntanks;
+	struct {
+		double beginpressure;
+		double endpressure;
+		double sac;
+	} tank[DC_SAMPLE_MAXTANKS];
+	unsigned int ascentrate[DC_STATISTICS_NASCENTRATES];
+	unsigned int below[DC_STATISTICS_MAXTHRESHOLDS];
+} dc_statistics_t;
+
 typedef struct dc_parser_t dc_parser_t;
 
 typedef void (*dc_sample_callback_t) (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
 
+/*
+ * Batch entry
+ *
+ * A dive to parse with dc_parser_batch. The parser is created with the
+ * descriptor and clock, in the same way as with dc_parser_new2, and the
+ * data must remain valid until dc_parser_batch returns.
+ */
+typedef struct dc_parser_batch_entry_t {
+	dc_descriptor_t *descriptor;
+	unsigned int devtime;
+	dc_ticks_t systime;
+	const unsigned char *data;
+	unsigned int size;
+} dc_parser_batch_entry_t;
+
+/*
+ * Batch callback, invoked once for every entry, with the index of the
+ * entry in the input array. On success, the parser contains the data of
+ * the entry. Otherwise the status contains the error, and the parser is
+ * NULL if it couldn't be created. The parser is owned by the batch, and
+ * is only valid during the callback.
+ */
+typedef void (*dc_parser_batch_callback_t) (dc_parser_t *parser, dc_status_t status, unsigned int index, void *userdata);
+
 dc_status_t
 dc_parser_new (dc_parser_t **parser, dc_device_t *device);
 
@@ -235,15 +394,78 @@ dc_parser_get_type (dc_parser_t *parser);
 dc_status_t
 dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int size);
 
+/*
+ * Release the dive data and the cached values, such that the parser can
+ * be reused for another dive with dc_parser_set_data.
+ */
+dc_status_t
+dc_parser_reset (dc_parser_t *parser);
+
 dc_status_t
 dc_parser_get_datetime (dc_parser_t *parser, dc_datetime_t *datetime);
 
+/*
+ * The field values are cached until the next dc_parser_set_data call.
+ */
 dc_status_t
 dc_parser_get_field (dc_parser_t *parser, dc_field_type_t type, unsigned int flags, void *value);
 
+/*
+ * Same as dc_parser_get_field, but when the dive computer doesn't store
+ * the dive time, the maximum or average depth, or the minimum or maximum
+ * temperature, the value is derived from the samples instead of
+ * returning DC_STATUS_UNSUPPORTED. All of these share a single pass over
+ * the profile, which is also used by dc_parser_get_statistics.
+ */
+dc_status_t
+dc_parser_get_field_derived (dc_parser_t *parser, dc_field_type_t type, unsigned int flags, void *value);
+
 dc_status_t
 dc_parser_samples_foreach (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata);
 
+/*
+ * Create an iterator that returns one assembled dc_sample_t per call to
+ * dc_iterator_next. Backends with a resumable sample decoder decode the
+ * samples on demand, and report errors in the profile data from
+ * dc_iterator_next. For the other backends, the entire profile is
+ * decoded when the iterator is created. The iterator must be freed
+ * before the parser is destroyed or receives new data.
+ */
+dc_status_t
+dc_parser_samples_iterator (dc_iterator_t **iterator, dc_parser_t *parser);
+
+dc_status_t
+dc_parser_samples_get_columns (dc_parser_t *parser, dc_sample_columns_t *columns);
+
+dc_status_t
+dc_parser_get_statistics (dc_parser_t *parser, dc_statistics_t *statistics);
+
+/*
+ * Parse many dives at once, with nthreads worker threads. The worker
+ * threads create the parsers and set their data, a few entries ahead of
+ * the callback.
+ *
+ * The callback is invoked on the calling thread, once for every entry,
+ * in input order. It doesn't need to be thread-safe, and may use the
+ * parser with any of the parser functions. The parsers are destroyed
+ * after the callback, so enabling the parser pool of the context (see
+ * #dc_context_set_parserpool) allows them to be reused.
+ *
+ * The context can be shared by the worker threads: the log function is
+ * never invoked concurrently, and the parser pool and the data shared
+ * between the parsers are protected by the context. A custom allocator
+ * must be thread-safe. The descriptors are read-only, and can be used
+ * from any thread. The context must not be reconfigured while the batch
+ * is running.
+ *
+ * If threads are not available, or nthreads is one, all entries are
+ * parsed on the calling thread. The return value only reports errors
+ * with the batch itself. The errors of the individual entries are
+ * passed to the callback.
+ */
+dc_status_t
+dc_parser_batch (dc_context_t *context, const dc_parser_batch_entry_t entries[], unsigned int count, unsigned int nthreads, dc_parser_batch_callback_t callback, void *userdata);
+
 dc_status_t
 dc_parser_destroy (dc_parser_t *parser);
 
@@ -0,0 +1,143 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_SESSION_H
+#define DC_SESSION_H
+
+#include "common.h"
+#include "context.h"
+#include "device.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Opaque object representing a session manager.
+ *
+ * A session manager downloads the dives from many devices at once.
+ * Devices that support resumable downloads (currently the Suunto D9
+ * and Vyper2 families), on an I/O stream with a pollable handle, are
+ * driven by a single event loop. The event loop runs on the thread
+ * that calls #dc_session_manager_wait. All other devices are
+ * downloaded on a fixed number of worker threads. Downloads that do
+ * not fit into the pool are queued, and started as soon as a worker
+ * thread becomes available.
+ */
+typedef struct dc_session_manager_t dc_session_manager_t;
+
+/**
+ * Completion callback, invoked on the worker thread or the thread
+ * running the event loop, once the download of a device has finished.
+ *
+ * @param[in]  device    The device.
+ * @param[in]  status    The result of the download.
+ * @param[in]  userdata  The user data passed to #dc_session_manager_add.
+ */
+typedef void (*dc_session_callback_t) (dc_device_t *device, dc_status_t status, void *userdata);
+
+/**
+ * Create a new session manager.
+ *
+ * @param[out]  manager   A location to store the session manager.
+ * @param[in]   context   A valid context object.
+ * @param[in]   nworkers  The number of worker threads. With zero
+ *                        worker threads, only the devices that support
+ *                        resumable downloads can be added.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if
+ * worker threads are requested but threads are not available, or
+ * another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_session_manager_new (dc_session_manager_t **manager, dc_context_t *context, unsigned int nworkers);
+
+/**
+ * Queue the download of all dives from a device.
+ *
+ * The session manager installs its own cancel callback on the device.
+ * A resumable download is started by #dc_session_manager_wait, and all
+ * its callbacks are invoked on that thread. Other downloads run on a
+ * worker thread. The event and dive callbacks therefore need proper
+ * locking when they share data with other threads. The log function of
+ * the context is never invoked concurrently. The device must remain
+ * open until the completion callback has been invoked.
+ *
+ * This function must not be called from another thread while
+ * #dc_session_manager_wait is running, but it can be called from the
+ * callbacks of a download.
+ *
+ * @param[in]  manager   A valid session manager.
+ * @param[in]  device    A valid device object.
+ * @param[in]  callback  The dive callback, see #dc_device_foreach.
+ * @param[in]  complete  The (optional) completion callback.
+ * @param[in]  userdata  User data passed to both callbacks.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if
+ * the device needs a worker thread and there are none, or another
+ * #dc_status_t code on failure.
+ */
+dc_status_t
+dc_session_manager_add (dc_session_manager_t *manager, dc_device_t *device, dc_dive_callback_t callback, dc_session_callback_t complete, void *userdata);
+
+/**
+ * Run the event loop for the resumable downloads, and wait until all
+ * queued downloads have finished.
+ *
+ * A pending cancellation is cleared once all downloads have finished,
+ * and the downloads queued afterwards run normally.
+ *
+ * @param[in]  manager   A valid session manager.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_session_manager_wait (dc_session_manager_t *manager);
+
+/**
+ * Cancel all running and queued downloads.
+ *
+ * Running downloads are aborted at the next cancellation point of the
+ * backend. The event loop checks for a cancellation at least every
+ * 100 milliseconds. This function can be called from any thread.
+ * Downloads that have not started yet complete immediately with
+ * #DC_STATUS_CANCELLED. The cancellation remains in effect, also
+ * for downloads queued later, until #dc_session_manager_wait returns.
+ *
+ * @param[in]  manager   A valid session manager.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_session_manager_cancel (dc_session_manager_t *manager);
+
+/**
+ * Wait for all downloads and free the session manager.
+ *
+ * @param[in]  manager   A valid session manager.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_session_manager_free (dc_session_manager_t *manager);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_SESSION_H */
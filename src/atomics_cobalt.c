@@ -75,6 +75,7 @@ static const dc_device_vtable_t atomics_cobalt_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	atomics_cobalt_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	atomics_cobalt_device_close /* close */
 };
@@ -236,6 +237,7 @@ atomics_cobalt_device_version (dc_device_t *abstract, unsigned char data[], unsi
 	unsigned short ccrc = checksum_add_uint16 (packet, SZ_VERSION, 0x0);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -332,6 +334,7 @@ atomics_cobalt_read_dive (dc_device_t *abstract, dc_buffer_t *buffer, int init,
 	unsigned short ccrc = checksum_add_uint16 (data, nbytes - 2, 0x0);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -374,7 +377,7 @@ atomics_cobalt_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
 
 	// Allocate a memory buffer.
-	dc_buffer_t *buffer = dc_buffer_new (0);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, 0);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
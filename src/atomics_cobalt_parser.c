@@ -56,6 +56,8 @@ static const dc_parser_vtable_t atomics_cobalt_parser_vtable = {
 	atomics_cobalt_parser_get_datetime, /* datetime */
 	atomics_cobalt_parser_get_field, /* fields */
 	atomics_cobalt_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -103,6 +105,12 @@ atomics_cobalt_parser_set_calibration (dc_parser_t *abstract, double atmospheric
 	parser->atmospheric = atmospheric;
 	parser->hydrostatic = hydrostatic;
 
+	// Discard the cached field values.
+	dc_parser_invalidate (abstract);
+
+	// A calibrated parser no longer matches its pool key.
+	abstract->reusable = 0;
+
 	return DC_STATUS_SUCCESS;
 }
 
@@ -19,51 +19,108 @@
  * MA 02110-1301 USA
  */
 
-#include <stdlib.h> // malloc, realloc, free
 #include <string.h> // memcpy, memmove
 
 #include <libdivecomputer/buffer.h>
 
+#include "context-private.h"
+
 struct dc_buffer_t {
+	dc_context_t *context;
 	unsigned char *data;
 	size_t capacity, offset, size;
+	// Reference count of the data, shared between a buffer and its
+	// views. Only allocated once the data is shared.
+	size_t *refcount;
 };
 
 dc_buffer_t *
 dc_buffer_new (size_t capacity)
 {
-	dc_buffer_t *buffer = (dc_buffer_t *) malloc (sizeof (dc_buffer_t));
+	return dc_buffer_new2 (NULL, capacity);
+}
+
+
+dc_buffer_t *
+dc_buffer_new2 (dc_context_t *context, size_t capacity)
+{
+	dc_buffer_t *buffer = (dc_buffer_t *) dc_context_allocate (context, sizeof (dc_buffer_t));
 	if (buffer == NULL)
 		return NULL;
 
 	if (capacity) {
-		buffer->data = (unsigned char *) malloc (capacity);
+		buffer->data = (unsigned char *) dc_context_allocate (context, capacity);
 		if (buffer->data == NULL) {
-			free (buffer);
+			dc_context_deallocate (context, buffer);
 			return NULL;
 		}
 	} else {
 		buffer->data = NULL;
 	}
 
+	buffer->context = context;
 	buffer->capacity = capacity;
 	buffer->offset = 0;
 	buffer->size = 0;
+	buffer->refcount = NULL;
 
 	return buffer;
 }
 
 
+dc_buffer_t *
+dc_buffer_view (dc_buffer_t *buffer, size_t offset, size_t size)
+{
+	if (buffer == NULL)
+		return NULL;
+
+	if (offset > buffer->size || size > buffer->size - offset)
+		return NULL;
+
+	dc_buffer_t *view = (dc_buffer_t *) dc_context_allocate (buffer->context, sizeof (dc_buffer_t));
+	if (view == NULL)
+		return NULL;
+
+	// Start sharing the data.
+	if (buffer->refcount == NULL) {
+		buffer->refcount = (size_t *) dc_context_allocate (buffer->context, sizeof (size_t));
+		if (buffer->refcount == NULL) {
+			dc_context_deallocate (buffer->context, view);
+			return NULL;
+		}
+		*buffer->refcount = 1;
+	}
+
+	(*buffer->refcount)++;
+
+	view->context = buffer->context;
+	view->data = buffer->data;
+	view->capacity = buffer->capacity;
+	view->offset = buffer->offset + offset;
+	view->size = size;
+	view->refcount = buffer->refcount;
+
+	return view;
+}
+
+
 void
 dc_buffer_free (dc_buffer_t *buffer)
 {
 	if (buffer == NULL)
 		return;
 
+	if (buffer->refcount && --(*buffer->refcount)) {
+		// The data is still in use by another buffer.
+		dc_context_deallocate (buffer->context, buffer);
+		return;
+	}
+
 	if (buffer->data)
-		free (buffer->data);
+		dc_context_deallocate (buffer->context, buffer->data);
 
-	free (buffer);
+	dc_context_deallocate (buffer->context, buffer->refcount);
+	dc_context_deallocate (buffer->context, buffer);
 }
 
 
@@ -80,6 +137,42 @@ dc_buffer_clear (dc_buffer_t *buffer)
 }
 
 
+/*
+ * Make sure the buffer is the only owner of its data, before the data
+ * is modified. Shared data is copied, and left to the other owners.
+ */
+static int
+dc_buffer_detach (dc_buffer_t *buffer)
+{
+	if (buffer->refcount == NULL)
+		return 1;
+
+	if (*buffer->refcount == 1) {
+		dc_context_deallocate (buffer->context, buffer->refcount);
+		buffer->refcount = NULL;
+		return 1;
+	}
+
+	unsigned char *data = NULL;
+	if (buffer->size) {
+		data = (unsigned char *) dc_context_allocate (buffer->context, buffer->size);
+		if (data == NULL)
+			return 0;
+
+		memcpy (data, buffer->data + buffer->offset, buffer->size);
+	}
+
+	(*buffer->refcount)--;
+
+	buffer->data = data;
+	buffer->capacity = buffer->size;
+	buffer->offset = 0;
+	buffer->refcount = NULL;
+
+	return 1;
+}
+
+
 static size_t
 dc_buffer_expand_calc (dc_buffer_t *buffer, size_t n)
 {
@@ -99,14 +192,14 @@ dc_buffer_expand_append (dc_buffer_t *buffer, size_t n)
 		if (n > buffer->capacity) {
 			size_t capacity = dc_buffer_expand_calc (buffer, n);
 
-			unsigned char *data = (unsigned char *) malloc (capacity);
+			unsigned char *data = (unsigned char *) dc_context_allocate (buffer->context, capacity);
 			if (data == NULL)
 				return 0;
 
 			if (buffer->size)
 				memcpy (data, buffer->data + buffer->offset, buffer->size);
 
-			free (buffer->data);
+			dc_context_deallocate (buffer->context, buffer->data);
 
 			buffer->data = data;
 			buffer->capacity = capacity;
@@ -132,14 +225,14 @@ dc_buffer_expand_prepend (dc_buffer_t *buffer, size_t n)
 		if (n > buffer->capacity) {
 			size_t capacity = dc_buffer_expand_calc (buffer, n);
 
-			unsigned char *data = (unsigned char *) malloc (capacity);
+			unsigned char *data = (unsigned char *) dc_context_allocate (buffer->context, capacity);
 			if (data == NULL)
 				return 0;
 
 			if (buffer->size)
 				memcpy (data + capacity - buffer->size, buffer->data + buffer->offset, buffer->size);
 
-			free (buffer->data);
+			dc_context_deallocate (buffer->context, buffer->data);
 
 			buffer->data = data;
 			buffer->capacity = capacity;
@@ -162,10 +255,13 @@ dc_buffer_reserve (dc_buffer_t *buffer, size_t capacity)
 	if (buffer == NULL)
 		return 0;
 
+	if (!dc_buffer_detach (buffer))
+		return 0;
+
 	if (capacity <= buffer->capacity)
 		return 1;
 
-	unsigned char *data = (unsigned char *) realloc (buffer->data, capacity);
+	unsigned char *data = (unsigned char *) dc_context_reallocate (buffer->context, buffer->data, capacity);
 	if (data == NULL)
 		return 0;
 
@@ -182,6 +278,9 @@ dc_buffer_resize (dc_buffer_t *buffer, size_t size)
 	if (buffer == NULL)
 		return 0;
 
+	if (!dc_buffer_detach (buffer))
+		return 0;
+
 	if (!dc_buffer_expand_append (buffer, size))
 		return 0;
 
@@ -200,6 +299,9 @@ dc_buffer_append (dc_buffer_t *buffer, const unsigned char data[], size_t size)
 	if (buffer == NULL)
 		return 0;
 
+	if (!dc_buffer_detach (buffer))
+		return 0;
+
 	if (!dc_buffer_expand_append (buffer, buffer->size + size))
 		return 0;
 
@@ -212,12 +314,35 @@ dc_buffer_append (dc_buffer_t *buffer, const unsigned char data[], size_t size)
 }
 
 
+unsigned char *
+dc_buffer_append_uninit (dc_buffer_t *buffer, size_t size)
+{
+	if (buffer == NULL)
+		return NULL;
+
+	if (!dc_buffer_detach (buffer))
+		return NULL;
+
+	if (!dc_buffer_expand_append (buffer, buffer->size + size))
+		return NULL;
+
+	unsigned char *data = buffer->data + buffer->offset + buffer->size;
+
+	buffer->size += size;
+
+	return data;
+}
+
+
 int
 dc_buffer_prepend (dc_buffer_t *buffer, const unsigned char data[], size_t size)
 {
 	if (buffer == NULL)
 		return 0;
 
+	if (!dc_buffer_detach (buffer))
+		return 0;
+
 	if (!dc_buffer_expand_prepend (buffer, buffer->size + size))
 		return 0;
 
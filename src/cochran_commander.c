@@ -35,6 +35,9 @@
 
 #define MAXRETRIES 2
 
+// Maximum number of ringbuffer packets per read command.
+#define MAXPACKETS 16
+
 #define COCHRAN_MODEL_COMMANDER_TM 0
 #define COCHRAN_MODEL_COMMANDER_PRE21000 1
 #define COCHRAN_MODEL_COMMANDER_AIR_NITROX 2
@@ -114,6 +117,7 @@ static const dc_device_vtable_t cochran_commander_device_vtable = {
 	NULL, /* write */
 	cochran_commander_device_dump, /* dump */
 	cochran_commander_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	cochran_commander_device_close /* close */
 };
@@ -560,6 +564,8 @@ cochran_commander_read_retry (cochran_commander_device_t *device, dc_event_progr
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
+
 		// Restore the state of the progress events.
 		if (progress) {
 			progress->current = saved;
@@ -742,6 +748,8 @@ cochran_commander_device_open (dc_device_t **out, dc_context_t *context, const c
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	status = cochran_commander_serial_setup(device);
 	if (status != DC_STATUS_SUCCESS) {
 		goto error_close;
@@ -998,8 +1006,12 @@ cochran_commander_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 	else
 		last_start_address = base + array_uint32_le(data.config + layout->cf_last_log );
 
-	// Create the ringbuffer stream.
-	status = dc_rbstream_new (&rbstream, abstract, 1, layout->rbstream_size, layout->rb_profile_begin, layout->rb_profile_end, last_start_address);
+	// Create the ringbuffer stream. Every read command has a large fixed
+	// overhead (a delay and a baudrate change), so the profile data is
+	// read with as few commands as possible. With at most 16 packets, the
+	// low-speed read command of the Commander TM stays within its 64K
+	// limit.
+	status = dc_rbstream_new2 (&rbstream, abstract, 1, layout->rbstream_size, MAXPACKETS, layout->rb_profile_begin, layout->rb_profile_end, last_start_address, profile_read_size);
 	if (status != DC_STATUS_SUCCESS) {
 		ERROR (abstract->context, "Failed to create the ringbuffer stream.");
 		goto error;
@@ -62,6 +62,78 @@ extern "C" {
 #define DEBUG(context, ...) UNUSED(context)
 #endif
 
+void *
+dc_context_allocate (dc_context_t *context, size_t size);
+
+void *
+dc_context_reallocate (dc_context_t *context, void *ptr, size_t size);
+
+void
+dc_context_deallocate (dc_context_t *context, void *ptr);
+
+struct dc_parser_pool_t;
+
+struct dc_parser_pool_t *
+dc_context_get_parserpool (dc_context_t *context);
+
+// Lock the context, to serialize the access to the shared state (such as
+// the parser pool) from multiple threads. The lock is not recursive, and
+// must not be held while calling other context functions.
+void
+dc_context_lock (dc_context_t *context);
+
+void
+dc_context_unlock (dc_context_t *context);
+
+dc_trace_mode_t
+dc_context_get_trace (dc_context_t *context, const char **filename, unsigned int *speed);
+
+// Get the sequence number of the next traced I/O stream, and advance it.
+// The numbering starts from zero after every dc_context_set_trace call,
+// or when restart is set.
+unsigned int
+dc_context_next_trace (dc_context_t *context, unsigned int restart);
+
+const char *
+dc_context_get_cache (dc_context_t *context);
+
+// Build the name of the file with the given extension, in which data of
+// a particular device is kept in the cache directory. Returns NULL if
+// the cache is disabled, or on failure. The name must be freed with
+// dc_context_deallocate.
+char *
+dc_context_get_cachefile (dc_context_t *context, dc_family_t family, unsigned int serial, const char *extension);
+
+// Communication parameters learned for a particular device. They are
+// kept in the context, and also in the cache directory (if enabled), so
+// the next process starts with them too.
+typedef struct dc_pacing_t {
+	unsigned int delay;
+	unsigned int packetsize;
+} dc_pacing_t;
+
+dc_status_t
+dc_context_get_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, dc_pacing_t *pacing);
+
+dc_status_t
+dc_context_set_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, const dc_pacing_t *pacing);
+
+// Immutable objects shared by all parsers of a context, such as compiled
+// lookup tables. Once added, an object is owned by the context. Adding a
+// second object with the same key fails with DC_STATUS_UNSUPPORTED, and
+// leaves it with the caller. The context keeps only the most recently
+// used objects, and evicts the others. Every object returned by
+// dc_context_get_shared must therefore be released again with
+// dc_context_release_shared, to keep it alive while in use.
+void *
+dc_context_get_shared (dc_context_t *context, dc_family_t family, unsigned int key);
+
+void
+dc_context_release_shared (dc_context_t *context, void *data);
+
+dc_status_t
+dc_context_add_shared (dc_context_t *context, dc_family_t family, unsigned int key, void *data, void (*destroy) (void *data));
+
 dc_status_t
 dc_context_log (dc_context_t *context, dc_loglevel_t loglevel, const char *file, unsigned int line, const char *function, const char *format, ...) ATTR_FORMAT_PRINTF(6, 7);
 
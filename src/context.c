@@ -19,10 +19,17 @@
  * MA 02110-1301 USA
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
 #include <string.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
 
 #ifdef _WIN32
 #define NOGDI
@@ -32,13 +39,62 @@
 #endif
 
 #include "context-private.h"
+#include "parser-private.h"
+#include "array.h"
+
+/*
+ * The pacing file contains a magic string, followed by the family, the
+ * serial number, the delay and the packet size. All numbers are stored
+ * in little endian byte order.
+ */
+#define PACING_MAGIC    "DCPACE01"
+#define PACING_SZ_MAGIC 8
+#define PACING_SZ_DATA  16
+
+typedef struct dc_pacing_entry_t {
+	struct dc_pacing_entry_t *next;
+	dc_family_t family;
+	unsigned int serial;
+	dc_pacing_t pacing;
+} dc_pacing_entry_t;
+
+// Maximum number of shared objects kept in the context.
+#define MAXSHARED 8
+
+typedef struct dc_shared_entry_t {
+	struct dc_shared_entry_t *next;
+	dc_family_t family;
+	unsigned int key;
+	void *data;
+	void (*destroy) (void *data);
+	// Number of references returned by dc_context_get_shared.
+	unsigned int refcount;
+	// Evicted objects can no longer be found, and are destroyed once
+	// the last reference is released.
+	unsigned int evicted;
+} dc_shared_entry_t;
 
 struct dc_context_t {
 	dc_loglevel_t loglevel;
 	dc_logfunc_t logfunc;
 	void *userdata;
+	dc_allocator_t allocator;
+	void *allocator_userdata;
+	dc_parser_pool_t parserpool;
+	dc_trace_mode_t tracemode;
+	char *tracefile;
+	unsigned int tracespeed;
+	unsigned int tracecount;
+	char *cachedir;
+	dc_pacing_entry_t *pacing;
+	dc_shared_entry_t *shared;
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_t mutex;
+#endif
 #ifdef ENABLE_LOGGING
-	char msg[8192 + 32];
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_t logmutex;
+#endif
 #ifdef _WIN32
 	LARGE_INTEGER timestamp, frequency;
 #else
@@ -48,6 +104,13 @@ struct dc_context_t {
 };
 
 #ifdef ENABLE_LOGGING
+/*
+ * The size of the log message buffer. The messages are formatted on the
+ * stack of the calling thread, so concurrent downloads on the same context
+ * never share a buffer.
+ */
+#define MSGSIZE (8192 + 32)
+
 /*
  * A wrapper for the vsnprintf function, which will always null terminate the
  * string and returns a negative value if the destination buffer is too small.
@@ -185,8 +248,32 @@ dc_context_new (dc_context_t **out)
 #endif
 	context->userdata = NULL;
 
+	context->allocator.allocate = NULL;
+	context->allocator.reallocate = NULL;
+	context->allocator.deallocate = NULL;
+	context->allocator_userdata = NULL;
+
+	context->parserpool.head = NULL;
+	context->parserpool.count = 0;
+	context->parserpool.capacity = 0;
+
+	context->tracemode = DC_TRACE_NONE;
+	context->tracefile = NULL;
+	context->tracespeed = 0;
+	context->tracecount = 0;
+
+	context->cachedir = NULL;
+
+	context->pacing = NULL;
+	context->shared = NULL;
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_init (&context->mutex, NULL);
+#endif
+
 #ifdef ENABLE_LOGGING
-	memset (context->msg, 0, sizeof (context->msg));
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_init (&context->logmutex, NULL);
+#endif
 #ifdef _WIN32
 	QueryPerformanceFrequency(&context->frequency);
 	QueryPerformanceCounter(&context->timestamp);
@@ -200,9 +287,47 @@ dc_context_new (dc_context_t **out)
 	return DC_STATUS_SUCCESS;
 }
 
+static void
+dc_context_destroy_shared (dc_context_t *context, dc_shared_entry_t *entry)
+{
+	if (entry->destroy)
+		entry->destroy (entry->data);
+	dc_context_deallocate (context, entry);
+}
+
 dc_status_t
 dc_context_free (dc_context_t *context)
 {
+	if (context == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_parser_pool_resize (context, 0);
+
+	dc_pacing_entry_t *entry = context->pacing;
+	while (entry) {
+		dc_pacing_entry_t *next = entry->next;
+		dc_context_deallocate (context, entry);
+		entry = next;
+	}
+
+	// The pooled parsers may still refer to the shared objects, so
+	// these are destroyed after the pool.
+	dc_shared_entry_t *shared = context->shared;
+	while (shared) {
+		dc_shared_entry_t *next = shared->next;
+		dc_context_destroy_shared (context, shared);
+		shared = next;
+	}
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_destroy (&context->mutex);
+#ifdef ENABLE_LOGGING
+	pthread_mutex_destroy (&context->logmutex);
+#endif
+#endif
+
+	free (context->tracefile);
+	free (context->cachedir);
 	free (context);
 
 	return DC_STATUS_SUCCESS;
@@ -235,11 +360,498 @@ dc_context_set_logfunc (dc_context_t *context, dc_logfunc_t logfunc, void *userd
 	return DC_STATUS_SUCCESS;
 }
 
+dc_status_t
+dc_context_set_allocator (dc_context_t *context, const dc_allocator_t *allocator, void *userdata)
+{
+	if (context == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (allocator) {
+		if (allocator->allocate == NULL || allocator->reallocate == NULL || allocator->deallocate == NULL)
+			return DC_STATUS_INVALIDARGS;
+
+		context->allocator = *allocator;
+		context->allocator_userdata = userdata;
+	} else {
+		context->allocator.allocate = NULL;
+		context->allocator.reallocate = NULL;
+		context->allocator.deallocate = NULL;
+		context->allocator_userdata = NULL;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+void *
+dc_context_allocate (dc_context_t *context, size_t size)
+{
+	if (context == NULL || context->allocator.allocate == NULL)
+		return malloc (size);
+
+	return context->allocator.allocate (size, context->allocator_userdata);
+}
+
+void *
+dc_context_reallocate (dc_context_t *context, void *ptr, size_t size)
+{
+	if (context == NULL || context->allocator.reallocate == NULL)
+		return realloc (ptr, size);
+
+	return context->allocator.reallocate (ptr, size, context->allocator_userdata);
+}
+
+void
+dc_context_deallocate (dc_context_t *context, void *ptr)
+{
+	if (context == NULL || context->allocator.deallocate == NULL) {
+		free (ptr);
+		return;
+	}
+
+	context->allocator.deallocate (ptr, context->allocator_userdata);
+}
+
+dc_status_t
+dc_context_set_parserpool (dc_context_t *context, unsigned int size)
+{
+	if (context == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Destroy the parsers that no longer fit.
+	dc_parser_pool_resize (context, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_parser_pool_t *
+dc_context_get_parserpool (dc_context_t *context)
+{
+	if (context == NULL)
+		return NULL;
+
+	return &context->parserpool;
+}
+
+void
+dc_context_lock (dc_context_t *context)
+{
+#ifdef HAVE_PTHREAD_H
+	if (context)
+		pthread_mutex_lock (&context->mutex);
+#endif
+}
+
+void
+dc_context_unlock (dc_context_t *context)
+{
+#ifdef HAVE_PTHREAD_H
+	if (context)
+		pthread_mutex_unlock (&context->mutex);
+#endif
+}
+
+dc_status_t
+dc_context_set_trace (dc_context_t *context, dc_trace_mode_t mode, const char *filename, unsigned int speed)
+{
+	char *tracefile = NULL;
+
+	if (context == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (mode != DC_TRACE_NONE) {
+		if (filename == NULL)
+			return DC_STATUS_INVALIDARGS;
+
+		size_t length = strlen (filename);
+		tracefile = (char *) malloc (length + 1);
+		if (tracefile == NULL)
+			return DC_STATUS_NOMEMORY;
+
+		memcpy (tracefile, filename, length + 1);
+	}
+
+	free (context->tracefile);
+
+	context->tracemode = mode;
+	context->tracefile = tracefile;
+	context->tracespeed = speed;
+	context->tracecount = 0;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_trace_mode_t
+dc_context_get_trace (dc_context_t *context, const char **filename, unsigned int *speed)
+{
+	if (context == NULL)
+		return DC_TRACE_NONE;
+
+	if (filename)
+		*filename = context->tracefile;
+
+	if (speed)
+		*speed = context->tracespeed;
+
+	return context->tracemode;
+}
+
+unsigned int
+dc_context_next_trace (dc_context_t *context, unsigned int restart)
+{
+	unsigned int index = 0;
+
+	if (context == NULL)
+		return 0;
+
+	dc_context_lock (context);
+	if (restart)
+		context->tracecount = 0;
+	index = context->tracecount++;
+	dc_context_unlock (context);
+
+	return index;
+}
+
+dc_status_t
+dc_context_set_cache (dc_context_t *context, const char *directory)
+{
+	char *cachedir = NULL;
+
+	if (context == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (directory) {
+		size_t length = strlen (directory);
+		cachedir = (char *) malloc (length + 1);
+		if (cachedir == NULL)
+			return DC_STATUS_NOMEMORY;
+
+		memcpy (cachedir, directory, length + 1);
+	}
+
+	free (context->cachedir);
+
+	context->cachedir = cachedir;
+
+	return DC_STATUS_SUCCESS;
+}
+
+const char *
+dc_context_get_cache (dc_context_t *context)
+{
+	if (context == NULL)
+		return NULL;
+
+	return context->cachedir;
+}
+
+char *
+dc_context_get_cachefile (dc_context_t *context, dc_family_t family, unsigned int serial, const char *extension)
+{
+	if (context == NULL || context->cachedir == NULL || extension == NULL)
+		return NULL;
+
+	// Directory, separator, two 8 digit numbers, dash, dot and extension.
+	size_t length = strlen (context->cachedir) + strlen (extension) + 20;
+	char *filename = (char *) dc_context_allocate (context, length);
+	if (filename == NULL)
+		return NULL;
+
+	snprintf (filename, length, "%s/%08x-%08x.%s",
+		context->cachedir, family, serial, extension);
+
+	return filename;
+}
+
+static dc_status_t
+dc_context_load_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, dc_pacing_t *pacing)
+{
+	dc_status_t status = DC_STATUS_UNSUPPORTED;
+	unsigned char magic[PACING_SZ_MAGIC] = {0};
+	unsigned char data[PACING_SZ_DATA] = {0};
+
+	char *filename = dc_context_get_cachefile (context, family, serial, "pacing");
+	if (filename == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	FILE *fp = fopen (filename, "rb");
+	if (fp == NULL)
+		goto error_free;
+
+	if (fread (magic, sizeof (magic), 1, fp) != 1 ||
+		fread (data, sizeof (data), 1, fp) != 1 ||
+		memcmp (magic, PACING_MAGIC, PACING_SZ_MAGIC) != 0 ||
+		array_uint32_le (data + 0) != family ||
+		array_uint32_le (data + 4) != serial) {
+		WARNING (context, "Invalid pacing file '%s'.", filename);
+		goto error_close;
+	}
+
+	pacing->delay = array_uint32_le (data + 8);
+	pacing->packetsize = array_uint32_le (data + 12);
+
+	status = DC_STATUS_SUCCESS;
+
+error_close:
+	fclose (fp);
+error_free:
+	dc_context_deallocate (context, filename);
+	return status;
+}
+
+static dc_status_t
+dc_context_save_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, const dc_pacing_t *pacing)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	unsigned char data[PACING_SZ_DATA] = {0};
+
+	char *filename = dc_context_get_cachefile (context, family, serial, "pacing");
+	if (filename == NULL)
+		return DC_STATUS_SUCCESS;
+
+	array_uint32_le_set (data + 0, family);
+	array_uint32_le_set (data + 4, serial);
+	array_uint32_le_set (data + 8, pacing->delay);
+	array_uint32_le_set (data + 12, pacing->packetsize);
+
+	FILE *fp = fopen (filename, "wb");
+	if (fp == NULL) {
+		ERROR (context, "Failed to create the pacing file '%s'.", filename);
+		status = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	if (fwrite (PACING_MAGIC, PACING_SZ_MAGIC, 1, fp) != 1 ||
+		fwrite (data, sizeof (data), 1, fp) != 1) {
+		ERROR (context, "Failed to write the pacing file '%s'.", filename);
+		status = DC_STATUS_IO;
+	}
+
+	if (fclose (fp) != 0 && status == DC_STATUS_SUCCESS) {
+		ERROR (context, "Failed to write the pacing file '%s'.", filename);
+		status = DC_STATUS_IO;
+	}
+
+error_free:
+	dc_context_deallocate (context, filename);
+	return status;
+}
+
+static dc_status_t
+dc_context_store_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, const dc_pacing_t *pacing)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	dc_context_lock (context);
+
+	dc_pacing_entry_t *entry = context->pacing;
+	while (entry && (entry->family != family || entry->serial != serial)) {
+		entry = entry->next;
+	}
+
+	if (entry == NULL) {
+		entry = (dc_pacing_entry_t *) dc_context_allocate (context, sizeof (dc_pacing_entry_t));
+		if (entry == NULL) {
+			status = DC_STATUS_NOMEMORY;
+			goto error_unlock;
+		}
+
+		entry->family = family;
+		entry->serial = serial;
+		entry->next = context->pacing;
+		context->pacing = entry;
+	}
+
+	entry->pacing = *pacing;
+
+error_unlock:
+	dc_context_unlock (context);
+	return status;
+}
+
+dc_status_t
+dc_context_get_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, dc_pacing_t *pacing)
+{
+	dc_status_t status = DC_STATUS_UNSUPPORTED;
+
+	if (context == NULL || pacing == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_context_lock (context);
+
+	for (dc_pacing_entry_t *entry = context->pacing; entry; entry = entry->next) {
+		if (entry->family == family && entry->serial == serial) {
+			*pacing = entry->pacing;
+			status = DC_STATUS_SUCCESS;
+			break;
+		}
+	}
+
+	dc_context_unlock (context);
+
+	// Fall back to the parameters stored by a previous process.
+	if (status != DC_STATUS_SUCCESS) {
+		status = dc_context_load_pacing (context, family, serial, pacing);
+		if (status == DC_STATUS_SUCCESS) {
+			dc_context_store_pacing (context, family, serial, pacing);
+		}
+	}
+
+	return status;
+}
+
+dc_status_t
+dc_context_set_pacing (dc_context_t *context, dc_family_t family, unsigned int serial, const dc_pacing_t *pacing)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (context == NULL || pacing == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	status = dc_context_store_pacing (context, family, serial, pacing);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	// Keep the parameters for the next process.
+	return dc_context_save_pacing (context, family, serial, pacing);
+}
+
+void *
+dc_context_get_shared (dc_context_t *context, dc_family_t family, unsigned int key)
+{
+	void *data = NULL;
+
+	if (context == NULL)
+		return NULL;
+
+	dc_context_lock (context);
+
+	dc_shared_entry_t **link = &context->shared;
+	while (*link) {
+		dc_shared_entry_t *entry = *link;
+		if (!entry->evicted && entry->family == family && entry->key == key) {
+			// Move the entry to the front of the list, to keep the
+			// list in order of the most recent use.
+			*link = entry->next;
+			entry->next = context->shared;
+			context->shared = entry;
+
+			entry->refcount++;
+			data = entry->data;
+			break;
+		}
+		link = &entry->next;
+	}
+
+	dc_context_unlock (context);
+
+	return data;
+}
+
+void
+dc_context_release_shared (dc_context_t *context, void *data)
+{
+	dc_shared_entry_t *entry = NULL;
+
+	if (context == NULL || data == NULL)
+		return;
+
+	dc_context_lock (context);
+
+	dc_shared_entry_t **link = &context->shared;
+	while (*link && (*link)->data != data) {
+		link = &(*link)->next;
+	}
+
+	entry = *link;
+	if (entry && entry->refcount) {
+		entry->refcount--;
+		if (entry->refcount == 0 && entry->evicted) {
+			*link = entry->next;
+		} else {
+			entry = NULL;
+		}
+	} else {
+		entry = NULL;
+	}
+
+	dc_context_unlock (context);
+
+	// Destroy the evicted object without the lock.
+	if (entry)
+		dc_context_destroy_shared (context, entry);
+}
+
+dc_status_t
+dc_context_add_shared (dc_context_t *context, dc_family_t family, unsigned int key, void *data, void (*destroy) (void *data))
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_shared_entry_t *evicted = NULL;
+	unsigned int count = 0;
+
+	if (context == NULL || data == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_context_lock (context);
+
+	dc_shared_entry_t **last = NULL;
+	dc_shared_entry_t **link = &context->shared;
+	while (*link) {
+		dc_shared_entry_t *entry = *link;
+		if (!entry->evicted) {
+			if (entry->family == family && entry->key == key) {
+				// Keep the existing object.
+				status = DC_STATUS_UNSUPPORTED;
+				goto error_unlock;
+			}
+			last = link;
+			count++;
+		}
+		link = &entry->next;
+	}
+
+	dc_shared_entry_t *entry = (dc_shared_entry_t *) dc_context_allocate (context, sizeof (dc_shared_entry_t));
+	if (entry == NULL) {
+		status = DC_STATUS_NOMEMORY;
+		goto error_unlock;
+	}
+
+	// Evict the least recently used object. An object that is still in
+	// use is destroyed once the last reference is released.
+	if (count >= MAXSHARED) {
+		dc_shared_entry_t *lru = *last;
+		if (lru->refcount) {
+			lru->evicted = 1;
+		} else {
+			*last = lru->next;
+			evicted = lru;
+		}
+	}
+
+	entry->family = family;
+	entry->key = key;
+	entry->data = data;
+	entry->destroy = destroy;
+	entry->refcount = 0;
+	entry->evicted = 0;
+	entry->next = context->shared;
+	context->shared = entry;
+
+error_unlock:
+	dc_context_unlock (context);
+
+	if (evicted)
+		dc_context_destroy_shared (context, evicted);
+
+	return status;
+}
+
 dc_status_t
 dc_context_log (dc_context_t *context, dc_loglevel_t loglevel, const char *file, unsigned int line, const char *function, const char *format, ...)
 {
 #ifdef ENABLE_LOGGING
 	va_list ap;
+	char msg[MSGSIZE];
 #endif
 
 	if (context == NULL)
@@ -253,10 +865,18 @@ dc_context_log (dc_context_t *context, dc_loglevel_t loglevel, const char *file,
 		return DC_STATUS_SUCCESS;
 
 	va_start (ap, format);
-	l_vsnprintf (context->msg, sizeof (context->msg), format, ap);
+	l_vsnprintf (msg, sizeof (msg), format, ap);
 	va_end (ap);
 
-	context->logfunc (context, loglevel, file, line, function, context->msg, context->userdata);
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&context->logmutex);
+#endif
+
+	context->logfunc (context, loglevel, file, line, function, msg, context->userdata);
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&context->logmutex);
+#endif
 #endif
 
 	return DC_STATUS_SUCCESS;
@@ -307,6 +927,7 @@ dc_context_hexdump (dc_context_t *context, dc_loglevel_t loglevel, const char *f
 {
 #ifdef ENABLE_LOGGING
 	int n;
+	char msg[MSGSIZE];
 #endif
 
 	if (context == NULL || prefix == NULL)
@@ -319,13 +940,21 @@ dc_context_hexdump (dc_context_t *context, dc_loglevel_t loglevel, const char *f
 	if (context->logfunc == NULL)
 		return DC_STATUS_SUCCESS;
 
-	n = l_snprintf (context->msg, sizeof (context->msg), "%s: size=%u, data=", prefix, size);
+	n = l_snprintf (msg, sizeof (msg), "%s: size=%u, data=", prefix, size);
 
 	if (n >= 0) {
-		n = l_hexdump (context->msg + n, sizeof (context->msg) - n, data, size);
+		n = l_hexdump (msg + n, sizeof (msg) - n, data, size);
 	}
 
-	context->logfunc (context, loglevel, file, line, function, context->msg, context->userdata);
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_lock (&context->logmutex);
+#endif
+
+	context->logfunc (context, loglevel, file, line, function, msg, context->userdata);
+
+#ifdef HAVE_PTHREAD_H
+	pthread_mutex_unlock (&context->logmutex);
+#endif
 #endif
 
 	return DC_STATUS_SUCCESS;
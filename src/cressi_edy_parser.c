@@ -50,6 +50,8 @@ static const dc_parser_vtable_t cressi_edy_parser_vtable = {
 	cressi_edy_parser_get_datetime, /* datetime */
 	cressi_edy_parser_get_field, /* fields */
 	cressi_edy_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -173,6 +175,9 @@ cressi_edy_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t c
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
+	if (size < 32)
+		return DC_STATUS_DATAFORMAT;
+
 	unsigned int time = 0;
 	unsigned int interval = 30;
 	if (parser->model == EDY) {
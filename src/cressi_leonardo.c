@@ -67,6 +67,7 @@ static const dc_device_vtable_t cressi_leonardo_device_vtable = {
 	NULL, /* write */
 	cressi_leonardo_device_dump, /* dump */
 	cressi_leonardo_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	cressi_leonardo_device_close /* close */
 };
@@ -134,6 +135,7 @@ cressi_leonardo_packet (cressi_leonardo_device_t *device, const unsigned char co
 	unsigned short ccrc = checksum_crc_ccitt_uint16 (answer + 1, asize - 6);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -155,6 +157,8 @@ cressi_leonardo_transfer (cressi_leonardo_device_t *device, const unsigned char
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
+
 		// Discard any garbage bytes.
 		dc_iostream_sleep (device->iostream, 100);
 		dc_iostream_purge (device->iostream, DC_DIRECTION_INPUT);
@@ -190,6 +194,8 @@ cressi_leonardo_device_open (dc_device_t **out, dc_context_t *context, const cha
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -412,7 +418,7 @@ cressi_leonardo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 static dc_status_t
 cressi_leonardo_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
-	dc_buffer_t *buffer = dc_buffer_new (SZ_MEMORY);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, SZ_MEMORY);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
@@ -35,6 +35,7 @@ static dc_status_t dc_custom_set_dtr (dc_iostream_t *abstract, unsigned int valu
 static dc_status_t dc_custom_set_rts (dc_iostream_t *abstract, unsigned int value);
 static dc_status_t dc_custom_get_lines (dc_iostream_t *abstract, unsigned int *value);
 static dc_status_t dc_custom_get_available (dc_iostream_t *abstract, size_t *value);
+static dc_status_t dc_custom_get_handle (dc_iostream_t *abstract, int *value);
 static dc_status_t dc_custom_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
 static dc_status_t dc_custom_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual);
 static dc_status_t dc_custom_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual);
@@ -61,6 +62,7 @@ static const dc_iostream_vtable_t dc_custom_vtable = {
 	dc_custom_set_rts, /* set_rts */
 	dc_custom_get_lines, /* get_lines */
 	dc_custom_get_available, /* get_received */
+	dc_custom_get_handle, /* get_handle */
 	dc_custom_configure, /* configure */
 	dc_custom_read, /* read */
 	dc_custom_write, /* write */
@@ -183,6 +185,17 @@ dc_custom_get_available (dc_iostream_t *abstract, size_t *value)
 	return custom->callbacks.get_available (custom->userdata, value);
 }
 
+static dc_status_t
+dc_custom_get_handle (dc_iostream_t *abstract, int *value)
+{
+	dc_custom_t *custom = (dc_custom_t *) abstract;
+
+	if (custom->callbacks.get_handle == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	return custom->callbacks.get_handle (custom->userdata, value);
+}
+
 static dc_status_t
 dc_custom_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
 {
@@ -26,6 +26,7 @@
 
 #include <libdivecomputer/context.h>
 #include <libdivecomputer/device.h>
+#include <libdivecomputer/iostream.h>
 
 #include "common-private.h"
 
@@ -37,8 +38,10 @@ extern "C" {
 
 struct dc_device_t;
 struct dc_device_vtable_t;
+struct dc_device_download_t;
 
 typedef struct dc_device_vtable_t dc_device_vtable_t;
+typedef struct dc_device_download_t dc_device_download_t;
 
 struct dc_device_t {
 	const dc_device_vtable_t *vtable;
@@ -54,6 +57,10 @@ struct dc_device_t {
 	// Cached events for the parsers.
 	dc_event_devinfo_t devinfo;
 	dc_event_clock_t clock;
+	// Transfer statistics.
+	dc_event_stats_t stats;
+	// Previous memory dump for incremental downloads.
+	dc_buffer_t *previous;
 };
 
 struct dc_device_vtable_t {
@@ -71,6 +78,8 @@ struct dc_device_vtable_t {
 
 	dc_status_t (*foreach) (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
+	dc_status_t (*download) (dc_device_t *device, dc_dive_callback_t callback, void *userdata, dc_device_download_t **download);
+
 	dc_status_t (*timesync) (dc_device_t *device, const dc_datetime_t *datetime);
 
 	dc_status_t (*close) (dc_device_t *device);
@@ -91,9 +100,66 @@ device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data)
 int
 device_is_cancelled (dc_device_t *device);
 
+typedef enum device_stats_t {
+	DEVICE_STATS_RETRY,
+	DEVICE_STATS_CHECKSUM,
+	DEVICE_STATS_NAK,
+} device_stats_t;
+
+void
+device_stats_increment (dc_device_t *device, device_stats_t counter);
+
+void
+device_set_iostream (dc_device_t *device, dc_iostream_t *iostream);
+
 dc_status_t
 device_dump_read (dc_device_t *device, unsigned char data[], unsigned int size, unsigned int blocksize);
 
+/*
+ * A resumable download, the non-blocking equivalent of the foreach
+ * function. Instead of waiting for the device, the step function starts
+ * an asynchronous read on the I/O stream, or requests a delay, and
+ * returns DC_STATUS_SUCCESS. The event loop calls the step function
+ * again once the read has completed, failed or timed out, or the delay
+ * has expired. The step function returns DC_STATUS_DONE once the
+ * download has finished, or an error code.
+ */
+struct dc_device_download_t {
+	dc_device_t *device;
+	dc_iostream_t *iostream;
+	dc_dive_callback_t callback;
+	void *userdata;
+	dc_status_t (*step) (dc_device_download_t *download);
+	void (*cleanup) (dc_device_download_t *download);
+	// Pending asynchronous read.
+	unsigned int reading;
+	unsigned int timeout;
+	dc_status_t status;
+	// Requested delay (milliseconds).
+	unsigned int delay;
+};
+
+dc_device_download_t *
+device_download_allocate (dc_device_t *device, size_t size, dc_iostream_t *iostream, unsigned int timeout, dc_dive_callback_t callback, void *userdata);
+
+dc_status_t
+device_download_read (dc_device_download_t *download, void *data, size_t size);
+
+void
+device_download_sleep (dc_device_download_t *download, unsigned int milliseconds);
+
+dc_status_t
+dc_device_download_new (dc_device_download_t **download, dc_device_t *device, dc_dive_callback_t callback, void *userdata);
+
+dc_status_t
+dc_device_download_step (dc_device_download_t *download);
+
+void
+dc_device_download_timeout (dc_device_download_t *download);
+
+void
+dc_device_download_free (dc_device_download_t *download);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
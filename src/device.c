@@ -60,6 +60,7 @@
 
 #include "device-private.h"
 #include "context-private.h"
+#include "iostream-private.h"
 
 dc_device_t *
 dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
@@ -70,7 +71,7 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
 	assert(vtable->size >= sizeof(dc_device_t));
 
 	// Allocate memory.
-	device = (dc_device_t *) malloc (vtable->size);
+	device = (dc_device_t *) dc_context_allocate (context, vtable->size);
 	if (device == NULL) {
 		ERROR (context, "Failed to allocate memory.");
 		return device;
@@ -89,6 +90,9 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
 
 	memset (&device->devinfo, 0, sizeof (device->devinfo));
 	memset (&device->clock, 0, sizeof (device->clock));
+	memset (&device->stats, 0, sizeof (device->stats));
+
+	device->previous = NULL;
 
 	return device;
 }
@@ -96,7 +100,10 @@ dc_device_allocate (dc_context_t *context, const dc_device_vtable_t *vtable)
 void
 dc_device_deallocate (dc_device_t *device)
 {
-	free (device);
+	if (device == NULL)
+		return;
+
+	dc_context_deallocate (device->context, device);
 }
 
 dc_status_t
@@ -268,6 +275,18 @@ dc_device_set_events (dc_device_t *device, unsigned int events, dc_event_callbac
 }
 
 
+dc_status_t
+dc_device_get_stats (dc_device_t *device, dc_event_stats_t *stats)
+{
+	if (device == NULL || stats == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	*stats = device->stats;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 dc_status_t
 dc_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size)
 {
@@ -316,7 +335,44 @@ dc_device_dump (dc_device_t *device, dc_buffer_t *buffer)
 	if (device->vtable->dump == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
-	return device->vtable->dump (device, buffer);
+	dc_status_t status = device->vtable->dump (device, buffer);
+
+	device_event_emit (device, DC_EVENT_STATS, &device->stats);
+
+	return status;
+}
+
+
+dc_status_t
+dc_device_dump_incremental (dc_device_t *device, dc_buffer_t *previous, dc_buffer_t *buffer)
+{
+	if (device == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (device->vtable->dump == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// The previous memory dump is only valid during this call.
+	device->previous = previous;
+
+	dc_status_t status = device->vtable->dump (device, buffer);
+
+	device->previous = NULL;
+
+	device_event_emit (device, DC_EVENT_STATS, &device->stats);
+
+	return status;
+}
+
+
+void
+device_set_iostream (dc_device_t *device, dc_iostream_t *iostream)
+{
+	if (device == NULL)
+		return;
+
+	// Collect the transfer statistics of the I/O stream.
+	dc_iostream_set_stats (iostream, &device->stats);
 }
 
 
@@ -366,7 +422,145 @@ dc_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userd
 	if (device->vtable->foreach == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
-	return device->vtable->foreach (device, callback, userdata);
+	dc_status_t status = device->vtable->foreach (device, callback, userdata);
+
+	device_event_emit (device, DC_EVENT_STATS, &device->stats);
+
+	return status;
+}
+
+
+static void
+device_download_complete (dc_iostream_t *iostream, dc_status_t status, size_t actual, void *userdata)
+{
+	dc_device_download_t *download = (dc_device_download_t *) userdata;
+
+	download->reading = 0;
+	download->status = status;
+}
+
+
+dc_device_download_t *
+device_download_allocate (dc_device_t *device, size_t size, dc_iostream_t *iostream, unsigned int timeout, dc_dive_callback_t callback, void *userdata)
+{
+	assert (size >= sizeof (dc_device_download_t));
+
+	dc_device_download_t *download = (dc_device_download_t *) dc_context_allocate (device->context, size);
+	if (download == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		return NULL;
+	}
+
+	download->device = device;
+	download->iostream = iostream;
+	download->callback = callback;
+	download->userdata = userdata;
+	download->step = NULL;
+	download->cleanup = NULL;
+	download->reading = 0;
+	download->timeout = timeout;
+	download->status = DC_STATUS_SUCCESS;
+	download->delay = 0;
+
+	return download;
+}
+
+
+dc_status_t
+device_download_read (dc_device_download_t *download, void *data, size_t size)
+{
+	download->reading = 1;
+	download->status = DC_STATUS_SUCCESS;
+
+	dc_status_t rc = dc_iostream_read_async (download->iostream, data, size, device_download_complete, download);
+	if (rc != DC_STATUS_SUCCESS && download->reading) {
+		// The read was not started.
+		download->reading = 0;
+		return rc;
+	}
+
+	// The read may have completed (or failed) already. The status is
+	// then available to the next step.
+	return DC_STATUS_SUCCESS;
+}
+
+
+void
+device_download_sleep (dc_device_download_t *download, unsigned int milliseconds)
+{
+	download->delay = milliseconds;
+}
+
+
+dc_status_t
+dc_device_download_new (dc_device_download_t **out, dc_device_t *device, dc_dive_callback_t callback, void *userdata)
+{
+	dc_device_download_t *download = NULL;
+	int handle = 0;
+
+	if (out == NULL || device == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (device->vtable->download == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	dc_status_t status = device->vtable->download (device, callback, userdata, &download);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	// The event loop needs a handle to wait for incoming data.
+	status = dc_iostream_get_handle (download->iostream, &handle);
+	if (status != DC_STATUS_SUCCESS) {
+		dc_device_download_free (download);
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	*out = download;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+dc_status_t
+dc_device_download_step (dc_device_download_t *download)
+{
+	dc_status_t status = download->step (download);
+	if (status != DC_STATUS_SUCCESS) {
+		device_event_emit (download->device, DC_EVENT_STATS, &download->device->stats);
+	}
+
+	return status;
+}
+
+
+void
+dc_device_download_timeout (dc_device_download_t *download)
+{
+	if (!download->reading)
+		return;
+
+	dc_iostream_cancel (download->iostream);
+
+	download->reading = 0;
+	download->status = DC_STATUS_TIMEOUT;
+}
+
+
+void
+dc_device_download_free (dc_device_download_t *download)
+{
+	if (download == NULL)
+		return;
+
+	if (download->reading) {
+		dc_iostream_cancel (download->iostream);
+	}
+
+	if (download->cleanup) {
+		download->cleanup (download);
+	}
+
+	dc_context_deallocate (download->device->context, download);
 }
 
 
@@ -426,6 +620,9 @@ device_event_emit (dc_device_t *device, dc_event_type_t event, const void *data)
 	case DC_EVENT_CLOCK:
 		assert (data != NULL);
 		break;
+	case DC_EVENT_STATS:
+		assert (data != NULL);
+		break;
 	default:
 		break;
 	}
@@ -468,3 +665,23 @@ device_is_cancelled (dc_device_t *device)
 
 	return device->cancel_callback (device->cancel_userdata);
 }
+
+
+void
+device_stats_increment (dc_device_t *device, device_stats_t counter)
+{
+	if (device == NULL)
+		return;
+
+	switch (counter) {
+	case DEVICE_STATS_RETRY:
+		device->stats.nretries++;
+		break;
+	case DEVICE_STATS_CHECKSUM:
+		device->stats.nchecksums++;
+		break;
+	case DEVICE_STATS_NAK:
+		device->stats.nnaks++;
+		break;
+	}
+}
@@ -86,6 +86,7 @@ static const dc_device_vtable_t divesystem_idive_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	divesystem_idive_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	divesystem_idive_device_close /* close */
 };
@@ -142,6 +143,8 @@ divesystem_idive_device_open (dc_device_t **out, dc_context_t *context, const ch
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -288,6 +291,7 @@ divesystem_idive_receive (divesystem_idive_device_t *device, unsigned char answe
 	unsigned short ccrc = checksum_crc_ccitt_uint16 (packet, len + 2);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected packet checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -346,6 +350,7 @@ divesystem_idive_packet (divesystem_idive_device_t *device, const unsigned char
 	if (type == NAK) {
 		errcode = packet[1];
 		ERROR (abstract->context, "Received NAK packet with error code %02x.", errcode);
+		device_stats_increment (abstract, DEVICE_STATS_NAK);
 		status = DC_STATUS_PROTOCOL;
 		goto error;
 	}
@@ -382,6 +387,8 @@ divesystem_idive_transfer (divesystem_idive_device_t *device, const unsigned cha
 		if (nretries++ >= MAXRETRIES)
 			break;
 
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
+
 		// Delay the next attempt.
 		dc_iostream_sleep (device->iostream, 100);
 	}
@@ -80,6 +80,8 @@ static const dc_parser_vtable_t divesystem_idive_parser_vtable = {
 	divesystem_idive_parser_get_datetime, /* datetime */
 	divesystem_idive_parser_get_field, /* fields */
 	divesystem_idive_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -274,6 +276,9 @@ divesystem_idive_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callba
 	unsigned int beginpressure = 0;
 	unsigned int endpressure = 0;
 
+	if (size < parser->headersize)
+		return DC_STATUS_DATAFORMAT;
+
 	unsigned int firmware = 0;
 	unsigned int apos4 = 0;
 	unsigned int nsamples = array_uint16_le (data + 1);
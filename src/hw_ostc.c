@@ -81,6 +81,7 @@ static const dc_device_vtable_t hw_ostc_device_vtable = {
 	NULL, /* write */
 	hw_ostc_device_dump, /* dump */
 	hw_ostc_device_foreach, /* foreach */
+	NULL, /* download */
 	hw_ostc_device_timesync, /* timesync */
 	hw_ostc_device_close /* close */
 };
@@ -149,6 +150,8 @@ hw_ostc_device_open (dc_device_t **out, dc_context_t *context, const char *name)
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -315,7 +318,7 @@ hw_ostc_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 static dc_status_t
 hw_ostc_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
-	dc_buffer_t *buffer = dc_buffer_new (0);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, 0);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
@@ -812,6 +815,8 @@ hw_ostc_firmware_setup (hw_ostc_device_t *device, unsigned int maxretries)
 		// Abort if the maximum number of retries is reached.
 		if (nretries++ >= maxretries)
 			break;
+
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
 	}
 
 	return rc;
@@ -863,6 +868,8 @@ hw_ostc_firmware_write (hw_ostc_device_t *device, unsigned char *data, unsigned
 		// Abort if the maximum number of retries is reached.
 		if (nretries++ >= MAXRETRIES)
 			break;
+
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
 	}
 
 	return rc;
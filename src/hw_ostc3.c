@@ -137,6 +137,7 @@ static const dc_device_vtable_t hw_ostc3_device_vtable = {
 	hw_ostc3_device_write, /* write */
 	hw_ostc3_device_dump, /* dump */
 	hw_ostc3_device_foreach, /* foreach */
+	NULL, /* download */
 	hw_ostc3_device_timesync, /* timesync */
 	hw_ostc3_device_close /* close */
 };
@@ -345,6 +346,8 @@ hw_ostc3_device_open (dc_device_t **out, dc_context_t *context, const char *name
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -1361,7 +1364,7 @@ hw_ostc3_device_fwupdate4 (dc_device_t *abstract, const char *filename)
 	dc_context_t *context = (abstract ? abstract->context : NULL);
 
 	// Allocate memory for the firmware data.
-	dc_buffer_t *buffer = dc_buffer_new (0);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, 0);
 	if (buffer == NULL) {
 		ERROR (context, "Failed to allocate memory.");
 		status = DC_STATUS_NOMEMORY;
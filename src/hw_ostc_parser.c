@@ -69,6 +69,14 @@ typedef struct hw_ostc_sample_info_t {
 	unsigned int size;
 } hw_ostc_sample_info_t;
 
+typedef struct hw_ostc_profile_t {
+	unsigned int samplerate;
+	double hydrostatic;
+	unsigned int nconfig;
+	hw_ostc_sample_info_t info[MAXCONFIG];
+	unsigned int offset;
+} hw_ostc_profile_t;
+
 typedef struct hw_ostc_layout_t {
 	unsigned int datetime;
 	unsigned int maxdepth;
@@ -107,6 +115,7 @@ static dc_status_t hw_ostc_parser_set_data (dc_parser_t *abstract, const unsigne
 static dc_status_t hw_ostc_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t hw_ostc_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t hw_ostc_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns);
 
 static const dc_parser_vtable_t hw_ostc_parser_vtable = {
 	sizeof(hw_ostc_parser_t),
@@ -115,6 +124,8 @@ static const dc_parser_vtable_t hw_ostc_parser_vtable = {
 	hw_ostc_parser_get_datetime, /* datetime */
 	hw_ostc_parser_get_field, /* fields */
 	hw_ostc_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	hw_ostc_parser_samples_columns, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -560,28 +571,16 @@ hw_ostc_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned
 
 
 static dc_status_t
-hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+hw_ostc_parser_profile (hw_ostc_parser_t *parser, hw_ostc_profile_t *profile)
 {
-	hw_ostc_parser_t *parser = (hw_ostc_parser_t *) abstract;
+	dc_parser_t *abstract = (dc_parser_t *) parser;
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
-	// Cache the parser data.
-	dc_status_t rc = hw_ostc_parser_cache (parser);
-	if (rc != DC_STATUS_SUCCESS)
-		return rc;
-
 	unsigned int version = parser->version;
 	unsigned int header = parser->header;
 	const hw_ostc_layout_t *layout = parser->layout;
 
-	// Exit if no profile data available.
-	if (size == header || (size == header + 2 &&
-		data[header] == 0xFD && data[header + 1] == 0xFD)) {
-		parser->cached = PROFILE;
-		return DC_STATUS_SUCCESS;
-	}
-
 	// Check the header length.
 	if (version == 0x23 || version == 0x24) {
 		if (size < header + 5) {
@@ -591,11 +590,10 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 	}
 
 	// Get the sample rate.
-	unsigned int samplerate = 0;
 	if (version == 0x23 || version == 0x24)
-		samplerate = data[header + 3];
+		profile->samplerate = data[header + 3];
 	else
-		samplerate = data[36];
+		profile->samplerate = data[36];
 
 	// Get the salinity factor.
 	unsigned int salinity = data[layout->salinity];
@@ -603,57 +601,55 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 		salinity += 100;
 	if (salinity < 100 || salinity > 104)
 		salinity = 100;
-	double hydrostatic = GRAVITY * salinity * 10.0;
+	profile->hydrostatic = GRAVITY * salinity * 10.0;
 
 	// Get the number of sample descriptors.
-	unsigned int nconfig = 0;
 	if (version == 0x23 || version == 0x24)
-		nconfig = data[header + 4];
+		profile->nconfig = data[header + 4];
 	else
-		nconfig = 6;
-	if (nconfig > MAXCONFIG) {
+		profile->nconfig = 6;
+	if (profile->nconfig > MAXCONFIG) {
 		ERROR(abstract->context, "Too many sample descriptors.");
 		return DC_STATUS_DATAFORMAT;
 	}
 
 	// Check the header length.
 	if (version == 0x23 || version == 0x24) {
-		if (size < header + 5 + 3 * nconfig) {
+		if (size < header + 5 + 3 * profile->nconfig) {
 			ERROR (abstract->context, "Buffer overflow detected!");
 			return DC_STATUS_DATAFORMAT;
 		}
 	}
 
 	// Get the extended sample configuration.
-	hw_ostc_sample_info_t info[MAXCONFIG] = {{0}};
-	for (unsigned int i = 0; i < nconfig; ++i) {
+	for (unsigned int i = 0; i < profile->nconfig; ++i) {
 		if (version == 0x23 || version == 0x24) {
-			info[i].type    = data[header + 5 + 3 * i + 0];
-			info[i].size    = data[header + 5 + 3 * i + 1];
-			info[i].divisor = data[header + 5 + 3 * i + 2];
+			profile->info[i].type    = data[header + 5 + 3 * i + 0];
+			profile->info[i].size    = data[header + 5 + 3 * i + 1];
+			profile->info[i].divisor = data[header + 5 + 3 * i + 2];
 		} else {
-			info[i].type    = i;
-			info[i].divisor = (data[37 + i] & 0x0F);
-			info[i].size    = (data[37 + i] & 0xF0) >> 4;
+			profile->info[i].type    = i;
+			profile->info[i].divisor = (data[37 + i] & 0x0F);
+			profile->info[i].size    = (data[37 + i] & 0xF0) >> 4;
 		}
 
-		if (info[i].divisor) {
-			switch (info[i].type) {
+		if (profile->info[i].divisor) {
+			switch (profile->info[i].type) {
 			case 0: // Temperature
 			case 1: // Deco / NDL
-				if (info[i].size != 2) {
+				if (profile->info[i].size != 2) {
 					ERROR(abstract->context, "Unexpected sample size.");
 					return DC_STATUS_DATAFORMAT;
 				}
 				break;
 			case 3: // ppO2
-				if (info[i].size != 3 && info[i].size != 9) {
+				if (profile->info[i].size != 3 && profile->info[i].size != 9) {
 					ERROR(abstract->context, "Unexpected sample size.");
 					return DC_STATUS_DATAFORMAT;
 				}
 				break;
 			case 5: // CNS
-				if (info[i].size != 1 && info[i].size != 2) {
+				if (profile->info[i].size != 1 && profile->info[i].size != 2) {
 					ERROR(abstract->context, "Unexpected sample size.");
 					return DC_STATUS_DATAFORMAT;
 				}
@@ -664,6 +660,48 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 		}
 	}
 
+	// Offset to the first sample.
+	profile->offset = header;
+	if (version == 0x23 || version == 0x24)
+		profile->offset += 5 + 3 * profile->nconfig;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+{
+	hw_ostc_parser_t *parser = (hw_ostc_parser_t *) abstract;
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	// Cache the parser data.
+	dc_status_t rc = hw_ostc_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	unsigned int version = parser->version;
+	unsigned int header = parser->header;
+	const hw_ostc_layout_t *layout = parser->layout;
+
+	// Exit if no profile data available.
+	if (size == header || (size == header + 2 &&
+		data[header] == 0xFD && data[header + 1] == 0xFD)) {
+		parser->cached = PROFILE;
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Get the sample configuration.
+	hw_ostc_profile_t profile;
+	rc = hw_ostc_parser_profile (parser, &profile);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	unsigned int samplerate = profile.samplerate;
+	double hydrostatic = profile.hydrostatic;
+	unsigned int nconfig = profile.nconfig;
+	const hw_ostc_sample_info_t *info = profile.info;
+
 	// Get the firmware version.
 	unsigned int firmware = 0;
 	if (parser->model == OSTC4) {
@@ -675,9 +713,7 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 	unsigned int time = 0;
 	unsigned int nsamples = 0;
 
-	unsigned int offset = header;
-	if (version == 0x23 || version == 0x24)
-		offset += 5 + 3 * nconfig;
+	unsigned int offset = profile.offset;
 	while (offset + 3 <= size) {
 		dc_sample_value_t sample = {0};
 
@@ -974,3 +1010,113 @@ hw_ostc_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t call
 
 	return DC_STATUS_SUCCESS;
 }
+
+static dc_status_t
+hw_ostc_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns)
+{
+	hw_ostc_parser_t *parser = (hw_ostc_parser_t *) abstract;
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	// Only the columns that are present in every sample are supported.
+	// The others depend on the events and the firmware version.
+	if (columns->fields || columns->ppo2 || columns->cns ||
+		columns->deco_type || columns->deco_time || columns->deco_depth)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Cache the parser data.
+	dc_status_t rc = hw_ostc_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Cache the profile data. The profile is validated, such that the
+	// samples can be decoded without any further checks.
+	if (parser->cached < PROFILE) {
+		rc = hw_ostc_parser_samples_foreach (abstract, NULL, NULL);
+		if (rc != DC_STATUS_SUCCESS)
+			return rc;
+	}
+
+	unsigned int version = parser->version;
+	unsigned int header = parser->header;
+
+	// Exit if no profile data available.
+	if (size == header || (size == header + 2 &&
+		data[header] == 0xFD && data[header + 1] == 0xFD)) {
+		columns->count = 0;
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Get the sample configuration.
+	hw_ostc_profile_t profile;
+	rc = hw_ostc_parser_profile (parser, &profile);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	unsigned int nsamples = 0;
+	unsigned int offset = profile.offset;
+	while (offset + 3 <= size) {
+		unsigned int store = nsamples < columns->capacity;
+
+		dc_sample_columns_clear (columns, nsamples, 1);
+
+		nsamples++;
+
+		// Time (seconds).
+		if (store && columns->time)
+			columns->time[nsamples - 1] = nsamples * profile.samplerate;
+
+		// Depth (mbar).
+		if (store && columns->depth)
+			columns->depth[nsamples - 1] = (array_uint16_le (data + offset) * BAR / 1000.0) / profile.hydrostatic;
+		offset += 2;
+
+		// Extended sample info.
+		unsigned int length = data[offset] & 0x7F;
+		offset += 1;
+
+		// Get the event byte(s).
+		unsigned int nbits = 0;
+		unsigned int events = 0;
+		while (data[offset - 1] & 0x80) {
+			if (nbits && version != 0x23 && version != 0x24)
+				break;
+			events |= data[offset] << nbits;
+			nbits += 8;
+			offset++;
+			length--;
+		}
+
+		// Skip the gas mix and setpoint changes.
+		unsigned int skip = 0;
+		if (events & 0x10)
+			skip += 2;
+		if (events & 0x20)
+			skip += 1;
+		if (version == 0x23 || version == 0x24) {
+			if (events & 0x40)
+				skip += 1;
+			if (events & 0x0100)
+				skip += 2;
+		}
+		offset += skip;
+		length -= skip;
+
+		// Temperature (0.1 °C).
+		for (unsigned int i = 0; i < profile.nconfig; ++i) {
+			if (profile.info[i].divisor && (nsamples % profile.info[i].divisor) == 0) {
+				if (profile.info[i].type == 0 && store && columns->temperature)
+					columns->temperature[nsamples - 1] = array_uint16_le (data + offset) / 10.0;
+				offset += profile.info[i].size;
+				length -= profile.info[i].size;
+			}
+		}
+
+		// Skip the remaining sample bytes.
+		offset += length;
+	}
+
+	columns->count = nsamples;
+
+	return DC_STATUS_SUCCESS;
+}
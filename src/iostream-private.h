@@ -25,6 +25,7 @@
 #include <libdivecomputer/common.h>
 #include <libdivecomputer/context.h>
 #include <libdivecomputer/iostream.h>
+#include <libdivecomputer/device.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -32,9 +33,22 @@ extern "C" {
 
 typedef struct dc_iostream_vtable_t dc_iostream_vtable_t;
 
+/*
+ * A pending asynchronous transfer.
+ */
+typedef struct dc_iostream_async_t {
+	unsigned char *data;
+	size_t size;
+	size_t nbytes;
+	dc_iostream_callback_t callback;
+	void *userdata;
+} dc_iostream_async_t;
+
 struct dc_iostream_t {
 	const dc_iostream_vtable_t *vtable;
 	dc_context_t *context;
+	dc_iostream_async_t pending;
+	dc_event_stats_t *stats;
 };
 
 struct dc_iostream_vtable_t {
@@ -56,6 +70,8 @@ struct dc_iostream_vtable_t {
 
 	dc_status_t (*get_available) (dc_iostream_t *iostream, size_t *value);
 
+	dc_status_t (*get_handle) (dc_iostream_t *iostream, int *value);
+
 	dc_status_t (*configure) (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
 
 	dc_status_t (*read) (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
@@ -77,6 +93,9 @@ dc_iostream_allocate (dc_context_t *context, const dc_iostream_vtable_t *vtable)
 void
 dc_iostream_deallocate (dc_iostream_t *iostream);
 
+void
+dc_iostream_set_stats (dc_iostream_t *iostream, dc_event_stats_t *stats);
+
 int
 dc_iostream_isinstance (dc_iostream_t *iostream, const dc_iostream_vtable_t *vtable);
 
@@ -21,6 +21,7 @@
 
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "iostream-private.h"
@@ -35,7 +36,7 @@ dc_iostream_allocate (dc_context_t *context, const dc_iostream_vtable_t *vtable)
 	assert(vtable->size >= sizeof(dc_iostream_t));
 
 	// Allocate memory.
-	iostream = (dc_iostream_t *) malloc (vtable->size);
+	iostream = (dc_iostream_t *) dc_context_allocate (context, vtable->size);
 	if (iostream == NULL) {
 		ERROR (context, "Failed to allocate memory.");
 		return iostream;
@@ -44,6 +45,8 @@ dc_iostream_allocate (dc_context_t *context, const dc_iostream_vtable_t *vtable)
 	// Initialize the base class.
 	iostream->vtable = vtable;
 	iostream->context = context;
+	memset (&iostream->pending, 0, sizeof (iostream->pending));
+	iostream->stats = NULL;
 
 	return iostream;
 }
@@ -51,7 +54,10 @@ dc_iostream_allocate (dc_context_t *context, const dc_iostream_vtable_t *vtable)
 void
 dc_iostream_deallocate (dc_iostream_t *iostream)
 {
-	free (iostream);
+	if (iostream == NULL)
+		return;
+
+	dc_context_deallocate (iostream->context, iostream);
 }
 
 int
@@ -63,6 +69,15 @@ dc_iostream_isinstance (dc_iostream_t *iostream, const dc_iostream_vtable_t *vta
 	return iostream->vtable == vtable;
 }
 
+void
+dc_iostream_set_stats (dc_iostream_t *iostream, dc_event_stats_t *stats)
+{
+	if (iostream == NULL)
+		return;
+
+	iostream->stats = stats;
+}
+
 dc_status_t
 dc_iostream_set_timeout (dc_iostream_t *iostream, int timeout)
 {
@@ -147,6 +162,15 @@ dc_iostream_get_available (dc_iostream_t *iostream, size_t *value)
 	return iostream->vtable->get_available (iostream, value);
 }
 
+dc_status_t
+dc_iostream_get_handle (dc_iostream_t *iostream, int *value)
+{
+	if (iostream == NULL || iostream->vtable->get_handle == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	return iostream->vtable->get_handle (iostream, value);
+}
+
 dc_status_t
 dc_iostream_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
 {
@@ -174,6 +198,11 @@ dc_iostream_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actu
 
 	HEXDUMP (iostream->context, DC_LOGLEVEL_INFO, "Read", (unsigned char *) data, nbytes);
 
+	if (iostream->stats) {
+		iostream->stats->nread += nbytes;
+		iostream->stats->ncalls++;
+	}
+
 out:
 	if (actual)
 		*actual = nbytes;
@@ -196,6 +225,11 @@ dc_iostream_write (dc_iostream_t *iostream, const void *data, size_t size, size_
 
 	HEXDUMP (iostream->context, DC_LOGLEVEL_INFO, "Write", (const unsigned char *) data, nbytes);
 
+	if (iostream->stats) {
+		iostream->stats->nwritten += nbytes;
+		iostream->stats->ncalls++;
+	}
+
 out:
 	if (actual)
 		*actual = nbytes;
@@ -233,9 +267,123 @@ dc_iostream_sleep (dc_iostream_t *iostream, unsigned int milliseconds)
 
 	INFO (iostream->context, "Sleep: value=%u", milliseconds);
 
+	if (iostream->stats) {
+		iostream->stats->sleeptime += milliseconds;
+	}
+
 	return iostream->vtable->sleep (iostream, milliseconds);
 }
 
+static void
+dc_iostream_complete (dc_iostream_t *iostream, dc_status_t status)
+{
+	dc_iostream_async_t pending = iostream->pending;
+
+	// Clear the pending transfer first, such that the callback is
+	// allowed to start the next one.
+	memset (&iostream->pending, 0, sizeof (iostream->pending));
+
+	pending.callback (iostream, status, pending.nbytes, pending.userdata);
+}
+
+dc_status_t
+dc_iostream_read_async (dc_iostream_t *iostream, void *data, size_t size, dc_iostream_callback_t callback, void *userdata)
+{
+	if (iostream == NULL || iostream->vtable->read == NULL || iostream->vtable->get_available == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (callback == NULL || (data == NULL && size))
+		return DC_STATUS_INVALIDARGS;
+
+	if (iostream->pending.callback) {
+		ERROR (iostream->context, "An asynchronous read is already pending.");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	iostream->pending.data = (unsigned char *) data;
+	iostream->pending.size = size;
+	iostream->pending.nbytes = 0;
+	iostream->pending.callback = callback;
+	iostream->pending.userdata = userdata;
+
+	// Consume the data that is already available.
+	return dc_iostream_process (iostream);
+}
+
+dc_status_t
+dc_iostream_write_async (dc_iostream_t *iostream, const void *data, size_t size, dc_iostream_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	size_t nbytes = 0;
+
+	if (callback == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// The write is synchronous. The callback is invoked before returning.
+	status = dc_iostream_write (iostream, data, size, &nbytes);
+	if (status == DC_STATUS_UNSUPPORTED || status == DC_STATUS_INVALIDARGS)
+		return status;
+
+	callback (iostream, status, nbytes, userdata);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_iostream_process (dc_iostream_t *iostream)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (iostream == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (iostream->pending.callback == NULL)
+		return DC_STATUS_SUCCESS;
+
+	while (iostream->pending.nbytes < iostream->pending.size) {
+		// Query the number of bytes that can be read without blocking.
+		size_t available = 0;
+		status = iostream->vtable->get_available (iostream, &available);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (iostream->context, "Failed to get the number of available bytes.");
+			dc_iostream_complete (iostream, status);
+			return status;
+		}
+
+		if (available == 0)
+			return DC_STATUS_SUCCESS;
+
+		size_t len = iostream->pending.size - iostream->pending.nbytes;
+		if (len > available)
+			len = available;
+
+		size_t nbytes = 0;
+		status = dc_iostream_read (iostream, iostream->pending.data + iostream->pending.nbytes, len, &nbytes);
+		iostream->pending.nbytes += nbytes;
+		if (status != DC_STATUS_SUCCESS) {
+			dc_iostream_complete (iostream, status);
+			return status;
+		}
+	}
+
+	dc_iostream_complete (iostream, DC_STATUS_SUCCESS);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_iostream_cancel (dc_iostream_t *iostream)
+{
+	if (iostream == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (iostream->pending.callback) {
+		dc_iostream_complete (iostream, DC_STATUS_CANCELLED);
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_status_t
 dc_iostream_close (dc_iostream_t *iostream)
 {
@@ -244,6 +392,8 @@ dc_iostream_close (dc_iostream_t *iostream)
 	if (iostream == NULL)
 		return DC_STATUS_SUCCESS;
 
+	dc_iostream_cancel (iostream);
+
 	if (iostream->vtable->close) {
 		status = iostream->vtable->close (iostream);
 	}
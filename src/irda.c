@@ -63,6 +63,7 @@ static const dc_iostream_vtable_t dc_irda_vtable = {
 	dc_socket_set_rts, /* set_rts */
 	dc_socket_get_lines, /* get_lines */
 	dc_socket_get_available, /* get_received */
+	dc_socket_get_handle, /* get_handle */
 	dc_socket_configure, /* configure */
 	dc_socket_read, /* read */
 	dc_socket_write, /* write */
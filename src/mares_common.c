@@ -132,6 +132,7 @@ mares_common_packet (mares_common_device_t *device, const unsigned char command[
 	array_convert_hex2bin (answer + asize - 3, 2, &crc, 1);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -154,6 +155,8 @@ mares_common_transfer (mares_common_device_t *device, const unsigned char comman
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
+
 		// Discard any garbage bytes.
 		dc_iostream_sleep (device->iostream, 100);
 		dc_iostream_purge (device->iostream, DC_DIRECTION_INPUT);
@@ -203,6 +206,30 @@ mares_common_device_read (dc_device_t *abstract, unsigned int address, unsigned
 }
 
 
+/*
+ * Get a pointer to size bytes of the profile ringbuffer, at the given
+ * offset from the end of profile pointer. If the range does not wrap
+ * around the end of the ringbuffer, the pointer points directly into
+ * the memory dump. Otherwise the bytes are copied to the buffer.
+ */
+static const unsigned char *
+mares_common_profile (const mares_common_layout_t *layout, const unsigned char data[], unsigned int eop, unsigned int offset, unsigned int size, unsigned char buffer[])
+{
+	unsigned int wrap = layout->rb_profile_end - eop;
+
+	if (offset + size <= wrap)
+		return data + eop + offset;
+
+	if (offset >= wrap)
+		return data + layout->rb_profile_begin + (offset - wrap);
+
+	memcpy (buffer + 0, data + eop + offset, wrap - offset);
+	memcpy (buffer + wrap - offset, data + layout->rb_profile_begin, offset + size - wrap);
+
+	return buffer;
+}
+
+
 dc_status_t
 mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *layout, const unsigned char fingerprint[], const unsigned char data[], dc_dive_callback_t callback, void *userdata)
 {
@@ -221,9 +248,11 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 		return DC_STATUS_DATAFORMAT;
 	}
 
-	// Make the ringbuffer linear, to avoid having to deal
-	// with the wrap point. The buffer has extra space to
-	// store the profile data for the freedives.
+	// Only a dive that wraps around the end of the ringbuffer, or a
+	// freedive session that gets its profile data appended, needs to
+	// be copied. All other dives are passed directly from the memory
+	// dump. The buffer has extra space to store the profile data for
+	// the freedives.
 	unsigned char *buffer = (unsigned char *) malloc (
 		layout->rb_profile_end - layout->rb_profile_begin +
 		layout->rb_freedives_end - layout->rb_freedives_begin);
@@ -232,9 +261,6 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 		return DC_STATUS_NOMEMORY;
 	}
 
-	memcpy (buffer + 0, data + eop, layout->rb_profile_end - eop);
-	memcpy (buffer + layout->rb_profile_end - eop, data + layout->rb_profile_begin, eop - layout->rb_profile_begin);
-
 	// For a freedive session, the Mares Nemo stores all the freedives of
 	// that session in a single logbook entry, and each sample is actually
 	// a summary for each individual freedive in the session. The profile
@@ -245,11 +271,13 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 
 	unsigned int offset = layout->rb_profile_end - layout->rb_profile_begin;
 	while (offset >= 3) {
+		unsigned char tmp[3];
+
 		// Check for the presence of extra header bytes, which can be detected
 		// by means of a three byte marker sequence.
 		unsigned int extra = 0;
 		const unsigned char marker[3] = {0xAA, 0xBB, 0xCC};
-		if (memcmp (buffer + offset - 3, marker, sizeof (marker)) == 0) {
+		if (memcmp (mares_common_profile (layout, data, eop, offset - 3, 3, tmp), marker, sizeof (marker)) == 0) {
 			if (model == PUCKAIR)
 				extra = 7;
 			else
@@ -265,7 +293,8 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 		// If the ringbuffer has never reached the wrap point before,
 		// there will be "empty" memory (filled with 0xFF) and
 		// processing should stop at this point.
-		unsigned int mode = buffer[offset - extra - 1];
+		const unsigned char *trailer = mares_common_profile (layout, data, eop, offset - extra - 3, 3, tmp);
+		unsigned int mode = trailer[2];
 		if (mode == 0xFF)
 			break;
 
@@ -286,7 +315,7 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 		}
 
 		// Get the number of samples in the profile data.
-		unsigned int nsamples = array_uint16_le (buffer + offset - extra - 3);
+		unsigned int nsamples = array_uint16_le (trailer);
 
 		// Calculate the total number of bytes for this dive.
 		// If the buffer does not contain that much bytes, we reached the
@@ -299,10 +328,12 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 		// Move to the start of the dive.
 		offset -= nbytes;
 
+		const unsigned char *dive = mares_common_profile (layout, data, eop, offset, nbytes, buffer);
+
 		// Verify that the length that is stored in the profile data
 		// equals the calculated length. If both values are different,
 		// something is wrong and an error is returned.
-		unsigned int length = array_uint16_le (buffer + offset);
+		unsigned int length = array_uint16_le (dive);
 		if (length != nbytes) {
 			ERROR (context, "Calculated and stored size are not equal (%u %u).", length, nbytes);
 			free (buffer);
@@ -338,19 +369,21 @@ mares_common_extract_dives (dc_context_t *context, const mares_common_layout_t *
 			}
 
 			// Append the profile data to the main logbook entry. The
-			// buffer is guaranteed to have enough space, and the dives
-			// that will be overwritten have already been processed.
-			memcpy (buffer + offset + nbytes, data + layout->rb_freedives_begin, idx - layout->rb_freedives_begin);
+			// buffer is guaranteed to have enough space.
+			if (dive != buffer)
+				memcpy (buffer, dive, nbytes);
+			memcpy (buffer + nbytes, data + layout->rb_freedives_begin, idx - layout->rb_freedives_begin);
 			nbytes += idx - layout->rb_freedives_begin;
+			dive = buffer;
 		}
 
-		unsigned int fp_offset = offset + length - extra - FP_OFFSET;
-		if (fingerprint && memcmp (buffer + fp_offset, fingerprint, FP_SIZE) == 0) {
+		unsigned int fp_offset = length - extra - FP_OFFSET;
+		if (fingerprint && memcmp (dive + fp_offset, fingerprint, FP_SIZE) == 0) {
 			free (buffer);
 			return DC_STATUS_SUCCESS;
 		}
 
-		if (callback && !callback (buffer + offset, nbytes, buffer + fp_offset, FP_SIZE, userdata)) {
+		if (callback && !callback (dive, nbytes, dive + fp_offset, FP_SIZE, userdata)) {
 			free (buffer);
 			return DC_STATUS_SUCCESS;
 		}
@@ -30,12 +30,17 @@
 #include "context-private.h"
 #include "device-private.h"
 #include "array.h"
+#include "ringbuffer.h"
+#include "pagecache.h"
 
 #define ISINSTANCE(device) dc_device_isinstance((device), &mares_darwin_device_vtable)
 
 #define DARWIN    0
 #define DARWINAIR 1
 
+#define SZ_HEADER 0x100
+#define EOP       0x8A
+
 typedef struct mares_darwin_layout_t {
 	// Memory size.
 	unsigned int memsize;
@@ -70,6 +75,7 @@ static const dc_device_vtable_t mares_darwin_device_vtable = {
 	NULL, /* write */
 	mares_darwin_device_dump, /* dump */
 	mares_darwin_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	mares_darwin_device_close /* close */
 };
@@ -131,6 +137,8 @@ mares_darwin_device_open (dc_device_t **out, dc_context_t *context, const char *
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->base.iostream);
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->base.iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -216,18 +224,61 @@ static dc_status_t
 mares_darwin_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 {
 	mares_darwin_device_t *device = (mares_darwin_device_t *) abstract;
+	const mares_darwin_layout_t *layout = device->layout;
+	dc_pagecache_t *pagecache = NULL;
 
-	assert (device->layout != NULL);
+	assert (layout != NULL);
 
 	// Erase the current contents of the buffer and
 	// allocate the required amount of memory.
-	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, device->layout->memsize)) {
+	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, layout->memsize)) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
 		return DC_STATUS_NOMEMORY;
 	}
 
-	return device_dump_read (abstract, dc_buffer_get_data (buffer),
-		dc_buffer_get_size (buffer), PACKETSIZE);
+	unsigned char *data = dc_buffer_get_data (buffer);
+
+	// Read the header, which contains the serial number and the end of
+	// profile pointer.
+	dc_status_t rc = mares_common_device_read (abstract, 0, data, SZ_HEADER);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read the header.");
+		return rc;
+	}
+
+	rc = dc_pagecache_new (&pagecache, abstract, array_uint16_be (data + 8), layout->memsize, PACKETSIZE);
+	if (rc != DC_STATUS_SUCCESS) {
+		return rc;
+	}
+
+	// New dives are appended to the profile ringbuffer, starting at the
+	// previous end of profile pointer. Only that part of the ringbuffer,
+	// and the header and logbook area, can be different from the cached
+	// data. Data from a different device is never re-used.
+	unsigned char serial[2] = {0};
+	unsigned char previous[2] = {0};
+	rc = dc_pagecache_get (pagecache, 8, serial, sizeof (serial));
+	if (rc == DC_STATUS_SUCCESS)
+		rc = dc_pagecache_get (pagecache, EOP, previous, sizeof (previous));
+	unsigned int begin = array_uint16_be (previous);
+	unsigned int end = array_uint16_be (data + EOP);
+	if (rc == DC_STATUS_SUCCESS && memcmp (serial, data + 8, sizeof (serial)) == 0 &&
+		begin >= layout->rb_profile_begin && begin < layout->rb_profile_end &&
+		end >= layout->rb_profile_begin && end < layout->rb_profile_end) {
+		unsigned int length = ringbuffer_distance (begin, end, 0, layout->rb_profile_begin, layout->rb_profile_end);
+		dc_pagecache_invalidate_ringbuffer (pagecache, layout->rb_profile_begin, layout->rb_profile_end, begin, length + PACKETSIZE);
+		dc_pagecache_invalidate (pagecache, 0, layout->rb_profile_begin);
+	} else {
+		dc_pagecache_invalidate (pagecache, 0, layout->memsize);
+	}
+
+	dc_pagecache_put (pagecache, 0, data, SZ_HEADER);
+
+	rc = dc_pagecache_dump (pagecache, data, layout->memsize, PACKETSIZE);
+
+	dc_pagecache_free (pagecache);
+
+	return rc;
 }
 
 
@@ -238,7 +289,7 @@ mares_darwin_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback,
 
 	assert (device->layout != NULL);
 
-	dc_buffer_t *buffer = dc_buffer_new (device->layout->memsize);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, device->layout->memsize);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
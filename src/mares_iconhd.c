@@ -29,6 +29,8 @@
 #include "serial.h"
 #include "array.h"
 #include "rbstream.h"
+#include "pagecache.h"
+#include "ringbuffer.h"
 
 #define C_ARRAY_SIZE(array) (sizeof (array) / sizeof *(array))
 
@@ -88,6 +90,7 @@ static const dc_device_vtable_t mares_iconhd_device_vtable = {
 	NULL, /* write */
 	mares_iconhd_device_dump, /* dump */
 	mares_iconhd_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	mares_iconhd_device_close /* close */
 };
@@ -176,6 +179,7 @@ mares_iconhd_transfer (mares_iconhd_device_t *device,
 	// Verify the header byte.
 	if (header[0] != ACK) {
 		ERROR (abstract->context, "Unexpected answer byte.");
+		device_stats_increment (abstract, DEVICE_STATS_NAK);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -244,6 +248,8 @@ mares_iconhd_device_open (dc_device_t **out, dc_context_t *context, const char *
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8E1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_EVEN, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -398,14 +404,29 @@ mares_iconhd_device_read (dc_device_t *abstract, unsigned int address, unsigned
 }
 
 
+static unsigned int
+mares_iconhd_get_eop (const unsigned char first[], const unsigned char second[])
+{
+	// The end of profile pointer is stored in the second configuration
+	// area if the first one is erased.
+	unsigned int eop = array_uint32_le (first);
+	if (eop == 0xFFFFFFFF)
+		eop = array_uint32_le (second);
+
+	return eop;
+}
+
+
 static dc_status_t
 mares_iconhd_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 {
 	mares_iconhd_device_t *device = (mares_iconhd_device_t *) abstract;
+	const mares_iconhd_layout_t *layout = device->layout;
+	dc_pagecache_t *pagecache = NULL;
 
 	// Erase the current contents of the buffer and
 	// pre-allocate the required amount of memory.
-	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, device->layout->memsize)) {
+	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, layout->memsize)) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
 		return DC_STATUS_NOMEMORY;
 	}
@@ -416,8 +437,52 @@ mares_iconhd_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 	vendor.size = sizeof (device->version);
 	device_event_emit (abstract, DC_EVENT_VENDOR, &vendor);
 
-	return device_dump_read (abstract, dc_buffer_get_data (buffer),
-		dc_buffer_get_size (buffer), device->packetsize);
+	unsigned char *data = dc_buffer_get_data (buffer);
+
+	// Read the memory in front of the profile ringbuffer, which contains
+	// the serial number and the end of profile pointer.
+	dc_status_t rc = mares_iconhd_device_read (abstract, 0, data, layout->rb_profile_begin);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read the memory.");
+		return rc;
+	}
+
+	rc = dc_pagecache_new (&pagecache, abstract, array_uint32_le (data + 0x0C), layout->memsize, device->packetsize);
+	if (rc != DC_STATUS_SUCCESS) {
+		return rc;
+	}
+
+	// New dives are appended to the profile ringbuffer, starting at the
+	// previous end of profile pointer. Only that part of the ringbuffer,
+	// and the memory outside the ringbuffer, can be different from the
+	// cached data. Data from a different device is never re-used.
+	unsigned char serial[4] = {0};
+	unsigned char previous[2][4] = {{0}};
+	rc = dc_pagecache_get (pagecache, 0x0C, serial, sizeof (serial));
+	if (rc == DC_STATUS_SUCCESS)
+		rc = dc_pagecache_get (pagecache, 0x2001, previous[0], sizeof (previous[0]));
+	if (rc == DC_STATUS_SUCCESS)
+		rc = dc_pagecache_get (pagecache, 0x3001, previous[1], sizeof (previous[1]));
+	unsigned int begin = mares_iconhd_get_eop (previous[0], previous[1]);
+	unsigned int end = mares_iconhd_get_eop (data + 0x2001, data + 0x3001);
+	if (rc == DC_STATUS_SUCCESS && memcmp (serial, data + 0x0C, sizeof (serial)) == 0 &&
+		begin >= layout->rb_profile_begin && begin < layout->rb_profile_end &&
+		end >= layout->rb_profile_begin && end < layout->rb_profile_end) {
+		unsigned int length = ringbuffer_distance (begin, end, 0, layout->rb_profile_begin, layout->rb_profile_end);
+		dc_pagecache_invalidate_ringbuffer (pagecache, layout->rb_profile_begin, layout->rb_profile_end, begin, length + device->packetsize);
+		dc_pagecache_invalidate (pagecache, 0, layout->rb_profile_begin);
+		dc_pagecache_invalidate (pagecache, layout->rb_profile_end, layout->memsize - layout->rb_profile_end);
+	} else {
+		dc_pagecache_invalidate (pagecache, 0, layout->memsize);
+	}
+
+	dc_pagecache_put (pagecache, 0, data, layout->rb_profile_begin);
+
+	rc = dc_pagecache_dump (pagecache, data, layout->memsize, device->packetsize);
+
+	dc_pagecache_free (pagecache);
+
+	return rc;
 }
 
 
@@ -20,12 +20,14 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <libdivecomputer/units.h>
 
 #include "mares_iconhd.h"
 #include "context-private.h"
 #include "parser-private.h"
+#include "iterator-private.h"
 #include "array.h"
 
 #define ISINSTANCE(parser) dc_parser_isinstance((parser), &mares_iconhd_parser_vtable)
@@ -67,6 +69,8 @@ static dc_status_t mares_iconhd_parser_set_data (dc_parser_t *abstract, const un
 static dc_status_t mares_iconhd_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t mares_iconhd_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t mares_iconhd_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t mares_iconhd_parser_samples_iterator (dc_parser_t *abstract, dc_iterator_t **iterator);
+static dc_status_t mares_iconhd_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns);
 
 static const dc_parser_vtable_t mares_iconhd_parser_vtable = {
 	sizeof(mares_iconhd_parser_t),
@@ -75,9 +79,28 @@ static const dc_parser_vtable_t mares_iconhd_parser_vtable = {
 	mares_iconhd_parser_get_datetime, /* datetime */
 	mares_iconhd_parser_get_field, /* fields */
 	mares_iconhd_parser_samples_foreach, /* samples_foreach */
+	mares_iconhd_parser_samples_iterator, /* samples_iterator */
+	mares_iconhd_parser_samples_columns, /* samples_columns */
 	NULL /* destroy */
 };
 
+typedef struct mares_iconhd_sample_iterator_t {
+	dc_iterator_t base;
+	mares_iconhd_parser_t *parser;
+	unsigned int nsamples;
+	unsigned int offset;
+	unsigned int time;
+	unsigned int gasmix_previous;
+} mares_iconhd_sample_iterator_t;
+
+static dc_status_t mares_iconhd_sample_iterator_free (dc_iterator_t *iterator);
+static dc_status_t mares_iconhd_sample_iterator_next (dc_iterator_t *iterator, void *item);
+
+static const dc_iterator_vtable_t mares_iconhd_sample_iterator_vtable = {
+	mares_iconhd_sample_iterator_free,
+	mares_iconhd_sample_iterator_next
+};
+
 static dc_status_t
 mares_iconhd_parser_cache (mares_iconhd_parser_t *parser)
 {
@@ -629,3 +652,214 @@ mares_iconhd_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t
 
 	return DC_STATUS_SUCCESS;
 }
+
+
+static dc_status_t
+mares_iconhd_parser_samples_iterator (dc_parser_t *abstract, dc_iterator_t **out)
+{
+	mares_iconhd_parser_t *parser = (mares_iconhd_parser_t *) abstract;
+	mares_iconhd_sample_iterator_t *iterator = NULL;
+
+	// Cache the parser data.
+	dc_status_t rc = mares_iconhd_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Only the regular dives have fixed-size samples.
+	if (parser->model == SMARTAPNEA || parser->mode == FREEDIVE)
+		return DC_STATUS_UNSUPPORTED;
+
+	iterator = (mares_iconhd_sample_iterator_t *) dc_context_allocate (abstract->context, sizeof (mares_iconhd_sample_iterator_t));
+	if (iterator == NULL) {
+		ERROR (abstract->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	iterator->base.vtable = &mares_iconhd_sample_iterator_vtable;
+	iterator->parser = parser;
+	iterator->nsamples = 0;
+	iterator->offset = 4;
+	iterator->time = 0;
+	iterator->gasmix_previous = 0xFFFFFFFF;
+
+	*out = (dc_iterator_t *) iterator;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+mares_iconhd_sample_iterator_free (dc_iterator_t *abstract)
+{
+	mares_iconhd_sample_iterator_t *iterator = (mares_iconhd_sample_iterator_t *) abstract;
+
+	dc_context_deallocate (iterator->parser->base.context, iterator);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+mares_iconhd_sample_iterator_next (dc_iterator_t *abstract, void *out)
+{
+	mares_iconhd_sample_iterator_t *iterator = (mares_iconhd_sample_iterator_t *) abstract;
+	mares_iconhd_parser_t *parser = iterator->parser;
+	dc_context_t *context = parser->base.context;
+	const unsigned char *data = parser->base.data;
+	dc_sample_t *sample = (dc_sample_t *) out;
+
+	if (iterator->nsamples >= parser->nsamples)
+		return DC_STATUS_DONE;
+
+	unsigned int offset = iterator->offset;
+
+	memset (sample, 0, sizeof (dc_sample_t));
+
+	// Time (seconds).
+	iterator->time += parser->interval;
+	sample->time = iterator->time;
+
+	// Depth (1/10 m).
+	sample->depth = array_uint16_le (data + offset + 0) / 10.0;
+
+	// Temperature (1/10 °C).
+	sample->temperature = (array_uint16_le (data + offset + 2) & 0x0FFF) / 10.0;
+
+	sample->fields =
+		(1 << DC_SAMPLE_TIME) |
+		(1 << DC_SAMPLE_DEPTH) |
+		(1 << DC_SAMPLE_TEMPERATURE);
+
+	// Current gas mix
+	unsigned int gasmix = (data[offset + 3] & 0xF0) >> 4;
+	if (parser->ngasmixes > 0) {
+		if (gasmix >= parser->ngasmixes) {
+			ERROR (context, "Invalid gas mix index.");
+			return DC_STATUS_DATAFORMAT;
+		}
+		if (gasmix != iterator->gasmix_previous) {
+			sample->gasmix = gasmix;
+			sample->fields |= (1 << DC_SAMPLE_GASMIX);
+			iterator->gasmix_previous = gasmix;
+		}
+	}
+
+	offset += parser->samplesize;
+	iterator->nsamples++;
+
+	// Some extra data.
+	if ((parser->model == ICONHDNET || parser->model == QUADAIR) && (iterator->nsamples % 4) == 0) {
+		// Pressure (1/100 bar).
+		unsigned int pressure = array_uint16_le(data + offset);
+		if (gasmix < parser->ntanks) {
+			sample->pressure[0].tank = gasmix;
+			sample->pressure[0].value = pressure / 100.0;
+			sample->npressures = 1;
+			sample->fields |= (1 << DC_SAMPLE_PRESSURE);
+		} else if (pressure != 0) {
+			WARNING (context, "Invalid tank with non-zero pressure.");
+		}
+
+		offset += 8;
+	}
+
+	iterator->offset = offset;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+mares_iconhd_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns)
+{
+	mares_iconhd_parser_t *parser = (mares_iconhd_parser_t *) abstract;
+
+	// Cache the parser data.
+	dc_status_t rc = mares_iconhd_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Only the regular dives have fixed-size samples.
+	if (parser->model == SMARTAPNEA || parser->mode == FREEDIVE)
+		return DC_STATUS_UNSUPPORTED;
+
+	const unsigned char *data = abstract->data;
+
+	// Models with tank pressure have an extra block after every 4 samples.
+	unsigned int extra = 0;
+	if (parser->model == ICONHDNET || parser->model == QUADAIR)
+		extra = 8;
+
+	unsigned int nrows = parser->nsamples;
+	if (nrows > columns->capacity)
+		nrows = columns->capacity;
+
+	dc_sample_columns_clear (columns, 0, nrows);
+
+	// Time (seconds).
+	if (columns->time) {
+		for (unsigned int i = 0; i < nrows; ++i) {
+			columns->time[i] = (i + 1) * parser->interval;
+		}
+	}
+
+	// Depth (1/10 m) and temperature (1/10 °C).
+	if (columns->depth || columns->temperature) {
+		unsigned int offset = 4;
+		for (unsigned int i = 0; i < nrows; ++i) {
+			if (columns->depth)
+				columns->depth[i] = array_uint16_le (data + offset + 0) / 10.0;
+			if (columns->temperature)
+				columns->temperature[i] = (array_uint16_le (data + offset + 2) & 0x0FFF) / 10.0;
+			offset += parser->samplesize;
+			if ((i % 4) == 3)
+				offset += extra;
+		}
+	}
+
+	// The gas mixes and tank pressures are checked for all samples,
+	// including the ones that don't fit, to report the same errors
+	// as the callback based path.
+	unsigned int gasmix_previous = 0xFFFFFFFF;
+	unsigned int offset = 4;
+	for (unsigned int i = 0; i < parser->nsamples; ++i) {
+		unsigned int fields =
+			(1 << DC_SAMPLE_TIME) |
+			(1 << DC_SAMPLE_DEPTH) |
+			(1 << DC_SAMPLE_TEMPERATURE);
+
+		// Current gas mix
+		unsigned int gasmix = (data[offset + 3] & 0xF0) >> 4;
+		if (parser->ngasmixes > 0) {
+			if (gasmix >= parser->ngasmixes) {
+				ERROR (abstract->context, "Invalid gas mix index.");
+				return DC_STATUS_DATAFORMAT;
+			}
+			if (gasmix != gasmix_previous) {
+				fields |= (1 << DC_SAMPLE_GASMIX);
+				gasmix_previous = gasmix;
+			}
+		}
+
+		offset += parser->samplesize;
+
+		if (extra && (i % 4) == 3) {
+			// Pressure (1/100 bar).
+			unsigned int pressure = array_uint16_le(data + offset);
+			if (gasmix < parser->ntanks) {
+				if (i < nrows && columns->pressure && gasmix < columns->ntanks)
+					columns->pressure[gasmix * columns->capacity + i] = pressure / 100.0;
+				fields |= (1 << DC_SAMPLE_PRESSURE);
+			} else if (pressure != 0) {
+				WARNING (abstract->context, "Invalid tank with non-zero pressure.");
+			}
+
+			offset += extra;
+		}
+
+		if (i < nrows && columns->fields)
+			columns->fields[i] = fields;
+	}
+
+	columns->count = parser->nsamples;
+
+	return DC_STATUS_SUCCESS;
+}
@@ -62,6 +62,7 @@ static const dc_device_vtable_t mares_nemo_device_vtable = {
 	NULL, /* write */
 	mares_nemo_device_dump, /* dump */
 	mares_nemo_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	mares_nemo_device_close /* close */
 };
@@ -110,6 +111,8 @@ mares_nemo_device_open (dc_device_t **out, dc_context_t *context, const char *na
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -266,6 +269,7 @@ mares_nemo_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 			dc_buffer_append (buffer, packet + PACKETSIZE + 1, PACKETSIZE);
 		} else {
 			ERROR (abstract->context, "Unexpected answer checksum.");
+			device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 			return DC_STATUS_PROTOCOL;
 		}
 
@@ -285,7 +289,7 @@ mares_nemo_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, v
 {
 	mares_nemo_device_t *device = (mares_nemo_device_t *) abstract;
 
-	dc_buffer_t *buffer = dc_buffer_new (MEMORYSIZE);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, MEMORYSIZE);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
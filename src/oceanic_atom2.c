@@ -38,6 +38,7 @@
 
 #define MAXRETRIES 2
 #define MAXDELAY   16
+#define PROBE      64
 #define INVALID    0xFFFFFFFF
 
 #define CMD_INIT      0xA8
@@ -56,7 +57,10 @@ typedef struct oceanic_atom2_device_t {
 	oceanic_common_device_t base;
 	dc_iostream_t *iostream;
 	unsigned int delay;
+	unsigned int mindelay;
+	unsigned int nsuccess;
 	unsigned int bigpage;
+	unsigned int serial;
 	unsigned char cache[256];
 	unsigned int cached;
 } oceanic_atom2_device_t;
@@ -74,6 +78,7 @@ static const oceanic_common_device_vtable_t oceanic_atom2_device_vtable = {
 		oceanic_atom2_device_write, /* write */
 		oceanic_common_device_dump, /* dump */
 		oceanic_common_device_foreach, /* foreach */
+		NULL, /* download */
 		NULL, /* timesync */
 		oceanic_atom2_device_close /* close */
 	},
@@ -498,6 +503,7 @@ oceanic_atom2_packet (oceanic_atom2_device_t *device, const unsigned char comman
 	// Verify the response of the dive computer.
 	if (response != ack) {
 		ERROR (abstract->context, "Unexpected answer start byte(s).");
+		device_stats_increment (abstract, DEVICE_STATS_NAK);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -520,6 +526,7 @@ oceanic_atom2_packet (oceanic_atom2_device_t *device, const unsigned char comman
 		}
 		if (crc != ccrc) {
 			ERROR (abstract->context, "Unexpected answer checksum.");
+			device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 			return DC_STATUS_PROTOCOL;
 		}
 	}
@@ -547,15 +554,64 @@ oceanic_atom2_transfer (oceanic_atom2_device_t *device, const unsigned char comm
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
-		// Increase the inter packet delay.
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
+
+		// Increase the inter packet delay. The previous delay is too short
+		// for this device, so don't probe below the new value anymore.
 		if (device->delay < MAXDELAY)
 			device->delay++;
+		device->mindelay = device->delay;
+		device->nsuccess = 0;
 
 		// Delay the next attempt.
 		dc_iostream_sleep (device->iostream, 100);
 		dc_iostream_purge (device->iostream, DC_DIRECTION_INPUT);
 	}
 
+	// After a series of successful packets, try to decrease the inter
+	// packet delay again, until the minimum safe value is reached.
+	if (++device->nsuccess >= PROBE && device->delay > device->mindelay) {
+		device->delay--;
+		device->nsuccess = 0;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+static dc_status_t
+oceanic_atom2_identify (oceanic_atom2_device_t *device)
+{
+	dc_device_t *abstract = (dc_device_t *) device;
+	const oceanic_common_layout_t *layout = device->base.layout;
+
+	// Read the device id with the single page command, which is
+	// supported by all devices.
+	unsigned int bigpage = device->bigpage;
+	unsigned char id[PAGESIZE] = {0};
+	device->bigpage = 1;
+	dc_status_t rc = oceanic_atom2_device_read (abstract, layout->cf_devinfo, id, sizeof (id));
+	device->bigpage = bigpage;
+	device->cached = INVALID;
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read the device id.");
+		return rc;
+	}
+
+	device->serial = oceanic_common_serial (layout, id);
+
+	// Start with the communication parameters learned during a previous
+	// session with the same device.
+	dc_pacing_t pacing;
+	if (dc_context_get_pacing (abstract->context, DC_FAMILY_OCEANIC_ATOM2, device->serial, &pacing) != DC_STATUS_SUCCESS)
+		return DC_STATUS_SUCCESS;
+
+	if (pacing.delay > device->delay)
+		device->delay = pacing.delay < MAXDELAY ? pacing.delay : MAXDELAY;
+
+	if (pacing.packetsize < device->bigpage)
+		device->bigpage = pacing.packetsize >= 8 ? 8 : 1;
+
 	return DC_STATUS_SUCCESS;
 }
 
@@ -595,7 +651,10 @@ oceanic_atom2_device_open (dc_device_t **out, dc_context_t *context, const char
 	// Set the default values.
 	device->iostream = NULL;
 	device->delay = 0;
+	device->mindelay = 0;
+	device->nsuccess = 0;
 	device->bigpage = 1; // no big pages
+	device->serial = 0;
 	device->cached = INVALID;
 	memset(device->cache, 0, sizeof(device->cache));
 
@@ -606,6 +665,8 @@ oceanic_atom2_device_open (dc_device_t **out, dc_context_t *context, const char
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Get the correct baudrate.
 	unsigned int baudrate = 38400;
 	if (model == VTX || model == I750TC) {
@@ -715,6 +776,12 @@ oceanic_atom2_device_open (dc_device_t **out, dc_context_t *context, const char
 		}
 	}
 
+	// Identify the device.
+	status = oceanic_atom2_identify (device);
+	if (status != DC_STATUS_SUCCESS) {
+		goto error_close;
+	}
+
 	*out = (dc_device_t*) device;
 
 	return DC_STATUS_SUCCESS;
@@ -734,6 +801,12 @@ oceanic_atom2_device_close (dc_device_t *abstract)
 	oceanic_atom2_device_t *device = (oceanic_atom2_device_t*) abstract;
 	dc_status_t rc = DC_STATUS_SUCCESS;
 
+	// Remember the communication parameters for the next session.
+	dc_pacing_t pacing;
+	pacing.delay = device->delay;
+	pacing.packetsize = device->bigpage;
+	dc_context_set_pacing (abstract->context, DC_FAMILY_OCEANIC_ATOM2, device->serial, &pacing);
+
 	// Send the quit command.
 	rc = oceanic_atom2_quit (device);
 	if (rc != DC_STATUS_SUCCESS) {
@@ -835,8 +908,17 @@ oceanic_atom2_device_read (dc_device_t *abstract, unsigned int address, unsigned
 					(number     ) & 0xFF, // low
 					0};
 			dc_status_t rc = oceanic_atom2_transfer (device, command, sizeof (command), answer,  pagesize + crc_size, crc_size);
-			if (rc != DC_STATUS_SUCCESS)
-				return rc;
+			if (rc != DC_STATUS_SUCCESS) {
+				if (device->bigpage == 1 || (rc != DC_STATUS_TIMEOUT && rc != DC_STATUS_PROTOCOL))
+					return rc;
+
+				// The big page command is not reliable for this device. Fall
+				// back to the next smaller command for the remaining data.
+				device->bigpage = device->bigpage > 8 ? 8 : 1;
+				device->cached = INVALID;
+				WARNING (abstract->context, "Falling back to %u page reads.", device->bigpage);
+				return oceanic_atom2_device_read (abstract, address, data, size - nbytes);
+			}
 
 			// Cache the page.
 			memcpy (device->cache, answer, pagesize);
@@ -93,7 +93,6 @@
 #define NGASMIXES 6
 
 #define HEADER  1
-#define PROFILE 2
 
 typedef struct oceanic_atom2_parser_t oceanic_atom2_parser_t;
 
@@ -110,14 +109,41 @@ struct oceanic_atom2_parser_t {
 	unsigned int ngasmixes;
 	unsigned int oxygen[NGASMIXES];
 	unsigned int helium[NGASMIXES];
-	unsigned int divetime;
-	double maxdepth;
 };
 
+typedef struct oceanic_atom2_profile_t {
+	unsigned int interval;
+	unsigned int samplerate;
+	unsigned int samplesize;
+	unsigned int have_temperature;
+	unsigned int have_pressure;
+	unsigned int temperature;
+} oceanic_atom2_profile_t;
+
+typedef struct oceanic_atom2_decoder_t {
+	dc_sample_decoder_t base;
+	oceanic_atom2_profile_t profile;
+	unsigned int offset;
+	unsigned int extratime;
+	unsigned int time;
+	unsigned int temperature;
+	unsigned int have_pressure;
+	unsigned int tank;
+	unsigned int pressure;
+	unsigned int gasmix_previous;
+	unsigned int count;
+	unsigned int complete;
+	unsigned int previous;
+} oceanic_atom2_decoder_t;
+
 static dc_status_t oceanic_atom2_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
 static dc_status_t oceanic_atom2_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t oceanic_atom2_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t oceanic_atom2_parser_samples_iterator (dc_parser_t *abstract, dc_iterator_t **iterator);
+static dc_status_t oceanic_atom2_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns);
+
+static dc_status_t oceanic_atom2_decoder_step (dc_sample_decoder_t *base, dc_sample_callback_t callback, void *userdata);
 
 static const dc_parser_vtable_t oceanic_atom2_parser_vtable = {
 	sizeof(oceanic_atom2_parser_t),
@@ -126,6 +152,8 @@ static const dc_parser_vtable_t oceanic_atom2_parser_vtable = {
 	oceanic_atom2_parser_get_datetime, /* datetime */
 	oceanic_atom2_parser_get_field, /* fields */
 	oceanic_atom2_parser_samples_foreach, /* samples_foreach */
+	oceanic_atom2_parser_samples_iterator, /* samples_iterator */
+	oceanic_atom2_parser_samples_columns, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -185,8 +213,6 @@ oceanic_atom2_parser_create (dc_parser_t **out, dc_context_t *context, unsigned
 		parser->oxygen[i] = 0;
 		parser->helium[i] = 0;
 	}
-	parser->divetime = 0;
-	parser->maxdepth = 0.0;
 
 	*out = (dc_parser_t*) parser;
 
@@ -209,8 +235,6 @@ oceanic_atom2_parser_set_data (dc_parser_t *abstract, const unsigned char *data,
 		parser->oxygen[i] = 0;
 		parser->helium[i] = 0;
 	}
-	parser->divetime = 0;
-	parser->maxdepth = 0.0;
 
 	return DC_STATUS_SUCCESS;
 }
@@ -487,19 +511,7 @@ oceanic_atom2_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 	if (status != DC_STATUS_SUCCESS)
 		return status;
 
-	// Cache the profile data.
-	if (parser->cached < PROFILE) {
-		sample_statistics_t statistics = SAMPLE_STATISTICS_INITIALIZER;
-		status = oceanic_atom2_parser_samples_foreach (
-			abstract, sample_statistics_cb, &statistics);
-		if (status != DC_STATUS_SUCCESS)
-			return status;
-
-		parser->cached = PROFILE;
-		parser->divetime = statistics.divetime;
-		parser->maxdepth = statistics.maxdepth;
-	}
-
+	const sample_statistics_t *statistics = NULL;
 	dc_gasmix_t *gasmix = (dc_gasmix_t *) value;
 	dc_salinity_t *water = (dc_salinity_t *) value;
 
@@ -510,8 +522,12 @@ oceanic_atom2_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, uns
 				parser->model == F11A || parser->model == F11B ||
 				parser->model == MUNDIAL2 || parser->model == MUNDIAL3)
 				*((unsigned int *) value) = bcd2dec (data[2]) + bcd2dec (data[3]) * 60;
-			else
-				*((unsigned int *) value) = parser->divetime;
+			else {
+				status = dc_parser_profile_statistics (abstract, NULL, 0, &statistics);
+				if (status != DC_STATUS_SUCCESS)
+					return status;
+				*((unsigned int *) value) = statistics->result.divetime;
+			}
 			break;
 		case DC_FIELD_MAXDEPTH:
 			if (parser->model == F10A || parser->model == F10B ||
@@ -601,24 +617,14 @@ oceanic_atom2_parser_vendor (oceanic_atom2_parser_t *parser, const unsigned char
 	}
 }
 
-static dc_status_t
-oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+static void
+oceanic_atom2_parser_profile (oceanic_atom2_parser_t *parser, oceanic_atom2_profile_t *profile)
 {
-	dc_status_t status = DC_STATUS_SUCCESS;
-	oceanic_atom2_parser_t *parser = (oceanic_atom2_parser_t *) abstract;
-
+	dc_parser_t *abstract = (dc_parser_t *) parser;
 	const unsigned char *data = abstract->data;
-	unsigned int size = abstract->size;
 
-	// Cache the header data.
-	status = oceanic_atom2_parser_cache (parser);
-	if (status != DC_STATUS_SUCCESS)
-		return status;
-
-	unsigned int extratime = 0;
-	unsigned int time = 0;
-	unsigned int interval = 1;
-	unsigned int samplerate = 1;
+	profile->interval = 1;
+	profile->samplerate = 1;
 	if (parser->mode != FREEDIVE) {
 		unsigned int idx = 0x17;
 		if (parser->model == A300CS || parser->model == VTX ||
@@ -626,37 +632,37 @@ oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_
 			idx = 0x1f;
 		switch (data[idx] & 0x03) {
 		case 0:
-			interval = 2;
+			profile->interval = 2;
 			break;
 		case 1:
-			interval = 15;
+			profile->interval = 15;
 			break;
 		case 2:
-			interval = 30;
+			profile->interval = 30;
 			break;
 		case 3:
-			interval = 60;
+			profile->interval = 60;
 			break;
 		}
 	} else if (parser->model == F11A || parser->model == F11B) {
 		unsigned int idx = 0x29;
 		switch (data[idx] & 0x03) {
 		case 0:
-			interval = 1;
-			samplerate = 4;
+			profile->interval = 1;
+			profile->samplerate = 4;
 			break;
 		case 1:
-			interval = 1;
-			samplerate = 2;
+			profile->interval = 1;
+			profile->samplerate = 2;
 			break;
 		case 2:
-			interval = 1;
+			profile->interval = 1;
 			break;
 		case 3:
-			interval = 2;
+			profile->interval = 2;
 			break;
 		}
-		if (samplerate > 1) {
+		if (profile->samplerate > 1) {
 			// Some models supports multiple samples per second.
 			// Since our smallest unit of time is one second, we can't
 			// represent this, and the extra samples will get dropped.
@@ -664,65 +670,488 @@ oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_
 		}
 	}
 
-	unsigned int samplesize = PAGESIZE / 2;
+	profile->samplesize = PAGESIZE / 2;
 	if (parser->mode == FREEDIVE) {
 		if (parser->model == F10A || parser->model == F10B ||
 			parser->model == F11A || parser->model == F11B ||
 			parser->model == MUNDIAL2 || parser->model == MUNDIAL3) {
-			samplesize = 2;
+			profile->samplesize = 2;
 		} else {
-			samplesize = 4;
+			profile->samplesize = 4;
 		}
 	} else if (parser->model == OC1A || parser->model == OC1B ||
 		parser->model == OC1C || parser->model == OCI ||
 		parser->model == TX1 || parser->model == A300CS ||
 		parser->model == VTX || parser->model == I450T ||
 		parser->model == I750TC) {
-		samplesize = PAGESIZE;
+		profile->samplesize = PAGESIZE;
 	}
 
-	unsigned int have_temperature = 1, have_pressure = 1;
+	profile->have_temperature = 1;
+	profile->have_pressure = 1;
 	if (parser->mode == FREEDIVE) {
-		have_temperature = 0;
-		have_pressure = 0;
+		profile->have_temperature = 0;
+		profile->have_pressure = 0;
 	} else if (parser->model == VEO30 || parser->model == OCS ||
 		parser->model == ELEMENT2 || parser->model == VEO20 ||
 		parser->model == A300 || parser->model == ZEN ||
 		parser->model == GEO || parser->model == GEO20 ||
 		parser->model == MANTA || parser->model == I300 ||
 		parser->model == I200) {
-		have_pressure = 0;
+		profile->have_pressure = 0;
 	}
 
 	// Initial temperature.
-	unsigned int temperature = 0;
-	if (have_temperature) {
-		temperature = data[parser->header + 7];
+	profile->temperature = 0;
+	if (profile->have_temperature) {
+		profile->temperature = data[parser->header + 7];
 	}
+}
+
+static unsigned int
+oceanic_atom2_parser_temperature (oceanic_atom2_parser_t *parser, const unsigned char *data, unsigned int temperature)
+{
+	if (parser->model == GEO || parser->model == ATOM1 ||
+		parser->model == ELEMENT2 || parser->model == MANTA ||
+		parser->model == ZEN) {
+		temperature = data[6];
+	} else if (parser->model == GEO20 || parser->model == VEO20 ||
+		parser->model == VEO30 || parser->model == OC1A ||
+		parser->model == OC1B || parser->model == OC1C ||
+		parser->model == OCI || parser->model == A300 ||
+		parser->model == I450T || parser->model == I300 ||
+		parser->model == I200) {
+		temperature = data[3];
+	} else if (parser->model == OCS || parser->model == TX1) {
+		temperature = data[1];
+	} else if (parser->model == VT4 || parser->model == VT41 ||
+		parser->model == ATOM3 || parser->model == ATOM31 ||
+		parser->model == A300AI || parser->model == VISION ||
+		parser->model == XPAIR) {
+		temperature = ((data[7] & 0xF0) >> 4) | ((data[7] & 0x0C) << 2) | ((data[5] & 0x0C) << 4);
+	} else if (parser->model == A300CS || parser->model == VTX ||
+		parser->model == I750TC) {
+		temperature = data[11];
+	} else {
+		unsigned int sign;
+		if (parser->model == DG03 || parser->model == PROPLUS3 ||
+			parser->model == I550)
+			sign = (~data[5] & 0x04) >> 2;
+		else if (parser->model == VOYAGER2G || parser->model == AMPHOS ||
+			parser->model == AMPHOSAIR || parser->model == ZENAIR)
+			sign = (data[5] & 0x04) >> 2;
+		else if (parser->model == ATOM2 || parser->model == PROPLUS21 ||
+			parser->model == EPICA || parser->model == EPICB ||
+			parser->model == ATMOSAI2 ||
+			parser->model == WISDOM2 || parser->model == WISDOM3)
+			sign = (data[0] & 0x80) >> 7;
+		else
+			sign = (~data[0] & 0x80) >> 7;
+		if (sign)
+			temperature -= (data[7] & 0x0C) >> 2;
+		else
+			temperature += (data[7] & 0x0C) >> 2;
+	}
+
+	return temperature;
+}
+
+static unsigned int
+oceanic_atom2_parser_depth (oceanic_atom2_parser_t *parser, const unsigned char *data)
+{
+	unsigned int depth;
+	if (parser->mode == FREEDIVE)
+		depth = array_uint16_le (data);
+	else if (parser->model == GEO20 || parser->model == VEO20 ||
+		parser->model == VEO30 || parser->model == OC1A ||
+		parser->model == OC1B || parser->model == OC1C ||
+		parser->model == OCI || parser->model == A300 ||
+		parser->model == I450T || parser->model == I300 ||
+		parser->model == I200)
+		depth = (data[4] + (data[5] << 8)) & 0x0FFF;
+	else if (parser->model == ATOM1)
+		depth = data[3] * 16;
+	else
+		depth = (data[2] + (data[3] << 8)) & 0x0FFF;
+
+	return depth;
+}
+
+static void
+oceanic_atom2_decoder_init (oceanic_atom2_decoder_t *decoder, oceanic_atom2_parser_t *parser)
+{
+	const unsigned char *data = parser->base.data;
+
+	decoder->base.parser = (dc_parser_t *) parser;
+	decoder->base.step = oceanic_atom2_decoder_step;
+
+	// Get the sample configuration.
+	oceanic_atom2_parser_profile (parser, &decoder->profile);
+
+	decoder->extratime = 0;
+	decoder->time = 0;
+	decoder->temperature = decoder->profile.temperature;
 
 	// Initial tank pressure.
-	unsigned int tank = 0;
-	unsigned int pressure = 0;
-	if (have_pressure) {
+	decoder->have_pressure = decoder->profile.have_pressure;
+	decoder->tank = 0;
+	decoder->pressure = 0;
+	if (decoder->have_pressure) {
 		unsigned int idx = 2;
 		if (parser->model == A300CS || parser->model == VTX ||
 			parser->model == I750TC)
 			idx = 16;
-		pressure = array_uint16_le(data + parser->header + idx);
-		if (pressure == 10000)
-			have_pressure = 0;
+		decoder->pressure = array_uint16_le(data + parser->header + idx);
+		if (decoder->pressure == 10000)
+			decoder->have_pressure = 0;
 	}
 
+	// Initial gas mix.
+	decoder->gasmix_previous = 0xFFFFFFFF;
+
+	decoder->count = 0;
+	decoder->complete = 1;
+	decoder->previous = 0;
+	decoder->offset = parser->headersize;
+}
+
+static dc_status_t
+oceanic_atom2_decoder_step (dc_sample_decoder_t *base, dc_sample_callback_t callback, void *userdata)
+{
+	oceanic_atom2_decoder_t *decoder = (oceanic_atom2_decoder_t *) base;
+	oceanic_atom2_parser_t *parser = (oceanic_atom2_parser_t *) base->parser;
+	dc_parser_t *abstract = base->parser;
+
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	unsigned int interval = decoder->profile.interval;
+	unsigned int samplerate = decoder->profile.samplerate;
+	unsigned int samplesize = decoder->profile.samplesize;
+	unsigned int have_temperature = decoder->profile.have_temperature;
+
+	if (decoder->offset + samplesize > size - parser->footersize)
+		return DC_STATUS_DONE;
+
+	dc_sample_value_t sample = {0};
+
+	// Ignore empty samples.
+	if ((parser->mode != FREEDIVE &&
+		array_isequal (data + decoder->offset, samplesize, 0x00)) ||
+		array_isequal (data + decoder->offset, samplesize, 0xFF)) {
+		decoder->offset += samplesize;
+		return DC_STATUS_SUCCESS;
+	}
+
+	if (decoder->complete) {
+		decoder->previous = decoder->offset;
+		decoder->complete = 0;
+	}
+
+	// Get the sample type.
+	unsigned int sampletype = data[decoder->offset + 0];
+	if (parser->mode == FREEDIVE)
+		sampletype = 0;
+
+	// The sample size is usually fixed, but some sample types have a
+	// larger size. Check whether we have that many bytes available.
+	unsigned int length = samplesize;
+	if (sampletype == 0xBB) {
+		length = PAGESIZE;
+		if (decoder->offset + length > size - parser->footersize) {
+			ERROR (abstract->context, "Buffer overflow detected!");
+			return DC_STATUS_DATAFORMAT;
+		}
+	}
+
+	// Check for a decoder->tank switch sample.
+	if (sampletype == 0xAA) {
+		if (parser->model == DATAMASK || parser->model == COMPUMASK) {
+			// Tank decoder->pressure (1 psi) and number
+			decoder->tank = 0;
+			decoder->pressure = (((data[decoder->offset + 7] << 8) + data[decoder->offset + 6]) & 0x0FFF);
+		} else if (parser->model == A300CS || parser->model == VTX ||
+			parser->model == I750TC) {
+			// Tank decoder->pressure (1 psi) and number (one based index)
+			decoder->tank = (data[decoder->offset + 1] & 0x03) - 1;
+			decoder->pressure = ((data[decoder->offset + 7] << 8) + data[decoder->offset + 6]) & 0x0FFF;
+		} else {
+			// Tank decoder->pressure (2 psi) and number (one based index)
+			decoder->tank = (data[decoder->offset + 1] & 0x03) - 1;
+			if (parser->model == ATOM2 || parser->model == EPICA || parser->model == EPICB)
+				decoder->pressure = (((data[decoder->offset + 3] << 8) + data[decoder->offset + 4]) & 0x0FFF) * 2;
+			else
+				decoder->pressure = (((data[decoder->offset + 4] << 8) + data[decoder->offset + 5]) & 0x0FFF) * 2;
+		}
+	} else if (sampletype == 0xBB) {
+		// The surface decoder->time is not always a nice multiple of the samplerate.
+		// The number of inserted surface samples is therefore rounded down
+		// to keep the timestamps aligned at multiples of the samplerate.
+		unsigned int surftime = 60 * bcd2dec (data[decoder->offset + 1]) + bcd2dec (data[decoder->offset + 2]);
+		unsigned int nsamples = surftime / interval;
+
+		for (unsigned int i = 0; i < nsamples; ++i) {
+			// Time
+			decoder->time += interval;
+			sample.time = decoder->time;
+			if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+
+			// Vendor specific data
+			if (i == 0) {
+				oceanic_atom2_parser_vendor (parser,
+					data + decoder->previous,
+					(decoder->offset - decoder->previous) + length,
+					samplesize, callback, userdata);
+			}
+
+			// Depth
+			sample.depth = 0.0;
+			if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+			decoder->complete = 1;
+		}
+
+		decoder->extratime += surftime;
+	} else {
+		// Skip the extra samples.
+		if ((decoder->count % samplerate) != 0) {
+			decoder->offset += samplesize;
+			decoder->count++;
+			return DC_STATUS_SUCCESS;
+		}
+
+		// Time.
+		if (parser->model == I450T) {
+			unsigned int minute = bcd2dec(data[decoder->offset + 0]);
+			unsigned int hour   = bcd2dec(data[decoder->offset + 1] & 0x0F);
+			unsigned int second = bcd2dec(data[decoder->offset + 2]);
+			unsigned int timestamp = (hour * 3600) + (minute * 60 ) + second + decoder->extratime;
+			if (timestamp < decoder->time) {
+				ERROR (abstract->context, "Timestamp moved backwards.");
+				return DC_STATUS_DATAFORMAT;
+			} else 	if (timestamp == decoder->time) {
+				WARNING (abstract->context, "Unexpected sample with the same timestamp ignored.");
+				decoder->offset += length;
+				return DC_STATUS_SUCCESS;
+			}
+			decoder->time = timestamp;
+		} else {
+			decoder->time += interval;
+		}
+		sample.time = decoder->time;
+		if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+
+		// Vendor specific data
+		oceanic_atom2_parser_vendor (parser,
+			data + decoder->previous,
+			(decoder->offset - decoder->previous) + length,
+			samplesize, callback, userdata);
+
+		// Temperature (°F)
+		if (have_temperature) {
+			decoder->temperature = oceanic_atom2_parser_temperature (parser, data + decoder->offset, decoder->temperature);
+			sample.temperature = (decoder->temperature - 32.0) * (5.0 / 9.0);
+			if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+		}
+
+		// Tank Pressure (psi)
+		if (decoder->have_pressure) {
+			if (parser->model == OC1A || parser->model == OC1B ||
+				parser->model == OC1C || parser->model == OCI ||
+				parser->model == I450T)
+				decoder->pressure = (data[decoder->offset + 10] + (data[decoder->offset + 11] << 8)) & 0x0FFF;
+			else if (parser->model == VT4 || parser->model == VT41||
+				parser->model == ATOM3 || parser->model == ATOM31 ||
+				parser->model == ZENAIR ||parser->model == A300AI ||
+				parser->model == DG03 || parser->model == PROPLUS3 ||
+				parser->model == AMPHOSAIR || parser->model == I550 ||
+				parser->model == VISION || parser->model == XPAIR)
+				decoder->pressure = (((data[decoder->offset + 0] & 0x03) << 8) + data[decoder->offset + 1]) * 5;
+			else if (parser->model == TX1 || parser->model == A300CS ||
+				parser->model == VTX || parser->model == I750TC)
+				decoder->pressure = array_uint16_le (data + decoder->offset + 4);
+			else
+				decoder->pressure -= data[decoder->offset + 1];
+			sample.pressure.tank = decoder->tank;
+			sample.pressure.value = decoder->pressure * PSI / BAR;
+			if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
+		}
+
+		// Depth (1/16 ft)
+		unsigned int depth = oceanic_atom2_parser_depth (parser, data + decoder->offset);
+		sample.depth = depth / 16.0 * FEET;
+		if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+
+		// Gas mix
+		unsigned int have_gasmix = 0;
+		unsigned int gasmix = 0;
+		if (parser->model == TX1) {
+			gasmix = data[decoder->offset] & 0x07;
+			have_gasmix = 1;
+		}
+		if (have_gasmix && gasmix != decoder->gasmix_previous) {
+			if (gasmix < 1 || gasmix > parser->ngasmixes) {
+				ERROR (abstract->context, "Invalid gas mix index (%u).", gasmix);
+				return DC_STATUS_DATAFORMAT;
+			}
+			sample.gasmix = gasmix - 1;
+			if (callback) callback (DC_SAMPLE_GASMIX, sample, userdata);
+			decoder->gasmix_previous = gasmix;
+		}
+
+		// NDL / Deco
+		unsigned int have_deco = 0;
+		unsigned int decostop = 0, decotime = 0;
+		if (parser->model == A300CS || parser->model == VTX ||
+			parser->model == I450T || parser->model == I750TC) {
+			decostop = (data[decoder->offset + 15] & 0x70) >> 4;
+			decotime = array_uint16_le(data + decoder->offset + 6) & 0x03FF;
+			have_deco = 1;
+		} else if (parser->model == ZEN || parser->model == DG03) {
+			decostop = (data[decoder->offset + 5] & 0xF0) >> 4;
+			decotime = array_uint16_le(data + decoder->offset + 4) & 0x0FFF;
+			have_deco = 1;
+		} else if (parser->model == TX1) {
+			decostop = data[decoder->offset + 10];
+			decotime = array_uint16_le(data + decoder->offset + 6);
+			have_deco = 1;
+		} else if (parser->model == ATOM31 || parser->model == VISION ||
+			parser->model == XPAIR || parser->model == I550) {
+			decostop = (data[decoder->offset + 5] & 0xF0) >> 4;
+			decotime = array_uint16_le(data + decoder->offset + 4) & 0x03FF;
+			have_deco = 1;
+		} else if (parser->model == I200 || parser->model == I300 ||
+			parser->model == OC1A || parser->model == OC1B ||
+			parser->model == OC1C || parser->model == OCI) {
+			decostop = (data[decoder->offset + 7] & 0xF0) >> 4;
+			decotime = array_uint16_le(data + decoder->offset + 6) & 0x0FFF;
+			have_deco = 1;
+		}
+		if (have_deco) {
+			if (decostop) {
+				sample.deco.type = DC_DECO_DECOSTOP;
+				sample.deco.depth = decostop * 10 * FEET;
+			} else {
+				sample.deco.type = DC_DECO_NDL;
+				sample.deco.depth = 0.0;
+			}
+			sample.deco.time = decotime * 60;
+			if (callback) callback (DC_SAMPLE_DECO, sample, userdata);
+		}
+
+		unsigned int have_rbt = 0;
+		unsigned int rbt = 0;
+		if (parser->model == ATOM31) {
+			rbt = array_uint16_le(data + decoder->offset + 6) & 0x01FF;
+			have_rbt = 1;
+		} else if (parser->model == I450T || parser->model == OC1A ||
+			parser->model == OC1B || parser->model == OC1C ||
+			parser->model == OCI) {
+			rbt = array_uint16_le(data + decoder->offset + 8) & 0x01FF;
+			have_rbt = 1;
+		} else if (parser->model == VISION || parser->model == XPAIR ||
+			parser->model == I550) {
+			rbt = array_uint16_le(data + decoder->offset + 6) & 0x03FF;
+			have_rbt = 1;
+		}
+		if (have_rbt) {
+			sample.rbt = rbt;
+			if (callback) callback (DC_SAMPLE_RBT, sample, userdata);
+		}
+
+		// Bookmarks
+		unsigned int have_bookmark = 0;
+		if (parser->model == OC1A || parser->model == OC1B ||
+			parser->model == OC1C || parser->model == OCI) {
+			have_bookmark = data[decoder->offset + 12] & 0x80;
+		}
+		if (have_bookmark) {
+			sample.event.type = SAMPLE_EVENT_BOOKMARK;
+			sample.event.time = 0;
+			sample.event.flags = 0;
+			sample.event.value = 0;
+			if (callback) callback (DC_SAMPLE_EVENT, sample, userdata);
+		}
+
+		decoder->count++;
+		decoder->complete = 1;
+	}
+
+	decoder->offset += length;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	oceanic_atom2_parser_t *parser = (oceanic_atom2_parser_t *) abstract;
+	oceanic_atom2_decoder_t decoder;
+
+	// Cache the header data.
+	status = oceanic_atom2_parser_cache (parser);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	oceanic_atom2_decoder_init (&decoder, parser);
+
+	return dc_sample_decoder_run (&decoder.base, callback, userdata);
+}
+
+static dc_status_t
+oceanic_atom2_parser_samples_iterator (dc_parser_t *abstract, dc_iterator_t **iterator)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	oceanic_atom2_parser_t *parser = (oceanic_atom2_parser_t *) abstract;
+	oceanic_atom2_decoder_t decoder;
+
+	// Cache the header data.
+	status = oceanic_atom2_parser_cache (parser);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	oceanic_atom2_decoder_init (&decoder, parser);
+
+	return dc_sample_decoder_iterator (iterator, &decoder.base, sizeof (decoder));
+}
+
+static dc_status_t
+oceanic_atom2_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	oceanic_atom2_parser_t *parser = (oceanic_atom2_parser_t *) abstract;
+
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	// Only the time, depth and temperature columns are supported. The
+	// others depend on the model, and the fields also on the vendor data
+	// of the empty samples. The timestamps of the I450T can be irregular.
+	if (columns->fields || columns->pressure || columns->ppo2 || columns->cns ||
+		columns->deco_type || columns->deco_time || columns->deco_depth ||
+		parser->model == I450T)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Cache the header data.
+	status = oceanic_atom2_parser_cache (parser);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	// Get the sample configuration.
+	oceanic_atom2_profile_t profile;
+	oceanic_atom2_parser_profile (parser, &profile);
+
+	unsigned int samplesize = profile.samplesize;
+	unsigned int temperature = profile.temperature;
+
 	// Initial gas mix.
 	unsigned int gasmix_previous = 0xFFFFFFFF;
 
+	unsigned int time = 0;
+	unsigned int nrows = 0;
 	unsigned int count = 0;
-	unsigned int complete = 1;
-	unsigned int previous = 0;
 	unsigned int offset = parser->headersize;
 	while (offset + samplesize <= size - parser->footersize) {
-		dc_sample_value_t sample = {0};
-
 		// Ignore empty samples.
 		if ((parser->mode != FREEDIVE &&
 			array_isequal (data + offset, samplesize, 0x00)) ||
@@ -731,11 +1160,6 @@ oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_
 			continue;
 		}
 
-		if (complete) {
-			previous = offset;
-			complete = 0;
-		}
-
 		// Get the sample type.
 		unsigned int sampletype = data[offset + 0];
 		if (parser->mode == FREEDIVE)
@@ -752,273 +1176,71 @@ oceanic_atom2_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_
 			}
 		}
 
-		// Check for a tank switch sample.
-		if (sampletype == 0xAA) {
-			if (parser->model == DATAMASK || parser->model == COMPUMASK) {
-				// Tank pressure (1 psi) and number
-				tank = 0;
-				pressure = (((data[offset + 7] << 8) + data[offset + 6]) & 0x0FFF);
-			} else if (parser->model == A300CS || parser->model == VTX ||
-				parser->model == I750TC) {
-				// Tank pressure (1 psi) and number (one based index)
-				tank = (data[offset + 1] & 0x03) - 1;
-				pressure = ((data[offset + 7] << 8) + data[offset + 6]) & 0x0FFF;
-			} else {
-				// Tank pressure (2 psi) and number (one based index)
-				tank = (data[offset + 1] & 0x03) - 1;
-				if (parser->model == ATOM2 || parser->model == EPICA || parser->model == EPICB)
-					pressure = (((data[offset + 3] << 8) + data[offset + 4]) & 0x0FFF) * 2;
-				else
-					pressure = (((data[offset + 4] << 8) + data[offset + 5]) & 0x0FFF) * 2;
-			}
-		} else if (sampletype == 0xBB) {
-			// The surface time is not always a nice multiple of the samplerate.
-			// The number of inserted surface samples is therefore rounded down
-			// to keep the timestamps aligned at multiples of the samplerate.
+		if (sampletype == 0xBB) {
+			// Surface samples, with only a time and a zero depth.
 			unsigned int surftime = 60 * bcd2dec (data[offset + 1]) + bcd2dec (data[offset + 2]);
-			unsigned int nsamples = surftime / interval;
+			unsigned int nsamples = surftime / profile.interval;
 
 			for (unsigned int i = 0; i < nsamples; ++i) {
-				// Time
-				time += interval;
-				sample.time = time;
-				if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
-
-				// Vendor specific data
-				if (i == 0) {
-					oceanic_atom2_parser_vendor (parser,
-						data + previous,
-						(offset - previous) + length,
-						samplesize, callback, userdata);
+				time += profile.interval;
+				dc_sample_columns_clear (columns, nrows, 1);
+				if (nrows < columns->capacity) {
+					if (columns->time)
+						columns->time[nrows] = time;
+					if (columns->depth)
+						columns->depth[nrows] = 0.0;
 				}
-
-				// Depth
-				sample.depth = 0.0;
-				if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
-				complete = 1;
+				nrows++;
 			}
-
-			extratime += surftime;
-		} else {
+		} else if (sampletype != 0xAA) {
 			// Skip the extra samples.
-			if ((count % samplerate) != 0) {
+			if ((count % profile.samplerate) != 0) {
 				offset += samplesize;
 				count++;
 				continue;
 			}
 
-			// Time.
-			if (parser->model == I450T) {
-				unsigned int minute = bcd2dec(data[offset + 0]);
-				unsigned int hour   = bcd2dec(data[offset + 1] & 0x0F);
-				unsigned int second = bcd2dec(data[offset + 2]);
-				unsigned int timestamp = (hour * 3600) + (minute * 60 ) + second + extratime;
-				if (timestamp < time) {
-					ERROR (abstract->context, "Timestamp moved backwards.");
-					return DC_STATUS_DATAFORMAT;
-				} else 	if (timestamp == time) {
-					WARNING (abstract->context, "Unexpected sample with the same timestamp ignored.");
-					offset += length;
-					continue;
-				}
-				time = timestamp;
-			} else {
-				time += interval;
-			}
-			sample.time = time;
-			if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
-
-			// Vendor specific data
-			oceanic_atom2_parser_vendor (parser,
-				data + previous,
-				(offset - previous) + length,
-				samplesize, callback, userdata);
-
-			// Temperature (°F)
-			if (have_temperature) {
-				if (parser->model == GEO || parser->model == ATOM1 ||
-					parser->model == ELEMENT2 || parser->model == MANTA ||
-					parser->model == ZEN) {
-					temperature = data[offset + 6];
-				} else if (parser->model == GEO20 || parser->model == VEO20 ||
-					parser->model == VEO30 || parser->model == OC1A ||
-					parser->model == OC1B || parser->model == OC1C ||
-					parser->model == OCI || parser->model == A300 ||
-					parser->model == I450T || parser->model == I300 ||
-					parser->model == I200) {
-					temperature = data[offset + 3];
-				} else if (parser->model == OCS || parser->model == TX1) {
-					temperature = data[offset + 1];
-				} else if (parser->model == VT4 || parser->model == VT41 ||
-					parser->model == ATOM3 || parser->model == ATOM31 ||
-					parser->model == A300AI || parser->model == VISION ||
-					parser->model == XPAIR) {
-					temperature = ((data[offset + 7] & 0xF0) >> 4) | ((data[offset + 7] & 0x0C) << 2) | ((data[offset + 5] & 0x0C) << 4);
-				} else if (parser->model == A300CS || parser->model == VTX ||
-					parser->model == I750TC) {
-					temperature = data[offset + 11];
-				} else {
-					unsigned int sign;
-					if (parser->model == DG03 || parser->model == PROPLUS3 ||
-						parser->model == I550)
-						sign = (~data[offset + 5] & 0x04) >> 2;
-					else if (parser->model == VOYAGER2G || parser->model == AMPHOS ||
-						parser->model == AMPHOSAIR || parser->model == ZENAIR)
-						sign = (data[offset + 5] & 0x04) >> 2;
-					else if (parser->model == ATOM2 || parser->model == PROPLUS21 ||
-						parser->model == EPICA || parser->model == EPICB ||
-						parser->model == ATMOSAI2 ||
-						parser->model == WISDOM2 || parser->model == WISDOM3)
-						sign = (data[offset + 0] & 0x80) >> 7;
-					else
-						sign = (~data[offset + 0] & 0x80) >> 7;
-					if (sign)
-						temperature -= (data[offset + 7] & 0x0C) >> 2;
-					else
-						temperature += (data[offset + 7] & 0x0C) >> 2;
-				}
-				sample.temperature = (temperature - 32.0) * (5.0 / 9.0);
-				if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
-			}
-
-			// Tank Pressure (psi)
-			if (have_pressure) {
-				if (parser->model == OC1A || parser->model == OC1B ||
-					parser->model == OC1C || parser->model == OCI ||
-					parser->model == I450T)
-					pressure = (data[offset + 10] + (data[offset + 11] << 8)) & 0x0FFF;
-				else if (parser->model == VT4 || parser->model == VT41||
-					parser->model == ATOM3 || parser->model == ATOM31 ||
-					parser->model == ZENAIR ||parser->model == A300AI ||
-					parser->model == DG03 || parser->model == PROPLUS3 ||
-					parser->model == AMPHOSAIR || parser->model == I550 ||
-					parser->model == VISION || parser->model == XPAIR)
-					pressure = (((data[offset + 0] & 0x03) << 8) + data[offset + 1]) * 5;
-				else if (parser->model == TX1 || parser->model == A300CS ||
-					parser->model == VTX || parser->model == I750TC)
-					pressure = array_uint16_le (data + offset + 4);
-				else
-					pressure -= data[offset + 1];
-				sample.pressure.tank = tank;
-				sample.pressure.value = pressure * PSI / BAR;
-				if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
+			// The temperature can be stored as a difference with the
+			// previous sample, and is therefore always decoded.
+			if (profile.have_temperature)
+				temperature = oceanic_atom2_parser_temperature (parser, data + offset, temperature);
+
+			time += profile.interval;
+			dc_sample_columns_clear (columns, nrows, 1);
+			if (nrows < columns->capacity) {
+				// Time (seconds).
+				if (columns->time)
+					columns->time[nrows] = time;
+
+				// Depth (1/16 ft)
+				if (columns->depth)
+					columns->depth[nrows] = oceanic_atom2_parser_depth (parser, data + offset) / 16.0 * FEET;
+
+				// Temperature (°F)
+				if (columns->temperature && profile.have_temperature)
+					columns->temperature[nrows] = (temperature - 32.0) * (5.0 / 9.0);
 			}
-
-			// Depth (1/16 ft)
-			unsigned int depth;
-			if (parser->mode == FREEDIVE)
-				depth = array_uint16_le (data + offset);
-			else if (parser->model == GEO20 || parser->model == VEO20 ||
-				parser->model == VEO30 || parser->model == OC1A ||
-				parser->model == OC1B || parser->model == OC1C ||
-				parser->model == OCI || parser->model == A300 ||
-				parser->model == I450T || parser->model == I300 ||
-				parser->model == I200)
-				depth = (data[offset + 4] + (data[offset + 5] << 8)) & 0x0FFF;
-			else if (parser->model == ATOM1)
-				depth = data[offset + 3] * 16;
-			else
-				depth = (data[offset + 2] + (data[offset + 3] << 8)) & 0x0FFF;
-			sample.depth = depth / 16.0 * FEET;
-			if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
+			nrows++;
 
 			// Gas mix
-			unsigned int have_gasmix = 0;
-			unsigned int gasmix = 0;
 			if (parser->model == TX1) {
-				gasmix = data[offset] & 0x07;
-				have_gasmix = 1;
-			}
-			if (have_gasmix && gasmix != gasmix_previous) {
-				if (gasmix < 1 || gasmix > parser->ngasmixes) {
-					ERROR (abstract->context, "Invalid gas mix index (%u).", gasmix);
-					return DC_STATUS_DATAFORMAT;
-				}
-				sample.gasmix = gasmix - 1;
-				if (callback) callback (DC_SAMPLE_GASMIX, sample, userdata);
-				gasmix_previous = gasmix;
-			}
-
-			// NDL / Deco
-			unsigned int have_deco = 0;
-			unsigned int decostop = 0, decotime = 0;
-			if (parser->model == A300CS || parser->model == VTX ||
-				parser->model == I450T || parser->model == I750TC) {
-				decostop = (data[offset + 15] & 0x70) >> 4;
-				decotime = array_uint16_le(data + offset + 6) & 0x03FF;
-				have_deco = 1;
-			} else if (parser->model == ZEN || parser->model == DG03) {
-				decostop = (data[offset + 5] & 0xF0) >> 4;
-				decotime = array_uint16_le(data + offset + 4) & 0x0FFF;
-				have_deco = 1;
-			} else if (parser->model == TX1) {
-				decostop = data[offset + 10];
-				decotime = array_uint16_le(data + offset + 6);
-				have_deco = 1;
-			} else if (parser->model == ATOM31 || parser->model == VISION ||
-				parser->model == XPAIR || parser->model == I550) {
-				decostop = (data[offset + 5] & 0xF0) >> 4;
-				decotime = array_uint16_le(data + offset + 4) & 0x03FF;
-				have_deco = 1;
-			} else if (parser->model == I200 || parser->model == I300 ||
-				parser->model == OC1A || parser->model == OC1B ||
-				parser->model == OC1C || parser->model == OCI) {
-				decostop = (data[offset + 7] & 0xF0) >> 4;
-				decotime = array_uint16_le(data + offset + 6) & 0x0FFF;
-				have_deco = 1;
-			}
-			if (have_deco) {
-				if (decostop) {
-					sample.deco.type = DC_DECO_DECOSTOP;
-					sample.deco.depth = decostop * 10 * FEET;
-				} else {
-					sample.deco.type = DC_DECO_NDL;
-					sample.deco.depth = 0.0;
+				unsigned int gasmix = data[offset] & 0x07;
+				if (gasmix != gasmix_previous) {
+					if (gasmix < 1 || gasmix > parser->ngasmixes) {
+						ERROR (abstract->context, "Invalid gas mix index (%u).", gasmix);
+						return DC_STATUS_DATAFORMAT;
+					}
+					gasmix_previous = gasmix;
 				}
-				sample.deco.time = decotime * 60;
-				if (callback) callback (DC_SAMPLE_DECO, sample, userdata);
-			}
-
-			unsigned int have_rbt = 0;
-			unsigned int rbt = 0;
-			if (parser->model == ATOM31) {
-				rbt = array_uint16_le(data + offset + 6) & 0x01FF;
-				have_rbt = 1;
-			} else if (parser->model == I450T || parser->model == OC1A ||
-				parser->model == OC1B || parser->model == OC1C ||
-				parser->model == OCI) {
-				rbt = array_uint16_le(data + offset + 8) & 0x01FF;
-				have_rbt = 1;
-			} else if (parser->model == VISION || parser->model == XPAIR ||
-				parser->model == I550) {
-				rbt = array_uint16_le(data + offset + 6) & 0x03FF;
-				have_rbt = 1;
-			}
-			if (have_rbt) {
-				sample.rbt = rbt;
-				if (callback) callback (DC_SAMPLE_RBT, sample, userdata);
-			}
-
-			// Bookmarks
-			unsigned int have_bookmark = 0;
-			if (parser->model == OC1A || parser->model == OC1B ||
-				parser->model == OC1C || parser->model == OCI) {
-				have_bookmark = data[offset + 12] & 0x80;
-			}
-			if (have_bookmark) {
-				sample.event.type = SAMPLE_EVENT_BOOKMARK;
-				sample.event.time = 0;
-				sample.event.flags = 0;
-				sample.event.value = 0;
-				if (callback) callback (DC_SAMPLE_EVENT, sample, userdata);
 			}
 
 			count++;
-			complete = 1;
 		}
 
 		offset += length;
 	}
 
+	columns->count = nrows;
+
 	return DC_STATUS_SUCCESS;
 }
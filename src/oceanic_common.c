@@ -112,6 +112,24 @@ oceanic_common_match (const unsigned char *version, const oceanic_common_version
 }
 
 
+unsigned int
+oceanic_common_serial (const oceanic_common_layout_t *layout, const unsigned char id[])
+{
+	unsigned int serial = 0;
+	if (layout->pt_mode_serial == 0)
+		serial = bcd2dec (id[10]) * 10000 + bcd2dec (id[11]) * 100 + bcd2dec (id[12]);
+	else if (layout->pt_mode_serial == 1)
+		serial = id[11] * 10000 + id[12] * 100 + id[13];
+	else
+		serial =
+			(id[11] & 0x0F) * 100000 + ((id[11] & 0xF0) >> 4) * 10000 +
+			(id[12] & 0x0F) * 1000   + ((id[12] & 0xF0) >> 4) * 100 +
+			(id[13] & 0x0F) * 10     + ((id[13] & 0xF0) >> 4) * 1;
+
+	return serial;
+}
+
+
 void
 oceanic_common_device_init (oceanic_common_device_t *device)
 {
@@ -456,6 +474,27 @@ oceanic_common_device_profile (dc_device_t *abstract, dc_event_progress_t *progr
 			break;
 		}
 
+		// A gap of at least one packet is not downloaded at all. The
+		// ringbuffer stream is restarted at the end of the current dive
+		// instead, which never needs more packets than reading the gap.
+		if (gap >= PAGESIZE * device->multipage) {
+			dc_rbstream_free (rbstream);
+			rc = dc_rbstream_new (&rbstream, abstract, PAGESIZE, PAGESIZE * device->multipage, layout->rb_profile_begin, layout->rb_profile_end, rb_entry_end);
+			if (rc != DC_STATUS_SUCCESS) {
+				ERROR (abstract->context, "Failed to create the ringbuffer stream.");
+				free (profiles);
+				return rc;
+			}
+
+			// Update and emit a progress event.
+			progress->maximum -= gap;
+			device_event_emit (abstract, DC_EVENT_PROGRESS, progress);
+
+			offset -= gap;
+			remaining -= gap;
+			gap = 0;
+		}
+
 		// Move to the start of the current dive.
 		offset -= rb_entry_size + gap;
 
@@ -528,19 +567,11 @@ oceanic_common_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 	dc_event_devinfo_t devinfo;
 	devinfo.model = array_uint16_be (id + 8);
 	devinfo.firmware = 0;
-	if (layout->pt_mode_serial == 0)
-		devinfo.serial = bcd2dec (id[10]) * 10000 + bcd2dec (id[11]) * 100 + bcd2dec (id[12]);
-	else if (layout->pt_mode_serial == 1)
-		devinfo.serial = id[11] * 10000 + id[12] * 100 + id[13];
-	else
-		devinfo.serial =
-			(id[11] & 0x0F) * 100000 + ((id[11] & 0xF0) >> 4) * 10000 +
-			(id[12] & 0x0F) * 1000   + ((id[12] & 0xF0) >> 4) * 100 +
-			(id[13] & 0x0F) * 10     + ((id[13] & 0xF0) >> 4) * 1;
+	devinfo.serial = oceanic_common_serial (layout, id);
 	device_event_emit (abstract, DC_EVENT_DEVINFO, &devinfo);
 
 	// Memory buffer for the logbook data.
-	dc_buffer_t *logbook = dc_buffer_new (0);
+	dc_buffer_t *logbook = dc_buffer_new2 (abstract->context, 0);
 	if (logbook == NULL) {
 		return DC_STATUS_NOMEMORY;
 	}
@@ -77,6 +77,9 @@ typedef unsigned char oceanic_common_version_t[PAGESIZE + 1];
 int
 oceanic_common_match (const unsigned char *version, const oceanic_common_version_t patterns[], unsigned int n);
 
+unsigned int
+oceanic_common_serial (const oceanic_common_layout_t *layout, const unsigned char id[]);
+
 void
 oceanic_common_device_init (oceanic_common_device_t *device);
 
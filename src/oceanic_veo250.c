@@ -56,6 +56,7 @@ static const oceanic_common_device_vtable_t oceanic_veo250_device_vtable = {
 		NULL, /* write */
 		oceanic_common_device_dump, /* dump */
 		oceanic_common_device_foreach, /* foreach */
+		NULL, /* download */
 		NULL, /* timesync */
 		oceanic_veo250_device_close /* close */
 	},
@@ -119,6 +120,7 @@ oceanic_veo250_send (oceanic_veo250_device_t *device, const unsigned char comman
 	// Verify the response of the dive computer.
 	if (response != ACK) {
 		ERROR (abstract->context, "Unexpected answer start byte(s).");
+		device_stats_increment (abstract, DEVICE_STATS_NAK);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -148,6 +150,8 @@ oceanic_veo250_transfer (oceanic_veo250_device_t *device, const unsigned char co
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		device_stats_increment (abstract, DEVICE_STATS_RETRY);
+
 		// Delay the next attempt.
 		dc_iostream_sleep (device->iostream, 100);
 	}
@@ -258,6 +262,8 @@ oceanic_veo250_device_open (dc_device_t **out, dc_context_t *context, const char
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -401,6 +407,7 @@ oceanic_veo250_device_version (dc_device_t *abstract, unsigned char data[], unsi
 	unsigned char ccrc = checksum_add_uint8 (answer, PAGESIZE, 0x00);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -449,6 +456,7 @@ oceanic_veo250_device_read (dc_device_t *abstract, unsigned int address, unsigne
 			unsigned char ccrc = checksum_add_uint8 (answer + offset, PAGESIZE, 0x00);
 			if (crc != ccrc) {
 				ERROR (abstract->context, "Unexpected answer checksum.");
+				device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 				return DC_STATUS_PROTOCOL;
 			}
 
@@ -42,10 +42,6 @@ typedef struct oceanic_veo250_parser_t oceanic_veo250_parser_t;
 struct oceanic_veo250_parser_t {
 	dc_parser_t base;
 	unsigned int model;
-	// Cached fields.
-	unsigned int cached;
-	unsigned int divetime;
-	double maxdepth;
 };
 
 static dc_status_t oceanic_veo250_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
@@ -60,6 +56,8 @@ static const dc_parser_vtable_t oceanic_veo250_parser_vtable = {
 	oceanic_veo250_parser_get_datetime, /* datetime */
 	oceanic_veo250_parser_get_field, /* fields */
 	oceanic_veo250_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -81,9 +79,6 @@ oceanic_veo250_parser_create (dc_parser_t **out, dc_context_t *context, unsigned
 
 	// Set the default values.
 	parser->model = model;
-	parser->cached = 0;
-	parser->divetime = 0;
-	parser->maxdepth = 0.0;
 
 	*out = (dc_parser_t*) parser;
 
@@ -94,13 +89,6 @@ oceanic_veo250_parser_create (dc_parser_t **out, dc_context_t *context, unsigned
 static dc_status_t
 oceanic_veo250_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size)
 {
-	oceanic_veo250_parser_t *parser = (oceanic_veo250_parser_t *) abstract;
-
-	// Reset the cache.
-	parser->cached = 0;
-	parser->divetime = 0;
-	parser->maxdepth = 0.0;
-
 	return DC_STATUS_SUCCESS;
 }
 
@@ -137,28 +125,16 @@ oceanic_veo250_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *dateti
 static dc_status_t
 oceanic_veo250_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value)
 {
-	oceanic_veo250_parser_t *parser = (oceanic_veo250_parser_t *) abstract;
-
 	const unsigned char *data = abstract->data;
 	unsigned int size = abstract->size;
 
 	if (size < 7 * PAGESIZE / 2)
 		return DC_STATUS_DATAFORMAT;
 
-	if (!parser->cached) {
-		sample_statistics_t statistics = SAMPLE_STATISTICS_INITIALIZER;
-		dc_status_t rc = oceanic_veo250_parser_samples_foreach (
-			abstract, sample_statistics_cb, &statistics);
-		if (rc != DC_STATUS_SUCCESS)
-			return rc;
-
-		parser->cached = 1;
-		parser->divetime = statistics.divetime;
-		parser->maxdepth = statistics.maxdepth;
-	}
-
 	unsigned int footer = size - PAGESIZE;
 
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	const sample_statistics_t *statistics = NULL;
 	dc_gasmix_t *gasmix = (dc_gasmix_t *) value;
 
 	if (value) {
@@ -167,7 +143,10 @@ oceanic_veo250_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, un
 			*((unsigned int *) value) = data[footer + 3] * 60 + data[footer + 4] * 3600;
 			break;
 		case DC_FIELD_MAXDEPTH:
-			*((double *) value) = parser->maxdepth;
+			rc = dc_parser_profile_statistics (abstract, NULL, 0, &statistics);
+			if (rc != DC_STATUS_SUCCESS)
+				return rc;
+			*((double *) value) = statistics->result.maxdepth;
 			break;
 		case DC_FIELD_GASMIX_COUNT:
 				*((unsigned int *) value) = 1;
@@ -68,6 +68,7 @@ static const oceanic_common_device_vtable_t oceanic_vtpro_device_vtable = {
 		NULL, /* write */
 		oceanic_common_device_dump, /* dump */
 		oceanic_common_device_foreach, /* foreach */
+		NULL, /* download */
 		NULL, /* timesync */
 		oceanic_vtpro_device_close /* close */
 	},
@@ -157,6 +158,7 @@ oceanic_vtpro_send (oceanic_vtpro_device_t *device, const unsigned char command[
 	// Verify the response of the dive computer.
 	if (response != ACK) {
 		ERROR (abstract->context, "Unexpected answer start byte(s).");
+		device_stats_increment (abstract, DEVICE_STATS_NAK);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -185,6 +187,8 @@ oceanic_vtpro_transfer (oceanic_vtpro_device_t *device, const unsigned char comm
 		// Abort if the maximum number of retries is reached.
 		if (nretries++ >= MAXRETRIES)
 			return rc;
+
+		device_stats_increment (abstract, DEVICE_STATS_RETRY);
 	}
 
 	if (asize) {
@@ -352,6 +356,7 @@ oceanic_aeris500ai_device_logbook (dc_device_t *abstract, dc_event_progress_t *p
 		unsigned char ccrc = checksum_add_uint4 (answer, PAGESIZE / 2, 0x00);
 		if (crc != ccrc) {
 			ERROR (abstract->context, "Unexpected answer checksum.");
+			device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 			return DC_STATUS_PROTOCOL;
 		}
 
@@ -426,6 +431,8 @@ oceanic_vtpro_device_open (dc_device_t **out, dc_context_t *context, const char
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -580,6 +587,7 @@ oceanic_vtpro_device_version (dc_device_t *abstract, unsigned char data[], unsig
 	unsigned char ccrc = checksum_add_uint4 (ans, PAGESIZE / 2, 0x00);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -598,6 +606,7 @@ oceanic_vtpro_device_version (dc_device_t *abstract, unsigned char data[], unsig
 			unsigned char ccrc = checksum_add_uint4 (answer, PAGESIZE / 2, 0x00);
 			if (crc != ccrc) {
 				ERROR (abstract->context, "Unexpected answer checksum.");
+				device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 				return DC_STATUS_PROTOCOL;
 			}
 
@@ -656,6 +665,7 @@ oceanic_vtpro_device_read (dc_device_t *abstract, unsigned int address, unsigned
 			unsigned char ccrc = checksum_add_uint8 (answer + offset, PAGESIZE, 0x00);
 			if (crc != ccrc) {
 				ERROR (abstract->context, "Unexpected answer checksum.");
+				device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 				return DC_STATUS_PROTOCOL;
 			}
 
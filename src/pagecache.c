@@ -0,0 +1,383 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "pagecache.h"
+#include "context-private.h"
+#include "device-private.h"
+#include "array.h"
+
+/*
+ * The cache file starts with a magic string, followed by a fixed size
+ * header (family, serial number, memory size and page size), one byte
+ * for each page indicating whether it is present, and finally the
+ * memory contents. All numbers are stored in little endian byte order.
+ */
+#define MAGIC     "DCCACHE1"
+#define SZ_MAGIC  8
+#define SZ_HEADER 16
+
+struct dc_pagecache_t {
+	dc_device_t *device;
+	char *filename;
+	unsigned int family;
+	unsigned int serial;
+	unsigned int size;
+	unsigned int pagesize;
+	unsigned int npages;
+	unsigned int modified;
+	unsigned char *present;
+	unsigned char *data;
+};
+
+static void
+dc_pagecache_load (dc_pagecache_t *pagecache)
+{
+	dc_context_t *context = pagecache->device->context;
+	unsigned char magic[SZ_MAGIC] = {0};
+	unsigned char header[SZ_HEADER] = {0};
+
+	FILE *fp = fopen (pagecache->filename, "rb");
+	if (fp == NULL)
+		return;
+
+	if (fread (magic, sizeof (magic), 1, fp) != 1 ||
+		fread (header, sizeof (header), 1, fp) != 1 ||
+		memcmp (magic, MAGIC, SZ_MAGIC) != 0) {
+		WARNING (context, "Invalid cache file '%s'.", pagecache->filename);
+		goto error_close;
+	}
+
+	if (array_uint32_le (header + 0) != pagecache->family ||
+		array_uint32_le (header + 4) != pagecache->serial ||
+		array_uint32_le (header + 8) != pagecache->size ||
+		array_uint32_le (header + 12) != pagecache->pagesize) {
+		WARNING (context, "Incompatible cache file '%s'.", pagecache->filename);
+		goto error_close;
+	}
+
+	if (fread (pagecache->present, pagecache->npages, 1, fp) != 1 ||
+		fread (pagecache->data, pagecache->size, 1, fp) != 1) {
+		WARNING (context, "Truncated cache file '%s'.", pagecache->filename);
+		memset (pagecache->present, 0, pagecache->npages);
+		goto error_close;
+	}
+
+error_close:
+	fclose (fp);
+}
+
+static dc_status_t
+dc_pagecache_save (dc_pagecache_t *pagecache)
+{
+	dc_context_t *context = pagecache->device->context;
+	unsigned char header[SZ_HEADER] = {0};
+
+	array_uint32_le_set (header + 0, pagecache->family);
+	array_uint32_le_set (header + 4, pagecache->serial);
+	array_uint32_le_set (header + 8, pagecache->size);
+	array_uint32_le_set (header + 12, pagecache->pagesize);
+
+	FILE *fp = fopen (pagecache->filename, "wb");
+	if (fp == NULL) {
+		ERROR (context, "Failed to create the cache file '%s'.", pagecache->filename);
+		return DC_STATUS_IO;
+	}
+
+	if (fwrite (MAGIC, SZ_MAGIC, 1, fp) != 1 ||
+		fwrite (header, sizeof (header), 1, fp) != 1 ||
+		fwrite (pagecache->present, pagecache->npages, 1, fp) != 1 ||
+		fwrite (pagecache->data, pagecache->size, 1, fp) != 1) {
+		ERROR (context, "Failed to write the cache file '%s'.", pagecache->filename);
+		fclose (fp);
+		return DC_STATUS_IO;
+	}
+
+	if (fclose (fp) != 0) {
+		ERROR (context, "Failed to write the cache file '%s'.", pagecache->filename);
+		return DC_STATUS_IO;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_pagecache_new (dc_pagecache_t **out, dc_device_t *device, unsigned int serial, unsigned int size, unsigned int pagesize)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_pagecache_t *pagecache = NULL;
+
+	if (out == NULL || device == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Memory size should be a non-zero multiple of the page size.
+	if (size == 0 || pagesize == 0 || size % pagesize != 0) {
+		ERROR (device->context, "Memory size not a multiple of the page size!");
+		return DC_STATUS_INVALIDARGS;
+	}
+
+	// Allocate memory.
+	pagecache = (dc_pagecache_t *) dc_context_allocate (device->context, sizeof (*pagecache));
+	if (pagecache == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	pagecache->device = device;
+	pagecache->filename = NULL;
+	pagecache->family = dc_device_get_type (device);
+	pagecache->serial = serial;
+	pagecache->size = size;
+	pagecache->pagesize = pagesize;
+	pagecache->npages = size / pagesize;
+	pagecache->modified = 0;
+	pagecache->present = NULL;
+	pagecache->data = NULL;
+
+	pagecache->present = (unsigned char *) dc_context_allocate (device->context, pagecache->npages);
+	pagecache->data = (unsigned char *) dc_context_allocate (device->context, size);
+	if (pagecache->present == NULL || pagecache->data == NULL) {
+		ERROR (device->context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	memset (pagecache->present, 0, pagecache->npages);
+
+	// Load the cache file of the device.
+	if (dc_context_get_cache (device->context)) {
+		pagecache->filename = dc_context_get_cachefile (device->context, pagecache->family, pagecache->serial, "cache");
+		if (pagecache->filename == NULL) {
+			ERROR (device->context, "Failed to allocate memory.");
+			status = DC_STATUS_NOMEMORY;
+			goto error_free;
+		}
+	}
+
+	if (device->previous && dc_buffer_get_size (device->previous) == size) {
+		// Seed the cache with the previous memory dump.
+		memcpy (pagecache->data, dc_buffer_get_data (device->previous), size);
+		memset (pagecache->present, 1, pagecache->npages);
+		pagecache->modified = 1;
+	} else if (pagecache->filename) {
+		dc_pagecache_load (pagecache);
+	}
+
+	*out = pagecache;
+
+	return DC_STATUS_SUCCESS;
+
+error_free:
+	dc_context_deallocate (device->context, pagecache->filename);
+	dc_context_deallocate (device->context, pagecache->data);
+	dc_context_deallocate (device->context, pagecache->present);
+	dc_context_deallocate (device->context, pagecache);
+	return status;
+}
+
+static unsigned int
+dc_pagecache_present (dc_pagecache_t *pagecache, unsigned int address, unsigned int size)
+{
+	if (size == 0)
+		return 1;
+
+	unsigned int first = address / pagecache->pagesize;
+	unsigned int last = (address + size - 1) / pagecache->pagesize;
+	for (unsigned int i = first; i <= last; ++i) {
+		if (!pagecache->present[i])
+			return 0;
+	}
+
+	return 1;
+}
+
+dc_status_t
+dc_pagecache_get (dc_pagecache_t *pagecache, unsigned int address, unsigned char data[], unsigned int size)
+{
+	if (pagecache == NULL || address + size > pagecache->size)
+		return DC_STATUS_INVALIDARGS;
+
+	if (!dc_pagecache_present (pagecache, address, size))
+		return DC_STATUS_UNSUPPORTED;
+
+	if (size == 0)
+		return DC_STATUS_SUCCESS;
+
+	memcpy (data, pagecache->data + address, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_pagecache_put (dc_pagecache_t *pagecache, unsigned int address, const unsigned char data[], unsigned int size)
+{
+	if (pagecache == NULL || address + size > pagecache->size)
+		return DC_STATUS_INVALIDARGS;
+
+	memcpy (pagecache->data + address, data, size);
+
+	unsigned int first = (address + pagecache->pagesize - 1) / pagecache->pagesize;
+	unsigned int last = (address + size) / pagecache->pagesize;
+	for (unsigned int i = first; i < last; ++i) {
+		pagecache->present[i] = 1;
+	}
+
+	pagecache->modified = 1;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_pagecache_invalidate (dc_pagecache_t *pagecache, unsigned int address, unsigned int size)
+{
+	if (pagecache == NULL || address + size > pagecache->size)
+		return DC_STATUS_INVALIDARGS;
+
+	if (size == 0)
+		return DC_STATUS_SUCCESS;
+
+	unsigned int first = address / pagecache->pagesize;
+	unsigned int last = (address + size - 1) / pagecache->pagesize;
+	for (unsigned int i = first; i <= last; ++i) {
+		pagecache->present[i] = 0;
+	}
+
+	pagecache->modified = 1;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_pagecache_invalidate_ringbuffer (dc_pagecache_t *pagecache, unsigned int begin, unsigned int end, unsigned int address, unsigned int size)
+{
+	if (pagecache == NULL || begin >= end || end > pagecache->size ||
+		address < begin || address >= end)
+		return DC_STATUS_INVALIDARGS;
+
+	if (size > end - begin)
+		size = end - begin;
+
+	// Handle the ringbuffer wrap point.
+	if (address + size > end) {
+		dc_pagecache_invalidate (pagecache, begin, address + size - end);
+		size = end - address;
+	}
+
+	return dc_pagecache_invalidate (pagecache, address, size);
+}
+
+dc_status_t
+dc_pagecache_dump (dc_pagecache_t *pagecache, unsigned char data[], unsigned int size, unsigned int blocksize)
+{
+	if (pagecache == NULL || size > pagecache->size || blocksize == 0)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_device_t *device = pagecache->device;
+
+	if (device->vtable->read == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Enable progress notifications.
+	dc_event_progress_t progress = EVENT_PROGRESS_INITIALIZER;
+	progress.maximum = size;
+	device_event_emit (device, DC_EVENT_PROGRESS, &progress);
+
+	unsigned int ncached = 0;
+	unsigned int nbytes = 0;
+	unsigned int verify = 0;
+	while (nbytes < size) {
+		// Calculate the packet size.
+		unsigned int len = size - nbytes;
+		if (len > blocksize)
+			len = blocksize;
+
+		// Re-use the cached data, or read the packet.
+		unsigned int present = dc_pagecache_present (pagecache, nbytes, len);
+		if (present && !verify) {
+			memcpy (data + nbytes, pagecache->data + nbytes, len);
+			ncached += len;
+		} else {
+			dc_status_t rc = device->vtable->read (device, nbytes, data + nbytes, len);
+			if (rc != DC_STATUS_SUCCESS)
+				return rc;
+
+			// The caller only invalidates the pages that changed since the
+			// previous session, based on the state of the device. That
+			// can't tell whether a ringbuffer wrapped around completely in
+			// between. The first cached packet after the changed pages
+			// would then have been overwritten too, so it is read again,
+			// and compared with the cache.
+			if (present && memcmp (pagecache->data + nbytes, data + nbytes, len) != 0) {
+				WARNING (device->context, "Cached data no longer matches the device.");
+				memset (pagecache->present, 0, pagecache->npages);
+				dc_pagecache_put (pagecache, nbytes, data + nbytes, len);
+
+				// Start again, without the cache.
+				progress.maximum += nbytes + len;
+				progress.current += len;
+				device_event_emit (device, DC_EVENT_PROGRESS, &progress);
+				ncached = 0;
+				nbytes = 0;
+				verify = 0;
+				continue;
+			}
+
+			verify = !present;
+
+			dc_pagecache_put (pagecache, nbytes, data + nbytes, len);
+		}
+
+		// Update and emit a progress event.
+		progress.current += len;
+		device_event_emit (device, DC_EVENT_PROGRESS, &progress);
+
+		nbytes += len;
+	}
+
+	DEBUG (device->context, "Re-used %u of %u bytes from the cache.", ncached, size);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_pagecache_free (dc_pagecache_t *pagecache)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (pagecache == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_context_t *context = pagecache->device->context;
+
+	if (pagecache->filename && pagecache->modified) {
+		status = dc_pagecache_save (pagecache);
+	}
+
+	dc_context_deallocate (context, pagecache->filename);
+	dc_context_deallocate (context, pagecache->data);
+	dc_context_deallocate (context, pagecache->present);
+	dc_context_deallocate (context, pagecache);
+
+	return status;
+}
@@ -0,0 +1,143 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_PAGECACHE_H
+#define DC_PAGECACHE_H
+
+#include <libdivecomputer/device.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Opaque object representing a page cache.
+ */
+typedef struct dc_pagecache_t dc_pagecache_t;
+
+/**
+ * Create a new page cache for the memory of a device. If a cache
+ * directory is configured in the context, the pages stored during a
+ * previous session with the same device are loaded. Otherwise the
+ * cache starts empty, and is not stored. For an incremental dump, the
+ * previous memory dump takes precedence over the cache file, and all
+ * pages start out as present. The caller remains responsible for
+ * verifying that the data belongs to the same device.
+ *
+ * @param[out]  pagecache  A location to store the page cache.
+ * @param[in]   device     A valid device object.
+ * @param[in]   serial     The serial number of the device.
+ * @param[in]   size       The memory size in bytes.
+ * @param[in]   pagesize   The page size in bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_pagecache_new (dc_pagecache_t **pagecache, dc_device_t *device, unsigned int serial, unsigned int size, unsigned int pagesize);
+
+/**
+ * Get data from the page cache. All pages covering the range must be
+ * present in the cache.
+ *
+ * @param[in]  pagecache  A valid page cache.
+ * @param[in]  address    The start address.
+ * @param[out] data       The memory buffer to read the data into.
+ * @param[in]  size       The number of bytes to read.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if a
+ * page is not present, or another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_pagecache_get (dc_pagecache_t *pagecache, unsigned int address, unsigned char data[], unsigned int size);
+
+/**
+ * Store data in the page cache. Only the pages which are completely
+ * covered by the range become present in the cache.
+ *
+ * @param[in]  pagecache  A valid page cache.
+ * @param[in]  address    The start address.
+ * @param[in]  data       The data to store.
+ * @param[in]  size       The number of bytes to store.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_pagecache_put (dc_pagecache_t *pagecache, unsigned int address, const unsigned char data[], unsigned int size);
+
+/**
+ * Remove all pages which overlap with the range from the page cache.
+ *
+ * @param[in]  pagecache  A valid page cache.
+ * @param[in]  address    The start address.
+ * @param[in]  size       The number of bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_pagecache_invalidate (dc_pagecache_t *pagecache, unsigned int address, unsigned int size);
+
+/**
+ * Remove all pages which overlap with the range from the page cache.
+ * The range wraps around at the end of the ringbuffer.
+ *
+ * @param[in]  pagecache  A valid page cache.
+ * @param[in]  begin      The ringbuffer begin address.
+ * @param[in]  end        The ringbuffer end address.
+ * @param[in]  address    The start address.
+ * @param[in]  size       The number of bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_pagecache_invalidate_ringbuffer (dc_pagecache_t *pagecache, unsigned int begin, unsigned int end, unsigned int address, unsigned int size);
+
+/**
+ * Read the entire memory. The pages present in the cache are re-used,
+ * and the missing pages are read from the device with packets of the
+ * given size, and stored in the cache. The first cached packet after
+ * every range of missing pages is read from the device as well. If it
+ * no longer matches the cache, for example because a ringbuffer wrapped
+ * around completely since the previous session, the cache is discarded
+ * and the entire memory is read from the device.
+ *
+ * @param[in]  pagecache  A valid page cache.
+ * @param[out] data       The memory buffer to read the data into.
+ * @param[in]  size       The number of bytes to read.
+ * @param[in]  blocksize  The packet size in bytes.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_pagecache_dump (dc_pagecache_t *pagecache, unsigned char data[], unsigned int size, unsigned int blocksize);
+
+/**
+ * Store the page cache in the cache directory, and destroy it.
+ *
+ * @param[in]  pagecache  A valid page cache.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_pagecache_free (dc_pagecache_t *pagecache);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_PAGECACHE_H */
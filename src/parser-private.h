@@ -34,18 +34,98 @@ struct dc_parser_vtable_t;
 
 typedef struct dc_parser_vtable_t dc_parser_vtable_t;
 
+/*
+ * The results of the get_field function are cached in a number of
+ * slots. Each field type has its own slot, except for the gas mixes and
+ * the tanks, which have a slot per index. All slots together must fit
+ * into the bitmap with the valid entries.
+ */
+#define FIELD_CACHE_NTYPES (DC_FIELD_DIVEMODE + 1)
+#define FIELD_CACHE_NINDEX 8
+#define FIELD_CACHE_NSLOTS (FIELD_CACHE_NTYPES + 2 * FIELD_CACHE_NINDEX)
+
+typedef union field_value_t {
+	unsigned int number;
+	double real;
+	dc_gasmix_t gasmix;
+	dc_salinity_t salinity;
+	dc_tank_t tank;
+	dc_divemode_t divemode;
+} field_value_t;
+
+typedef struct field_cache_t {
+	unsigned int valid;
+	dc_status_t status[FIELD_CACHE_NSLOTS];
+	field_value_t value[FIELD_CACHE_NSLOTS];
+} field_cache_t;
+
+/*
+ * Accumulator for the dive statistics. The samples are collected per
+ * time sample, and each completed sample is added to the statistics.
+ */
+typedef struct sample_statistics_t {
+	dc_statistics_t result;
+	// Current sample.
+	unsigned int time;
+	double depth;
+	unsigned int have_time, have_depth;
+	// Previous sample with a depth.
+	unsigned int ptime;
+	double pdepth;
+	unsigned int have_previous;
+	// Tank pressure time range.
+	unsigned int begintime[DC_SAMPLE_MAXTANKS];
+	unsigned int endtime[DC_SAMPLE_MAXTANKS];
+	unsigned int firsttime;
+	double area;
+	// Time below the depth thresholds.
+	double below[DC_STATISTICS_MAXTHRESHOLDS];
+} sample_statistics_t;
+
+/*
+ * The construction parameters of a parser. Unused parsers are kept in a
+ * per-context pool, and are only handed out again for the same key.
+ */
+typedef struct dc_parser_key_t {
+	dc_family_t family;
+	unsigned int model;
+	unsigned int devtime;
+	dc_ticks_t systime;
+} dc_parser_key_t;
+
 struct dc_parser_t {
 	const dc_parser_vtable_t *vtable;
 	dc_context_t *context;
 	const unsigned char *data;
 	unsigned int size;
+	// Cached field values.
+	field_cache_t fieldcache;
+	// Cached profile statistics.
+	sample_statistics_t statistics;
+	dc_status_t statistics_status;
+	unsigned int statistics_valid;
+	// Parser pool.
+	dc_parser_key_t key;
+	unsigned int reusable;
+	dc_parser_t *next;
 };
 
+typedef struct dc_parser_pool_t {
+	dc_parser_t *head;
+	unsigned int count;
+	unsigned int capacity;
+} dc_parser_pool_t;
+
 struct dc_parser_vtable_t {
 	size_t size;
 
 	dc_family_t type;
 
+	/*
+	 * Reset the backend state for new dive data. It is also called with
+	 * NULL data and a zero size when the parser is reset, and then must
+	 * only clear the cached state, without accessing the data.
+	 */
 	dc_status_t (*set_data) (dc_parser_t *parser, const unsigned char *data, unsigned int size);
 
 	dc_status_t (*datetime) (dc_parser_t *parser, dc_datetime_t *datetime);
@@ -54,6 +134,26 @@ struct dc_parser_vtable_t {
 
 	dc_status_t (*samples_foreach) (dc_parser_t *parser, dc_sample_callback_t callback, void *userdata);
 
+	/*
+	 * Optional resumable decoder. The returned iterator decodes the
+	 * profile on demand, with the same result as the assembled samples
+	 * of the callback based path. Backends with fixed-size sample
+	 * records can decode one sample per call, the others wrap their
+	 * sample decoder with dc_sample_decoder_iterator. It returns
+	 * DC_STATUS_UNSUPPORTED for the dives it can't decode, and the
+	 * callback based path is used instead.
+	 */
+	dc_status_t (*samples_iterator) (dc_parser_t *parser, dc_iterator_t **iterator);
+
+	/*
+	 * Optional fast path for the sample columns, for backends with
+	 * fixed-size sample records. It fills in the columns directly, with
+	 * the same result as the callback based path. It returns
+	 * DC_STATUS_UNSUPPORTED for the columns it can't provide, and the
+	 * callback based path is used instead.
+	 */
+	dc_status_t (*samples_columns) (dc_parser_t *parser, dc_sample_columns_t *columns);
+
 	dc_status_t (*destroy) (dc_parser_t *parser);
 };
 
@@ -66,16 +166,68 @@ dc_parser_deallocate (dc_parser_t *parser);
 int
 dc_parser_isinstance (dc_parser_t *parser, const dc_parser_vtable_t *vtable);
 
-typedef struct sample_statistics_t {
-	unsigned int divetime;
-	double maxdepth;
-} sample_statistics_t;
+void
+dc_parser_invalidate (dc_parser_t *parser);
 
-#define SAMPLE_STATISTICS_INITIALIZER {0, 0.0}
+void
+dc_parser_pool_resize (dc_context_t *context, unsigned int capacity);
+
+/*
+ * Initialize count rows of the requested columns, starting at the first
+ * row, to the values of a sample without any fields. Rows beyond the
+ * capacity are ignored.
+ */
+void
+dc_sample_columns_clear (dc_sample_columns_t *columns, unsigned int first, unsigned int count);
+
+/*
+ * Resumable sample decoder. The backend embeds this structure as the
+ * first member of its decoder state. Each call to the step function
+ * decodes the next part of the profile (for example a single record),
+ * reports its values with the callback, and returns DC_STATUS_DONE at
+ * the end of the profile. The callback may be NULL.
+ */
+typedef struct dc_sample_decoder_t dc_sample_decoder_t;
+
+struct dc_sample_decoder_t {
+	dc_parser_t *parser;
+	dc_status_t (*step) (dc_sample_decoder_t *decoder, dc_sample_callback_t callback, void *userdata);
+};
+
+/*
+ * Run the decoder to the end of the profile, for the samples_foreach
+ * function of the backend.
+ */
+dc_status_t
+dc_sample_decoder_run (dc_sample_decoder_t *decoder, dc_sample_callback_t callback, void *userdata);
+
+/*
+ * Create a sample iterator that steps the decoder on demand. The state
+ * of the decoder, with the given size, is copied into the iterator.
+ * Only the samples of a single step are kept in memory.
+ */
+dc_status_t
+dc_sample_decoder_iterator (dc_iterator_t **iterator, const dc_sample_decoder_t *decoder, size_t size);
+
+void
+sample_statistics_init (sample_statistics_t *statistics, const double thresholds[], unsigned int nthresholds);
 
 void
 sample_statistics_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata);
 
+void
+sample_statistics_finish (sample_statistics_t *statistics);
+
+/*
+ * Get the statistics of the profile. The profile is walked only once
+ * for each dive, and the result is shared by all derived fields. A
+ * NULL thresholds array accepts the statistics calculated for any
+ * depth thresholds; otherwise the profile is walked again when the
+ * thresholds differ from the cached ones.
+ */
+dc_status_t
+dc_parser_profile_statistics (dc_parser_t *parser, const double thresholds[], unsigned int nthresholds, const sample_statistics_t **statistics);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -20,8 +20,12 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
 #include <assert.h>
 
+#include <libdivecomputer/units.h>
+
 #include "suunto_d9.h"
 #include "suunto_eon.h"
 #include "suunto_eonsteel.h"
@@ -60,9 +64,116 @@
 #include "context-private.h"
 #include "parser-private.h"
 #include "device-private.h"
+#include "iterator-private.h"
+#include "workqueue.h"
 
 #define REACTPROWHITE 0x4354
 
+#define BATCH_MAXCHUNK 16
+#define BATCH_WINDOW   4
+
+static dc_parser_t *
+dc_parser_pool_take (dc_context_t *context, dc_family_t family, unsigned int model, unsigned int devtime, dc_ticks_t systime)
+{
+	dc_parser_t *parser = NULL;
+
+	dc_parser_pool_t *pool = dc_context_get_parserpool (context);
+	if (pool == NULL)
+		return NULL;
+
+	dc_context_lock (context);
+
+	dc_parser_t **link = &pool->head;
+	while (*link) {
+		if ((*link)->key.family == family &&
+			(*link)->key.model == model &&
+			(*link)->key.devtime == devtime &&
+			(*link)->key.systime == systime) {
+			parser = *link;
+			*link = parser->next;
+			parser->next = NULL;
+			pool->count--;
+			break;
+		}
+		link = &(*link)->next;
+	}
+
+	dc_context_unlock (context);
+
+	return parser;
+}
+
+static int
+dc_parser_pool_give (dc_parser_t *parser)
+{
+	int kept = 0;
+
+	dc_parser_pool_t *pool = dc_context_get_parserpool (parser->context);
+	if (pool == NULL || !parser->reusable)
+		return 0;
+
+	// The reset may need the context, and is done without the lock.
+	dc_parser_reset (parser);
+
+	dc_context_lock (parser->context);
+
+	if (pool->count < pool->capacity) {
+		parser->next = pool->head;
+		pool->head = parser;
+		pool->count++;
+		kept = 1;
+	}
+
+	dc_context_unlock (parser->context);
+
+	return kept;
+}
+
+static dc_status_t
+dc_parser_free (dc_parser_t *parser)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	if (parser->vtable->destroy) {
+		status = parser->vtable->destroy (parser);
+	}
+
+	dc_parser_deallocate (parser);
+
+	return status;
+}
+
+void
+dc_parser_pool_resize (dc_context_t *context, unsigned int capacity)
+{
+	dc_parser_t *head = NULL;
+
+	dc_parser_pool_t *pool = dc_context_get_parserpool (context);
+	if (pool == NULL)
+		return;
+
+	dc_context_lock (context);
+
+	// Remove the most recently returned parsers first.
+	pool->capacity = capacity;
+	while (pool->count > capacity) {
+		dc_parser_t *parser = pool->head;
+		pool->head = parser->next;
+		pool->count--;
+		parser->next = head;
+		head = parser;
+	}
+
+	dc_context_unlock (context);
+
+	// Destroy the removed parsers without the lock.
+	while (head) {
+		dc_parser_t *next = head->next;
+		dc_parser_free (head);
+		head = next;
+	}
+}
+
 static dc_status_t
 dc_parser_new_internal (dc_parser_t **out, dc_context_t *context, dc_family_t family, unsigned int model, unsigned int devtime, dc_ticks_t systime)
 {
@@ -72,6 +183,13 @@ dc_parser_new_internal (dc_parser_t **out, dc_context_t *context, dc_family_t fa
 	if (out == NULL)
 		return DC_STATUS_INVALIDARGS;
 
+	// Reuse a parser from the pool.
+	parser = dc_parser_pool_take (context, family, model, devtime, systime);
+	if (parser) {
+		*out = parser;
+		return DC_STATUS_SUCCESS;
+	}
+
 	switch (family) {
 	case DC_FAMILY_SUUNTO_SOLUTION:
 		rc = suunto_solution_parser_create (&parser, context);
@@ -171,6 +289,14 @@ dc_parser_new_internal (dc_parser_t **out, dc_context_t *context, dc_family_t fa
 		return DC_STATUS_INVALIDARGS;
 	}
 
+	if (rc == DC_STATUS_SUCCESS) {
+		parser->key.family = family;
+		parser->key.model = model;
+		parser->key.devtime = devtime;
+		parser->key.systime = systime;
+		parser->reusable = 1;
+	}
+
 	*out = parser;
 
 	return rc;
@@ -204,7 +330,7 @@ dc_parser_allocate (dc_context_t *context, const dc_parser_vtable_t *vtable)
 	assert(vtable->size >= sizeof(dc_parser_t));
 
 	// Allocate memory.
-	parser = (dc_parser_t *) malloc (vtable->size);
+	parser = (dc_parser_t *) dc_context_allocate (context, vtable->size);
 	if (parser == NULL) {
 		ERROR (context, "Failed to allocate memory.");
 		return parser;
@@ -215,6 +341,10 @@ dc_parser_allocate (dc_context_t *context, const dc_parser_vtable_t *vtable)
 	parser->context = context;
 	parser->data = NULL;
 	parser->size = 0;
+	parser->fieldcache.valid = 0;
+	parser->statistics_valid = 0;
+	parser->reusable = 0;
+	parser->next = NULL;
 
 	return parser;
 }
@@ -222,7 +352,10 @@ dc_parser_allocate (dc_context_t *context, const dc_parser_vtable_t *vtable)
 void
 dc_parser_deallocate (dc_parser_t *parser)
 {
-	free (parser);
+	if (parser == NULL)
+		return;
+
+	dc_context_deallocate (parser->context, parser);
 }
 
 int
@@ -234,6 +367,16 @@ dc_parser_isinstance (dc_parser_t *parser, const dc_parser_vtable_t *vtable)
 	return parser->vtable == vtable;
 }
 
+void
+dc_parser_invalidate (dc_parser_t *parser)
+{
+	if (parser == NULL)
+		return;
+
+	parser->fieldcache.valid = 0;
+	parser->statistics_valid = 0;
+}
+
 
 dc_family_t
 dc_parser_get_type (dc_parser_t *parser)
@@ -257,10 +400,32 @@ dc_parser_set_data (dc_parser_t *parser, const unsigned char *data, unsigned int
 	parser->data = data;
 	parser->size = size;
 
+	dc_parser_invalidate (parser);
+
 	return parser->vtable->set_data (parser, data, size);
 }
 
 
+dc_status_t
+dc_parser_reset (dc_parser_t *parser)
+{
+	if (parser == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	parser->data = NULL;
+	parser->size = 0;
+
+	dc_parser_invalidate (parser);
+
+	// Clear the backend state as well. All backends accept empty data
+	// for this purpose, and don't access it.
+	if (parser->vtable->set_data == NULL)
+		return DC_STATUS_SUCCESS;
+
+	return parser->vtable->set_data (parser, NULL, 0);
+}
+
+
 dc_status_t
 dc_parser_get_datetime (dc_parser_t *parser, dc_datetime_t *datetime)
 {
@@ -273,6 +438,109 @@ dc_parser_get_datetime (dc_parser_t *parser, dc_datetime_t *datetime)
 	return parser->vtable->datetime (parser, datetime);
 }
 
+static size_t
+dc_parser_field_size (dc_field_type_t type)
+{
+	switch (type) {
+	case DC_FIELD_DIVETIME:
+	case DC_FIELD_GASMIX_COUNT:
+	case DC_FIELD_TANK_COUNT:
+		return sizeof (unsigned int);
+	case DC_FIELD_MAXDEPTH:
+	case DC_FIELD_AVGDEPTH:
+	case DC_FIELD_ATMOSPHERIC:
+	case DC_FIELD_TEMPERATURE_SURFACE:
+	case DC_FIELD_TEMPERATURE_MINIMUM:
+	case DC_FIELD_TEMPERATURE_MAXIMUM:
+		return sizeof (double);
+	case DC_FIELD_GASMIX:
+		return sizeof (dc_gasmix_t);
+	case DC_FIELD_SALINITY:
+		return sizeof (dc_salinity_t);
+	case DC_FIELD_TANK:
+		return sizeof (dc_tank_t);
+	case DC_FIELD_DIVEMODE:
+		return sizeof (dc_divemode_t);
+	default:
+		return 0;
+	}
+}
+
+static unsigned int
+dc_parser_field_slot (dc_field_type_t type, unsigned int flags)
+{
+	switch (type) {
+	case DC_FIELD_GASMIX:
+		if (flags >= FIELD_CACHE_NINDEX)
+			return FIELD_CACHE_NSLOTS;
+		return FIELD_CACHE_NTYPES + flags;
+	case DC_FIELD_TANK:
+		if (flags >= FIELD_CACHE_NINDEX)
+			return FIELD_CACHE_NSLOTS;
+		return FIELD_CACHE_NTYPES + FIELD_CACHE_NINDEX + flags;
+	default:
+		if (type >= FIELD_CACHE_NTYPES)
+			return FIELD_CACHE_NSLOTS;
+		return type;
+	}
+}
+
+static dc_status_t
+dc_parser_field_profile (dc_parser_t *parser, dc_field_type_t type, field_value_t *value)
+{
+	const sample_statistics_t *statistics = NULL;
+
+	switch (type) {
+	case DC_FIELD_DIVETIME:
+	case DC_FIELD_MAXDEPTH:
+	case DC_FIELD_AVGDEPTH:
+	case DC_FIELD_TEMPERATURE_MINIMUM:
+	case DC_FIELD_TEMPERATURE_MAXIMUM:
+		break;
+	default:
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	dc_status_t status = dc_parser_profile_statistics (parser, NULL, 0, &statistics);
+	if (status == DC_STATUS_NOMEMORY)
+		return status;
+	if (status != DC_STATUS_SUCCESS)
+		return DC_STATUS_UNSUPPORTED;
+
+	const dc_statistics_t *result = &statistics->result;
+	switch (type) {
+	case DC_FIELD_DIVETIME:
+		if (result->nsamples == 0)
+			return DC_STATUS_UNSUPPORTED;
+		value->number = result->divetime;
+		break;
+	case DC_FIELD_MAXDEPTH:
+		if (!statistics->have_previous)
+			return DC_STATUS_UNSUPPORTED;
+		value->real = result->maxdepth;
+		break;
+	case DC_FIELD_AVGDEPTH:
+		if (!statistics->have_previous)
+			return DC_STATUS_UNSUPPORTED;
+		value->real = result->avgdepth;
+		break;
+	case DC_FIELD_TEMPERATURE_MINIMUM:
+		if (isnan (result->temperature_minimum))
+			return DC_STATUS_UNSUPPORTED;
+		value->real = result->temperature_minimum;
+		break;
+	case DC_FIELD_TEMPERATURE_MAXIMUM:
+		if (isnan (result->temperature_maximum))
+			return DC_STATUS_UNSUPPORTED;
+		value->real = result->temperature_maximum;
+		break;
+	default:
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
 dc_status_t
 dc_parser_get_field (dc_parser_t *parser, dc_field_type_t type, unsigned int flags, void *value)
 {
@@ -282,7 +550,48 @@ dc_parser_get_field (dc_parser_t *parser, dc_field_type_t type, unsigned int fla
 	if (parser->vtable->field == NULL)
 		return DC_STATUS_UNSUPPORTED;
 
-	return parser->vtable->field (parser, type, flags, value);
+	// Fields that can't be cached are passed through.
+	size_t size = dc_parser_field_size (type);
+	unsigned int slot = dc_parser_field_slot (type, flags);
+	if (value == NULL || size == 0 || slot >= FIELD_CACHE_NSLOTS)
+		return parser->vtable->field (parser, type, flags, value);
+
+	field_cache_t *cache = &parser->fieldcache;
+	if ((cache->valid & (1u << slot)) == 0) {
+		field_value_t result;
+		memset (&result, 0, sizeof (result));
+
+		dc_status_t status = parser->vtable->field (parser, type, flags, &result);
+		if (status == DC_STATUS_NOMEMORY)
+			return status;
+
+		cache->status[slot] = status;
+		cache->value[slot] = result;
+		cache->valid |= (1u << slot);
+	}
+
+	if (cache->status[slot] == DC_STATUS_SUCCESS)
+		memcpy (value, &cache->value[slot], size);
+
+	return cache->status[slot];
+}
+
+dc_status_t
+dc_parser_get_field_derived (dc_parser_t *parser, dc_field_type_t type, unsigned int flags, void *value)
+{
+	dc_status_t status = dc_parser_get_field (parser, type, flags, value);
+	if (status != DC_STATUS_UNSUPPORTED || parser == NULL)
+		return status;
+
+	// Derive the missing values from the profile.
+	field_value_t result;
+	memset (&result, 0, sizeof (result));
+
+	status = dc_parser_field_profile (parser, type, &result);
+	if (status == DC_STATUS_SUCCESS && value)
+		memcpy (value, &result, dc_parser_field_size (type));
+
+	return status;
 }
 
 
@@ -299,38 +608,887 @@ dc_parser_samples_foreach (dc_parser_t *parser, dc_sample_callback_t callback, v
 }
 
 
+typedef struct dc_sample_iterator_t {
+	dc_iterator_t base;
+	dc_context_t *context;
+	dc_sample_t *samples;
+	size_t count, capacity;
+	size_t current;
+	dc_status_t status;
+	dc_sample_decoder_t *decoder;
+} dc_sample_iterator_t;
+
+static dc_status_t dc_sample_iterator_next (dc_iterator_t *iterator, void *item);
+static dc_status_t dc_sample_iterator_free (dc_iterator_t *iterator);
+
+static const dc_iterator_vtable_t dc_sample_iterator_vtable = {
+	dc_sample_iterator_free,
+	dc_sample_iterator_next
+};
+
+static void
+sample_assemble (dc_context_t *context, dc_sample_t *sample, dc_sample_type_t type, dc_sample_value_t value)
+{
+	switch (type) {
+	case DC_SAMPLE_TIME:
+		sample->time = value.time;
+		break;
+	case DC_SAMPLE_DEPTH:
+		sample->depth = value.depth;
+		break;
+	case DC_SAMPLE_PRESSURE:
+		if (sample->npressures >= DC_SAMPLE_MAXTANKS) {
+			WARNING (context, "Too many tank pressures in sample (t=%u).", sample->time);
+			return;
+		}
+		sample->pressure[sample->npressures].tank = value.pressure.tank;
+		sample->pressure[sample->npressures].value = value.pressure.value;
+		sample->npressures++;
+		break;
+	case DC_SAMPLE_TEMPERATURE:
+		sample->temperature = value.temperature;
+		break;
+	case DC_SAMPLE_EVENT:
+		if (sample->nevents >= DC_SAMPLE_MAXEVENTS) {
+			WARNING (context, "Too many events in sample (t=%u).", sample->time);
+			return;
+		}
+		sample->event[sample->nevents].type = value.event.type;
+		sample->event[sample->nevents].time = value.event.time;
+		sample->event[sample->nevents].flags = value.event.flags;
+		sample->event[sample->nevents].value = value.event.value;
+		sample->nevents++;
+		break;
+	case DC_SAMPLE_RBT:
+		sample->rbt = value.rbt;
+		break;
+	case DC_SAMPLE_HEARTBEAT:
+		sample->heartbeat = value.heartbeat;
+		break;
+	case DC_SAMPLE_BEARING:
+		sample->bearing = value.bearing;
+		break;
+	case DC_SAMPLE_VENDOR:
+		sample->vendor.type = value.vendor.type;
+		sample->vendor.size = value.vendor.size;
+		sample->vendor.data = value.vendor.data;
+		break;
+	case DC_SAMPLE_SETPOINT:
+		sample->setpoint = value.setpoint;
+		break;
+	case DC_SAMPLE_PPO2:
+		if (sample->nppo2 >= DC_SAMPLE_MAXSENSORS) {
+			WARNING (context, "Too many ppO2 sensors in sample (t=%u).", sample->time);
+			return;
+		}
+		sample->ppo2[sample->nppo2++] = value.ppo2;
+		break;
+	case DC_SAMPLE_CNS:
+		sample->cns = value.cns;
+		break;
+	case DC_SAMPLE_DECO:
+		sample->deco.type = value.deco.type;
+		sample->deco.time = value.deco.time;
+		sample->deco.depth = value.deco.depth;
+		break;
+	case DC_SAMPLE_GASMIX:
+		sample->gasmix = value.gasmix;
+		break;
+	default:
+		return;
+	}
+
+	sample->fields |= (1 << type);
+}
+
+static dc_status_t
+dc_sample_iterator_push (dc_sample_iterator_t *iterator)
+{
+	if (iterator->count >= iterator->capacity) {
+		size_t capacity = iterator->capacity ? iterator->capacity * 2 : 256;
+		dc_sample_t *samples = (dc_sample_t *) dc_context_reallocate (iterator->context, iterator->samples, capacity * sizeof (dc_sample_t));
+		if (samples == NULL) {
+			ERROR (iterator->context, "Failed to allocate memory.");
+			return DC_STATUS_NOMEMORY;
+		}
+
+		iterator->samples = samples;
+		iterator->capacity = capacity;
+	}
+
+	memset (iterator->samples + iterator->count, 0, sizeof (dc_sample_t));
+	iterator->count++;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_sample_iterator_t *
+dc_sample_iterator_allocate (dc_context_t *context)
+{
+	dc_sample_iterator_t *iterator = (dc_sample_iterator_t *) dc_context_allocate (context, sizeof (dc_sample_iterator_t));
+	if (iterator == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return NULL;
+	}
+
+	iterator->base.vtable = &dc_sample_iterator_vtable;
+	iterator->context = context;
+	iterator->samples = NULL;
+	iterator->count = 0;
+	iterator->capacity = 0;
+	iterator->current = 0;
+	iterator->status = DC_STATUS_SUCCESS;
+	iterator->decoder = NULL;
+
+	return iterator;
+}
+
+static void
+dc_sample_iterator_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	dc_sample_iterator_t *iterator = (dc_sample_iterator_t *) userdata;
+
+	if (iterator->status != DC_STATUS_SUCCESS)
+		return;
+
+	// A time sample starts a new record. Samples reported before the
+	// first time sample are collected into the first record.
+	if (iterator->count == 0 || (type == DC_SAMPLE_TIME &&
+		(iterator->samples[iterator->count - 1].fields & (1 << DC_SAMPLE_TIME)))) {
+		iterator->status = dc_sample_iterator_push (iterator);
+		if (iterator->status != DC_STATUS_SUCCESS)
+			return;
+	}
+
+	sample_assemble (iterator->context, iterator->samples + iterator->count - 1, type, value);
+}
+
 dc_status_t
-dc_parser_destroy (dc_parser_t *parser)
+dc_parser_samples_iterator (dc_iterator_t **out, dc_parser_t *parser)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_sample_iterator_t *iterator = NULL;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (parser == NULL || parser->vtable->samples_foreach == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Use the resumable decoder of the backend, if available.
+	if (parser->vtable->samples_iterator) {
+		status = parser->vtable->samples_iterator (parser, out);
+		if (status != DC_STATUS_UNSUPPORTED)
+			return status;
+	}
+
+	iterator = dc_sample_iterator_allocate (parser->context);
+	if (iterator == NULL)
+		return DC_STATUS_NOMEMORY;
+
+	// Without a resumable decoder, all samples are assembled in a
+	// single pass over the profile.
+	status = parser->vtable->samples_foreach (parser, dc_sample_iterator_cb, iterator);
+	if (status == DC_STATUS_SUCCESS)
+		status = iterator->status;
+	if (status != DC_STATUS_SUCCESS) {
+		dc_sample_iterator_free ((dc_iterator_t *) iterator);
+		return status;
+	}
+
+	*out = (dc_iterator_t *) iterator;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_sample_decoder_run (dc_sample_decoder_t *decoder, dc_sample_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	do {
+		status = decoder->step (decoder, callback, userdata);
+	} while (status == DC_STATUS_SUCCESS);
+
+	if (status == DC_STATUS_DONE)
+		status = DC_STATUS_SUCCESS;
+
+	return status;
+}
+
+dc_status_t
+dc_sample_decoder_iterator (dc_iterator_t **out, const dc_sample_decoder_t *decoder, size_t size)
+{
+	dc_context_t *context = decoder->parser->context;
+	dc_sample_iterator_t *iterator = NULL;
+
+	iterator = dc_sample_iterator_allocate (context);
+	if (iterator == NULL)
+		return DC_STATUS_NOMEMORY;
+
+	iterator->decoder = (dc_sample_decoder_t *) dc_context_allocate (context, size);
+	if (iterator->decoder == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		dc_context_deallocate (context, iterator);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	memcpy (iterator->decoder, decoder, size);
+
+	*out = (dc_iterator_t *) iterator;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_sample_iterator_free (dc_iterator_t *abstract)
+{
+	dc_sample_iterator_t *iterator = (dc_sample_iterator_t *) abstract;
+
+	dc_context_deallocate (iterator->context, iterator->decoder);
+	dc_context_deallocate (iterator->context, iterator->samples);
+	dc_context_deallocate (iterator->context, iterator);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_sample_iterator_next (dc_iterator_t *abstract, void *out)
+{
+	dc_sample_iterator_t *iterator = (dc_sample_iterator_t *) abstract;
+	dc_sample_t *sample = (dc_sample_t *) out;
+
+	// Step the decoder until a complete sample is available. The last
+	// sample is only complete once the next time sample is reported, or
+	// at the end of the profile.
+	while (iterator->decoder && iterator->current + 1 >= iterator->count) {
+		// Keep only the incomplete sample.
+		if (iterator->current) {
+			iterator->count -= iterator->current;
+			memmove (iterator->samples, iterator->samples + iterator->current, iterator->count * sizeof (dc_sample_t));
+			iterator->current = 0;
+		}
+
+		dc_status_t status = iterator->decoder->step (iterator->decoder, dc_sample_iterator_cb, iterator);
+		if (status != DC_STATUS_SUCCESS && status != DC_STATUS_DONE)
+			iterator->status = status;
+
+		// The decoder is no longer needed at the end of the profile, or
+		// after an error.
+		if (status != DC_STATUS_SUCCESS || iterator->status != DC_STATUS_SUCCESS) {
+			dc_context_deallocate (iterator->context, iterator->decoder);
+			iterator->decoder = NULL;
+		}
+	}
+
+	if (iterator->status != DC_STATUS_SUCCESS)
+		return iterator->status;
+
+	if (iterator->current >= iterator->count)
+		return DC_STATUS_DONE;
+
+	*sample = iterator->samples[iterator->current++];
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+typedef struct dc_sample_columns_state_t {
+	dc_sample_columns_t *columns;
+	unsigned int time;
+	unsigned int nppo2;
+} dc_sample_columns_state_t;
+
+void
+dc_sample_columns_clear (dc_sample_columns_t *columns, unsigned int first, unsigned int count)
+{
+	if (first >= columns->capacity)
+		return;
+	if (count > columns->capacity - first)
+		count = columns->capacity - first;
+
+	unsigned int last = first + count;
+
+	// Column by column, rather than row by row.
+	for (unsigned int i = first; columns->fields && i < last; ++i)
+		columns->fields[i] = 0;
+	for (unsigned int i = first; columns->time && i < last; ++i)
+		columns->time[i] = 0;
+	for (unsigned int i = first; columns->depth && i < last; ++i)
+		columns->depth[i] = NAN;
+	for (unsigned int i = first; columns->temperature && i < last; ++i)
+		columns->temperature[i] = NAN;
+	for (unsigned int t = 0; columns->pressure && t < columns->ntanks; ++t) {
+		for (unsigned int i = first; i < last; ++i)
+			columns->pressure[t * columns->capacity + i] = NAN;
+	}
+	for (unsigned int i = first; columns->ppo2 && i < last; ++i)
+		columns->ppo2[i] = NAN;
+	for (unsigned int i = first; columns->cns && i < last; ++i)
+		columns->cns[i] = NAN;
+	for (unsigned int i = first; columns->deco_type && i < last; ++i)
+		columns->deco_type[i] = 0;
+	for (unsigned int i = first; columns->deco_time && i < last; ++i)
+		columns->deco_time[i] = 0;
+	for (unsigned int i = first; columns->deco_depth && i < last; ++i)
+		columns->deco_depth[i] = NAN;
+}
+
+static void
+dc_sample_columns_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
+{
+	dc_sample_columns_state_t *state = (dc_sample_columns_state_t *) userdata;
+	dc_sample_columns_t *columns = state->columns;
+
+	// A time sample starts a new row. Samples reported before the
+	// first time sample are stored in the first row.
+	if (columns->count == 0 || (type == DC_SAMPLE_TIME && state->time)) {
+		dc_sample_columns_clear (columns, columns->count, 1);
+		columns->count++;
+		state->time = 0;
+		state->nppo2 = 0;
+	}
+
+	if (type == DC_SAMPLE_TIME)
+		state->time = 1;
+
+	unsigned int row = columns->count - 1;
+	if (row >= columns->capacity)
+		return;
+
+	switch (type) {
+	case DC_SAMPLE_TIME:
+		if (columns->time)
+			columns->time[row] = value.time;
+		break;
+	case DC_SAMPLE_DEPTH:
+		if (columns->depth)
+			columns->depth[row] = value.depth;
+		break;
+	case DC_SAMPLE_TEMPERATURE:
+		if (columns->temperature)
+			columns->temperature[row] = value.temperature;
+		break;
+	case DC_SAMPLE_PRESSURE:
+		if (columns->pressure && value.pressure.tank < columns->ntanks)
+			columns->pressure[value.pressure.tank * columns->capacity + row] = value.pressure.value;
+		break;
+	case DC_SAMPLE_PPO2:
+		if (columns->ppo2) {
+			if (state->nppo2 == 0)
+				columns->ppo2[row] = value.ppo2;
+			else
+				columns->ppo2[row] = (columns->ppo2[row] * state->nppo2 + value.ppo2) / (state->nppo2 + 1);
+		}
+		state->nppo2++;
+		break;
+	case DC_SAMPLE_CNS:
+		if (columns->cns)
+			columns->cns[row] = value.cns;
+		break;
+	case DC_SAMPLE_DECO:
+		if (columns->deco_type)
+			columns->deco_type[row] = value.deco.type;
+		if (columns->deco_time)
+			columns->deco_time[row] = value.deco.time;
+		if (columns->deco_depth)
+			columns->deco_depth[row] = value.deco.depth;
+		break;
+	default:
+		break;
+	}
+
+	if (columns->fields)
+		columns->fields[row] |= (1 << type);
+}
+
+dc_status_t
+dc_parser_samples_get_columns (dc_parser_t *parser, dc_sample_columns_t *columns)
 {
 	dc_status_t status = DC_STATUS_SUCCESS;
 
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (parser->vtable->samples_foreach == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (columns == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	columns->count = 0;
+
+	// Try the fast path of the backend first.
+	if (parser->vtable->samples_columns) {
+		status = parser->vtable->samples_columns (parser, columns);
+		if (status != DC_STATUS_UNSUPPORTED)
+			return status;
+		columns->count = 0;
+	}
+
+	dc_sample_columns_state_t state = {columns, 0, 0};
+
+	return parser->vtable->samples_foreach (parser, dc_sample_columns_cb, &state);
+}
+
+
+dc_status_t
+dc_parser_destroy (dc_parser_t *parser)
+{
 	if (parser == NULL)
 		return DC_STATUS_SUCCESS;
 
-	if (parser->vtable->destroy) {
-		status = parser->vtable->destroy (parser);
+	// Keep the parser for reuse.
+	if (dc_parser_pool_give (parser))
+		return DC_STATUS_SUCCESS;
+
+	return dc_parser_free (parser);
+}
+
+
+void
+sample_statistics_init (sample_statistics_t *statistics, const double thresholds[], unsigned int nthresholds)
+{
+	memset (statistics, 0, sizeof (sample_statistics_t));
+
+	if (nthresholds > DC_STATISTICS_MAXTHRESHOLDS)
+		nthresholds = DC_STATISTICS_MAXTHRESHOLDS;
+
+	statistics->result.nthresholds = nthresholds;
+	for (unsigned int i = 0; i < nthresholds; ++i) {
+		statistics->result.threshold[i] = thresholds[i];
 	}
 
-	dc_parser_deallocate (parser);
+	statistics->result.temperature_surface = NAN;
+	statistics->result.temperature_minimum = NAN;
+	statistics->result.temperature_maximum = NAN;
+	for (unsigned int i = 0; i < DC_SAMPLE_MAXTANKS; ++i) {
+		statistics->result.tank[i].beginpressure = NAN;
+		statistics->result.tank[i].endpressure = NAN;
+		statistics->result.tank[i].sac = NAN;
+	}
+}
 
-	return status;
+static void
+sample_statistics_segment (sample_statistics_t *statistics, unsigned int t0, double d0, unsigned int t1, double d1)
+{
+	dc_statistics_t *result = &statistics->result;
+
+	if (t1 <= t0)
+		return;
+
+	unsigned int dt = t1 - t0;
+
+	// Time-weighted depth.
+	statistics->area += (d0 + d1) / 2.0 * dt;
+
+	// Ascent rate histogram.
+	if (d1 < d0) {
+		double rate = (d0 - d1) * 60.0 / dt;
+		unsigned int bin = rate / DC_STATISTICS_ASCENTRATE;
+		if (bin >= DC_STATISTICS_NASCENTRATES)
+			bin = DC_STATISTICS_NASCENTRATES - 1;
+		result->ascentrate[bin] += dt;
+	}
+
+	// Time below the depth thresholds, with linear interpolation
+	// for the segments crossing a threshold.
+	double shallow = d0 < d1 ? d0 : d1;
+	double deep = d0 < d1 ? d1 : d0;
+	for (unsigned int i = 0; i < result->nthresholds; ++i) {
+		double threshold = result->threshold[i];
+		if (shallow >= threshold) {
+			statistics->below[i] += dt;
+		} else if (deep > threshold) {
+			statistics->below[i] += dt * (deep - threshold) / (deep - shallow);
+		}
+	}
 }
 
+static void
+sample_statistics_flush (sample_statistics_t *statistics)
+{
+	if (!statistics->have_time)
+		return;
+
+	if (statistics->result.nsamples == 0)
+		statistics->firsttime = statistics->time;
+
+	statistics->result.nsamples++;
+	statistics->result.divetime = statistics->time;
+
+	if (statistics->have_depth) {
+		if (statistics->have_previous) {
+			sample_statistics_segment (statistics,
+				statistics->ptime, statistics->pdepth,
+				statistics->time, statistics->depth);
+		} else {
+			statistics->firsttime = statistics->time;
+		}
+
+		statistics->ptime = statistics->time;
+		statistics->pdepth = statistics->depth;
+		statistics->have_previous = 1;
+	}
+
+	statistics->have_time = 0;
+	statistics->have_depth = 0;
+}
 
 void
 sample_statistics_cb (dc_sample_type_t type, dc_sample_value_t value, void *userdata)
 {
 	sample_statistics_t *statistics  = (sample_statistics_t *) userdata;
+	dc_statistics_t *result = &statistics->result;
 
 	switch (type) {
 	case DC_SAMPLE_TIME:
-		statistics->divetime = value.time;
+		sample_statistics_flush (statistics);
+		statistics->time = value.time;
+		statistics->have_time = 1;
 		break;
 	case DC_SAMPLE_DEPTH:
-		if (statistics->maxdepth < value.depth)
-			statistics->maxdepth = value.depth;
+		if (result->maxdepth < value.depth)
+			result->maxdepth = value.depth;
+		statistics->depth = value.depth;
+		statistics->have_depth = 1;
+		break;
+	case DC_SAMPLE_TEMPERATURE:
+		if (isnan (result->temperature_surface))
+			result->temperature_surface = value.temperature;
+		if (isnan (result->temperature_minimum) || value.temperature < result->temperature_minimum)
+			result->temperature_minimum = value.temperature;
+		if (isnan (result->temperature_maximum) || value.temperature > result->temperature_maximum)
+			result->temperature_maximum = value.temperature;
+		break;
+	case DC_SAMPLE_PRESSURE:
+		if (value.pressure.tank >= DC_SAMPLE_MAXTANKS)
+			break;
+		if (result->ntanks <= value.pressure.tank)
+			result->ntanks = value.pressure.tank + 1;
+		if (isnan (result->tank[value.pressure.tank].beginpressure)) {
+			result->tank[value.pressure.tank].beginpressure = value.pressure.value;
+			statistics->begintime[value.pressure.tank] = statistics->time;
+		}
+		result->tank[value.pressure.tank].endpressure = value.pressure.value;
+		statistics->endtime[value.pressure.tank] = statistics->time;
 		break;
 	default:
 		break;
 	}
 }
+
+void
+sample_statistics_finish (sample_statistics_t *statistics)
+{
+	dc_statistics_t *result = &statistics->result;
+
+	sample_statistics_flush (statistics);
+
+	for (unsigned int i = 0; i < result->nthresholds; ++i) {
+		result->below[i] = statistics->below[i] + 0.5;
+	}
+
+	if (statistics->have_previous && statistics->ptime > statistics->firsttime) {
+		result->avgdepth = statistics->area / (statistics->ptime - statistics->firsttime);
+	} else {
+		result->avgdepth = statistics->pdepth;
+	}
+}
+
+dc_status_t
+dc_parser_profile_statistics (dc_parser_t *parser, const double thresholds[], unsigned int nthresholds, const sample_statistics_t **out)
+{
+	sample_statistics_t *statistics = &parser->statistics;
+
+	if (parser->vtable->samples_foreach == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (nthresholds > DC_STATISTICS_MAXTHRESHOLDS)
+		nthresholds = DC_STATISTICS_MAXTHRESHOLDS;
+
+	// Re-use the cached statistics, unless other thresholds are requested.
+	unsigned int valid = parser->statistics_valid;
+	if (valid && thresholds) {
+		if (statistics->result.nthresholds != nthresholds) {
+			valid = 0;
+		} else {
+			for (unsigned int i = 0; i < nthresholds; ++i) {
+				if (statistics->result.threshold[i] != thresholds[i])
+					valid = 0;
+			}
+		}
+	}
+
+	if (!valid) {
+		sample_statistics_init (statistics, thresholds, thresholds ? nthresholds : 0);
+
+		dc_status_t status = parser->vtable->samples_foreach (parser, sample_statistics_cb, statistics);
+		if (status == DC_STATUS_NOMEMORY)
+			return status;
+
+		if (status == DC_STATUS_SUCCESS)
+			sample_statistics_finish (statistics);
+
+		parser->statistics_status = status;
+		parser->statistics_valid = 1;
+	}
+
+	if (parser->statistics_status == DC_STATUS_SUCCESS)
+		*out = statistics;
+
+	return parser->statistics_status;
+}
+
+
+dc_status_t
+dc_parser_get_statistics (dc_parser_t *parser, dc_statistics_t *statistics)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	const sample_statistics_t *accumulator = NULL;
+
+	if (parser == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (parser->vtable->samples_foreach == NULL)
+		return DC_STATUS_UNSUPPORTED;
+
+	if (statistics == NULL || statistics->nthresholds > DC_STATISTICS_MAXTHRESHOLDS)
+		return DC_STATUS_INVALIDARGS;
+
+	status = dc_parser_profile_statistics (parser, statistics->threshold, statistics->nthresholds, &accumulator);
+	if (status != DC_STATUS_SUCCESS)
+		return status;
+
+	dc_statistics_t result = accumulator->result;
+
+	// The surface air consumption requires the tank volume, and the
+	// ambient pressure at the average depth.
+	double atmospheric = ATM / BAR;
+	if (dc_parser_get_field (parser, DC_FIELD_ATMOSPHERIC, 0, &atmospheric) != DC_STATUS_SUCCESS)
+		atmospheric = ATM / BAR;
+	dc_salinity_t salinity = {DC_WATER_SALT, 0.0};
+	if (dc_parser_get_field (parser, DC_FIELD_SALINITY, 0, &salinity) != DC_STATUS_SUCCESS)
+		salinity.type = DC_WATER_SALT;
+	if (salinity.density == 0.0)
+		salinity.density = (salinity.type == DC_WATER_FRESH ? 1000.0 : 1025.0);
+	double ambient = atmospheric + result.avgdepth * salinity.density * GRAVITY / BAR;
+
+	for (unsigned int i = 0; i < result.ntanks; ++i) {
+		dc_tank_t tank = {0};
+		if (dc_parser_get_field (parser, DC_FIELD_TANK, i, &tank) != DC_STATUS_SUCCESS ||
+			tank.type == DC_TANKVOLUME_NONE || tank.volume <= 0.0)
+			continue;
+
+		// The volume of an imperial tank is the air capacity at the
+		// working pressure, instead of the water capacity.
+		double volume = tank.volume;
+		if (tank.type == DC_TANKVOLUME_IMPERIAL) {
+			if (tank.workpressure <= 0.0)
+				continue;
+			volume = tank.volume * ATM / (tank.workpressure * BAR);
+		}
+
+		double duration = (accumulator->endtime[i] - accumulator->begintime[i]) / 60.0;
+		double used = result.tank[i].beginpressure - result.tank[i].endpressure;
+		if (duration <= 0.0 || used <= 0.0)
+			continue;
+
+		result.tank[i].sac = used * volume / duration / ambient;
+	}
+
+	*statistics = result;
+
+	return DC_STATUS_SUCCESS;
+}
+
+
+typedef struct dc_parser_batch_result_t {
+	dc_parser_t *parser;
+	dc_status_t status;
+} dc_parser_batch_result_t;
+
+typedef struct dc_parser_batch_t {
+	dc_context_t *context;
+	const dc_parser_batch_entry_t *entries;
+	dc_parser_batch_result_t *results;
+	unsigned int begin;
+	unsigned int end;
+} dc_parser_batch_t;
+
+/*
+ * Parse all entries on the calling thread, and reuse the parser for
+ * consecutive entries with the same descriptor and clock.
+ */
+static void
+dc_parser_batch_serial (dc_context_t *context, const dc_parser_batch_entry_t entries[], unsigned int count, dc_parser_batch_callback_t callback, void *userdata)
+{
+	dc_parser_t *parser = NULL;
+
+	for (unsigned int i = 0; i < count; ++i) {
+		const dc_parser_batch_entry_t *entry = entries + i;
+		dc_status_t status = DC_STATUS_SUCCESS;
+
+		// Create a new parser, unless the previous one can be reused.
+		if (parser == NULL ||
+			parser->key.family != dc_descriptor_get_type (entry->descriptor) ||
+			parser->key.model != dc_descriptor_get_model (entry->descriptor) ||
+			parser->key.devtime != entry->devtime ||
+			parser->key.systime != entry->systime) {
+			dc_parser_destroy (parser);
+			parser = NULL;
+			status = dc_parser_new2 (&parser, context, entry->descriptor, entry->devtime, entry->systime);
+			if (status != DC_STATUS_SUCCESS) {
+				ERROR (context, "Failed to create the parser.");
+				parser = NULL;
+			}
+		}
+
+		if (status == DC_STATUS_SUCCESS) {
+			status = dc_parser_set_data (parser, entry->data, entry->size);
+		}
+
+		callback (parser, status, i, userdata);
+	}
+
+	dc_parser_destroy (parser);
+}
+
+/*
+ * Parse a chunk of entries on a worker thread. Every entry gets its own
+ * parser, which is stored at the index of the entry until the calling
+ * thread has passed it to the callback.
+ */
+static void
+dc_parser_batch_run (void *userdata)
+{
+	dc_parser_batch_t *batch = (dc_parser_batch_t *) userdata;
+
+	for (unsigned int i = batch->begin; i < batch->end; ++i) {
+		const dc_parser_batch_entry_t *entry = batch->entries + i;
+		dc_parser_batch_result_t *result = batch->results + i;
+
+		result->parser = NULL;
+		result->status = dc_parser_new2 (&result->parser, batch->context, entry->descriptor, entry->devtime, entry->systime);
+		if (result->status != DC_STATUS_SUCCESS) {
+			ERROR (batch->context, "Failed to create the parser.");
+			result->parser = NULL;
+			continue;
+		}
+
+		result->status = dc_parser_set_data (result->parser, entry->data, entry->size);
+	}
+}
+
+/*
+ * Queue the chunks containing the entries from begin to end, and return
+ * the end of the last queued chunk.
+ */
+static unsigned int
+dc_parser_batch_submit (dc_workqueue_t *workqueue, dc_parser_batch_t chunks[], unsigned int chunksize, unsigned int begin, unsigned int end, unsigned int count)
+{
+	if (end > count)
+		end = count;
+
+	while (begin < end) {
+		dc_parser_batch_t *chunk = chunks + begin / chunksize;
+
+		// Parse the chunk on the calling thread if it can't be queued.
+		if (dc_workqueue_submit (workqueue, dc_parser_batch_run, chunk) != DC_STATUS_SUCCESS) {
+			dc_parser_batch_run (chunk);
+		}
+
+		begin = chunk->end;
+	}
+
+	return begin;
+}
+
+dc_status_t
+dc_parser_batch (dc_context_t *context, const dc_parser_batch_entry_t entries[], unsigned int count, unsigned int nthreads, dc_parser_batch_callback_t callback, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_workqueue_t *workqueue = NULL;
+	dc_parser_batch_t *chunks = NULL;
+	dc_parser_batch_result_t *results = NULL;
+
+	if ((entries == NULL && count) || nthreads == 0 || callback == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (count == 0)
+		return DC_STATUS_SUCCESS;
+
+	// Start the worker threads.
+	if (nthreads > 1) {
+		status = dc_workqueue_new (&workqueue, context, nthreads);
+		if (status != DC_STATUS_SUCCESS && status != DC_STATUS_UNSUPPORTED) {
+			ERROR (context, "Failed to create the work queue.");
+			return status;
+		}
+	}
+
+	// Without worker threads, everything is parsed on the calling thread.
+	if (workqueue == NULL) {
+		dc_parser_batch_serial (context, entries, count, callback, userdata);
+		return DC_STATUS_SUCCESS;
+	}
+
+	// Split the entries into chunks. There are several chunks per
+	// thread to balance the load.
+	unsigned int chunksize = count / (nthreads * 8);
+	if (chunksize < 1)
+		chunksize = 1;
+	else if (chunksize > BATCH_MAXCHUNK)
+		chunksize = BATCH_MAXCHUNK;
+	unsigned int nchunks = (count + chunksize - 1) / chunksize;
+
+	// Allocate memory.
+	chunks = (dc_parser_batch_t *) dc_context_allocate (context, nchunks * sizeof (dc_parser_batch_t));
+	results = (dc_parser_batch_result_t *) dc_context_allocate (context, count * sizeof (dc_parser_batch_result_t));
+	if (chunks == NULL || results == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	for (unsigned int i = 0; i < nchunks; ++i) {
+		dc_parser_batch_t *chunk = chunks + i;
+		chunk->context = context;
+		chunk->entries = entries;
+		chunk->results = results;
+		chunk->begin = i * chunksize;
+		chunk->end = chunk->begin + chunksize;
+		if (chunk->end > count)
+			chunk->end = count;
+	}
+
+	// The entries are parsed one window ahead of the callback. While the
+	// calling thread passes the parsed window to the callback, in input
+	// order, the worker threads already parse the next window. This also
+	// limits the number of parsers that are alive at the same time.
+	unsigned int window = chunksize * nthreads * BATCH_WINDOW;
+	unsigned int parsed = 0;
+	unsigned int submitted = dc_parser_batch_submit (workqueue, chunks, chunksize, 0, window, count);
+	while (parsed < count) {
+		dc_workqueue_wait (workqueue);
+
+		unsigned int end = submitted;
+		submitted = dc_parser_batch_submit (workqueue, chunks, chunksize, submitted, submitted + window, count);
+
+		for (unsigned int i = parsed; i < end; ++i) {
+			callback (results[i].parser, results[i].status, i, userdata);
+			dc_parser_destroy (results[i].parser);
+		}
+
+		parsed = end;
+	}
+
+error_free:
+	// Wait for the worker threads.
+	dc_workqueue_free (workqueue);
+
+	dc_context_deallocate (context, results);
+	dc_context_deallocate (context, chunks);
+
+	return status;
+}
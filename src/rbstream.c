@@ -30,11 +30,13 @@ struct dc_rbstream_t {
 	dc_device_t *device;
 	unsigned int pagesize;
 	unsigned int packetsize;
+	unsigned int npackets;
 	unsigned int begin;
 	unsigned int end;
 	unsigned int address;
 	unsigned int available;
 	unsigned int skip;
+	unsigned int remaining;
 	unsigned char cache[];
 };
 
@@ -54,6 +56,12 @@ iceil (unsigned int x, unsigned int n)
 
 dc_status_t
 dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize, unsigned int packetsize, unsigned int begin, unsigned int end, unsigned int address)
+{
+	return dc_rbstream_new2 (out, device, pagesize, packetsize, 1, begin, end, address, 0);
+}
+
+dc_status_t
+dc_rbstream_new2 (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize, unsigned int packetsize, unsigned int npackets, unsigned int begin, unsigned int end, unsigned int address, unsigned int size)
 {
 	dc_rbstream_t *rbstream = NULL;
 
@@ -61,7 +69,7 @@ dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize
 		return DC_STATUS_INVALIDARGS;
 
 	// Page and packet size should be non-zero.
-	if (pagesize == 0 || packetsize == 0) {
+	if (pagesize == 0 || packetsize == 0 || npackets == 0) {
 		ERROR (device->context, "Zero length page or packet size!");
 		return DC_STATUS_INVALIDARGS;
 	}
@@ -85,7 +93,7 @@ dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize
 	}
 
 	// Allocate memory.
-	rbstream = (dc_rbstream_t *) malloc (sizeof(*rbstream) + packetsize);
+	rbstream = (dc_rbstream_t *) dc_context_allocate (device->context, sizeof(*rbstream) + packetsize * npackets);
 	if (rbstream == NULL) {
 		ERROR (device->context, "Failed to allocate memory.");
 		return DC_STATUS_NOMEMORY;
@@ -94,11 +102,13 @@ dc_rbstream_new (dc_rbstream_t **out, dc_device_t *device, unsigned int pagesize
 	rbstream->device = device;
 	rbstream->pagesize = pagesize;
 	rbstream->packetsize = packetsize;
+	rbstream->npackets = npackets;
 	rbstream->begin = begin;
 	rbstream->end = end;
 	rbstream->address = iceil(address, pagesize);
 	rbstream->available = 0;
 	rbstream->skip = rbstream->address - address;
+	rbstream->remaining = size;
 
 	*out = rbstream;
 
@@ -125,16 +135,23 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 			if (address == rbstream->begin)
 				address = rbstream->end;
 
-			// Calculate the packet size.
-			unsigned int len = rbstream->packetsize;
+			// Calculate the size of the next group of packets. The
+			// packets are read with a single request, up to the
+			// begin of the ringbuffer, and not beyond the data that
+			// remains to be read (if known).
+			unsigned int len = rbstream->packetsize * rbstream->npackets;
+			unsigned int remaining = rbstream->remaining > nbytes ? rbstream->remaining - nbytes : 0;
+			if (remaining && len > iceil (remaining + skip, rbstream->packetsize))
+				len = iceil (remaining + skip, rbstream->packetsize);
 			if (rbstream->begin + len > address)
 				len = address - rbstream->begin;
 
-			// Move to the begin of the current packet.
+			// Move to the begin of the first packet.
 			address -= len;
 
-			// Read the packet into the cache.
-			rc = dc_device_read (rbstream->device, address, rbstream->cache, rbstream->packetsize);
+			// Read the packets into the cache. The last packet is
+			// always read completely.
+			rc = dc_device_read (rbstream->device, address, rbstream->cache, iceil (len, rbstream->packetsize));
 			if (rc != DC_STATUS_SUCCESS)
 				return rc;
 
@@ -163,6 +180,7 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 	rbstream->address = address;
 	rbstream->available = available;
 	rbstream->skip = skip;
+	rbstream->remaining = rbstream->remaining > nbytes ? rbstream->remaining - nbytes : 0;
 
 	return rc;
 }
@@ -170,7 +188,10 @@ dc_rbstream_read (dc_rbstream_t *rbstream, dc_event_progress_t *progress, unsign
 dc_status_t
 dc_rbstream_free (dc_rbstream_t *rbstream)
 {
-	free (rbstream);
+	if (rbstream == NULL)
+		return DC_STATUS_SUCCESS;
+
+	dc_context_deallocate (rbstream->device->context, rbstream);
 
 	return DC_STATUS_SUCCESS;
 }
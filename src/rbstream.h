@@ -49,6 +49,31 @@ typedef struct dc_rbstream_t dc_rbstream_t;
 dc_status_t
 dc_rbstream_new (dc_rbstream_t **rbstream, dc_device_t *device, unsigned int pagesize, unsigned int packetsize, unsigned int begin, unsigned int end, unsigned int address);
 
+/**
+ * Create a new ringbuffer stream, which reads a group of packets at
+ * once, with a single #dc_device_read call. The requests are not
+ * pipelined. This only saves round trips for backends whose read
+ * function can transfer the whole range with a single command, such
+ * as the Cochran. When the total amount of data to read is known in
+ * advance, the group is limited to that amount (rounded up to a whole
+ * packet).
+ *
+ * @param[out]  rbstream    A location to store the ringbuffer stream.
+ * @param[in]   device      A valid device object.
+ * @param[in]   pagesize    The page size in bytes.
+ * @param[in]   packetsize  The packet size in bytes.
+ * @param[in]   npackets    The maximum number of packets per read.
+ * @param[in]   begin       The ringbuffer begin address.
+ * @param[in]   end         The ringbuffer end address.
+ * @param[in]   address     The stream start address.
+ * @param[in]   size        The total number of bytes that will be read,
+ *                          or zero if unknown.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_rbstream_new2 (dc_rbstream_t **rbstream, dc_device_t *device, unsigned int pagesize, unsigned int packetsize, unsigned int npackets, unsigned int begin, unsigned int end, unsigned int address, unsigned int size);
+
 /**
  * Read data from the ringbuffer stream.
  *
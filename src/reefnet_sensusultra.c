@@ -65,6 +65,7 @@ static const dc_device_vtable_t reefnet_sensusultra_device_vtable = {
 	NULL, /* write */
 	reefnet_sensusultra_device_dump, /* dump */
 	reefnet_sensusultra_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	reefnet_sensusultra_device_close /* close */
 };
@@ -100,6 +101,8 @@ reefnet_sensusultra_device_open (dc_device_t **out, dc_context_t *context, const
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -255,6 +258,7 @@ reefnet_sensusultra_packet (reefnet_sensusultra_device_t *device, unsigned char
 	unsigned short ccrc = checksum_crc_ccitt_uint16 (data + header, size - header - 2);
 	if (crc != ccrc) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -325,6 +329,8 @@ reefnet_sensusultra_page (reefnet_sensusultra_device_t *device, unsigned char *d
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		device_stats_increment (abstract, DEVICE_STATS_RETRY);
+
 		// Reject the packet.
 		rc = reefnet_sensusultra_send_uchar (device, REJECT);
 		if (rc != DC_STATUS_SUCCESS)
@@ -361,6 +367,8 @@ reefnet_sensusultra_send (reefnet_sensusultra_device_t *device, unsigned short c
 		if (nretries++ >= MAXRETRIES)
 			return rc;
 
+		device_stats_increment ((dc_device_t *) device, DEVICE_STATS_RETRY);
+
 		// According to the developers guide, a 250 ms delay is suggested to
 		// guarantee that the prompt byte sent after the handshake packet is
 		// not accidentally buffered by the host and (mis)interpreted as part
@@ -673,7 +681,7 @@ reefnet_sensusultra_device_foreach (dc_device_t *abstract, dc_dive_callback_t ca
 {
 	reefnet_sensusultra_device_t *device = (reefnet_sensusultra_device_t*) abstract;
 
-	dc_buffer_t *buffer = dc_buffer_new (SZ_MEMORY);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, SZ_MEMORY);
 	if (buffer == NULL) {
 		ERROR (abstract->context, "Failed to allocate memory.");
 		return DC_STATUS_NOMEMORY;
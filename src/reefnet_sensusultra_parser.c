@@ -59,6 +59,8 @@ static const dc_parser_vtable_t reefnet_sensusultra_parser_vtable = {
 	reefnet_sensusultra_parser_get_datetime, /* datetime */
 	reefnet_sensusultra_parser_get_field, /* fields */
 	reefnet_sensusultra_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -118,6 +120,12 @@ reefnet_sensusultra_parser_set_calibration (dc_parser_t *abstract, double atmosp
 	parser->atmospheric = atmospheric;
 	parser->hydrostatic = hydrostatic;
 
+	// Discard the cached field values.
+	dc_parser_invalidate (abstract);
+
+	// A calibrated parser no longer matches its pool key.
+	abstract->reusable = 0;
+
 	return DC_STATUS_SUCCESS;
 }
 
@@ -31,7 +31,8 @@
 #include <termios.h>	// tcgetattr, tcsetattr, cfsetispeed, cfsetospeed, tcflush, tcsendbreak
 #include <sys/ioctl.h>	// ioctl
 #include <sys/time.h>	// gettimeofday
-#include <time.h>	// nanosleep
+#include <time.h>	// nanosleep, clock_gettime
+#include <poll.h>	// poll
 #ifdef HAVE_LINUX_SERIAL_H
 #include <linux/serial.h>
 #endif
@@ -58,6 +59,7 @@
 #include "common-private.h"
 #include "context-private.h"
 #include "iostream-private.h"
+#include "trace.h"
 
 static dc_status_t dc_serial_set_timeout (dc_iostream_t *iostream, int timeout);
 static dc_status_t dc_serial_set_latency (dc_iostream_t *iostream, unsigned int value);
@@ -67,6 +69,7 @@ static dc_status_t dc_serial_set_dtr (dc_iostream_t *iostream, unsigned int valu
 static dc_status_t dc_serial_set_rts (dc_iostream_t *iostream, unsigned int value);
 static dc_status_t dc_serial_get_lines (dc_iostream_t *iostream, unsigned int *value);
 static dc_status_t dc_serial_get_available (dc_iostream_t *iostream, size_t *value);
+static dc_status_t dc_serial_get_handle (dc_iostream_t *iostream, int *value);
 static dc_status_t dc_serial_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
 static dc_status_t dc_serial_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
 static dc_status_t dc_serial_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
@@ -104,6 +107,7 @@ static const dc_iostream_vtable_t dc_serial_vtable = {
 	dc_serial_set_rts, /* set_rts */
 	dc_serial_get_lines, /* get_lines */
 	dc_serial_get_available, /* get_received */
+	dc_serial_get_handle, /* get_handle */
 	dc_serial_configure, /* configure */
 	dc_serial_read, /* read */
 	dc_serial_write, /* write */
@@ -186,6 +190,10 @@ dc_serial_open (dc_iostream_t **out, dc_context_t *context, const char *name)
 
 	INFO (context, "Open: name=%s", name);
 
+	// Replay a recorded trace instead of opening the device.
+	if (dc_context_get_trace (context, NULL, NULL) == DC_TRACE_REPLAY)
+		return dc_trace_replay_open (out, context);
+
 	// Allocate memory.
 	device = (dc_serial_t *) dc_iostream_allocate (context, &dc_serial_vtable);
 	if (device == NULL) {
@@ -234,7 +242,8 @@ dc_serial_open (dc_iostream_t **out, dc_context_t *context, const char *name)
 
 	*out = (dc_iostream_t *) device;
 
-	return DC_STATUS_SUCCESS;
+	// Record the traffic, if enabled.
+	return dc_trace_record_open (out, context);
 
 error_close:
 	close (device->fd);
@@ -586,6 +595,30 @@ dc_serial_set_latency (dc_iostream_t *abstract, unsigned int milliseconds)
 	return DC_STATUS_SUCCESS;
 }
 
+/*
+ * Get the current time in microseconds. The monotonic clock is used when
+ * available, because it is not affected by changes of the system time.
+ */
+static int
+dc_serial_clock (unsigned long long *value)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	if (clock_gettime (CLOCK_MONOTONIC, &ts) != 0)
+		return -1;
+
+	*value = ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+	struct timeval tv;
+	if (gettimeofday (&tv, NULL) != 0)
+		return -1;
+
+	*value = tv.tv_sec * 1000000ULL + tv.tv_usec;
+#endif
+
+	return 0;
+}
+
 static dc_status_t
 dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
 {
@@ -596,44 +629,65 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 	// The total timeout.
 	int timeout = device->timeout;
 
-	// The absolute target time.
-	struct timeval tve;
+	// The absolute target time (microseconds).
+	unsigned long long deadline = 0;
+	if (timeout > 0) {
+		unsigned long long now = 0;
+		if (dc_serial_clock (&now) != 0) {
+			int errcode = errno;
+			SYSERROR (abstract->context, errcode);
+			status = syserror (errcode);
+			goto out;
+		}
+
+		deadline = now + timeout * 1000ULL;
+	}
 
-	int init = 1;
 	while (nbytes < size) {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (device->fd, &fds);
+		// Read the data that is already available, before waiting. The
+		// file descriptor is in non-blocking mode, so this never blocks.
+		ssize_t n = read (device->fd, (char *) data + nbytes, size - nbytes);
+		if (n > 0) {
+			nbytes += n;
+			continue;
+		} else if (n == 0) {
+			break; // EOF.
+		} else {
+			int errcode = errno;
+			if (errcode == EINTR)
+				continue; // Retry.
+			if (errcode != EAGAIN && errcode != EWOULDBLOCK) {
+				SYSERROR (abstract->context, errcode);
+				status = syserror (errcode);
+				goto out;
+			}
+		}
 
-		struct timeval tvt;
+		// Calculate the remaining timeout.
+		int remaining = timeout;
 		if (timeout > 0) {
-			struct timeval now;
-			if (gettimeofday (&now, NULL) != 0) {
+			unsigned long long now = 0;
+			if (dc_serial_clock (&now) != 0) {
 				int errcode = errno;
 				SYSERROR (abstract->context, errcode);
 				status = syserror (errcode);
 				goto out;
 			}
 
-			if (init) {
-				// Calculate the initial timeout.
-				tvt.tv_sec  = (timeout / 1000);
-				tvt.tv_usec = (timeout % 1000) * 1000;
-				// Calculate the target time.
-				timeradd (&now, &tvt, &tve);
-			} else {
-				// Calculate the remaining timeout.
-				if (timercmp (&now, &tve, <))
-					timersub (&tve, &now, &tvt);
-				else
-					timerclear (&tvt);
-			}
-			init = 0;
-		} else if (timeout == 0) {
-			timerclear (&tvt);
+			if (now >= deadline)
+				break; // Timeout.
+
+			// Round up, to never wake up before the deadline.
+			remaining = (deadline - now + 999) / 1000;
 		}
 
-		int rc = select (device->fd + 1, &fds, NULL, NULL, timeout >= 0 ? &tvt : NULL);
+		// Wait for more data.
+		struct pollfd pfd;
+		pfd.fd = device->fd;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+
+		int rc = poll (&pfd, 1, remaining);
 		if (rc < 0) {
 			int errcode = errno;
 			if (errcode == EINTR)
@@ -644,20 +698,6 @@ dc_serial_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual
 		} else if (rc == 0) {
 			break; // Timeout.
 		}
-
-		ssize_t n = read (device->fd, (char *) data + nbytes, size - nbytes);
-		if (n < 0) {
-			int errcode = errno;
-			if (errcode == EINTR || errcode == EAGAIN)
-				continue; // Retry.
-			SYSERROR (abstract->context, errcode);
-			status = syserror (errcode);
-			goto out;
-		} else if (n == 0) {
-			 break; // EOF.
-		}
-
-		nbytes += n;
 	}
 
 	if (nbytes != size) {
@@ -678,10 +718,10 @@ dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 	dc_serial_t *device = (dc_serial_t *) abstract;
 	size_t nbytes = 0;
 
-	struct timeval tve, tvb;
+	unsigned long long begin = 0;
 	if (device->halfduplex) {
 		// Get the current time.
-		if (gettimeofday (&tvb, NULL) != 0) {
+		if (dc_serial_clock (&begin) != 0) {
 			int errcode = errno;
 			SYSERROR (abstract->context, errcode);
 			status = syserror (errcode);
@@ -690,35 +730,40 @@ dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 	}
 
 	while (nbytes < size) {
-		fd_set fds;
-		FD_ZERO (&fds);
-		FD_SET (device->fd, &fds);
-
-		int rc = select (device->fd + 1, NULL, &fds, NULL, NULL);
-		if (rc < 0) {
+		ssize_t n = write (device->fd, (const char *) data + nbytes, size - nbytes);
+		if (n > 0) {
+			nbytes += n;
+			continue;
+		} else if (n == 0) {
+			break; // EOF.
+		} else {
 			int errcode = errno;
 			if (errcode == EINTR)
 				continue; // Retry.
-			SYSERROR (abstract->context, errcode);
-			status = syserror (errcode);
-			goto out;
-		} else if (rc == 0) {
-			break; // Timeout.
+			if (errcode != EAGAIN && errcode != EWOULDBLOCK) {
+				SYSERROR (abstract->context, errcode);
+				status = syserror (errcode);
+				goto out;
+			}
 		}
 
-		ssize_t n = write (device->fd, (const char *) data + nbytes, size - nbytes);
-		if (n < 0) {
+		// Wait until more data can be written.
+		struct pollfd pfd;
+		pfd.fd = device->fd;
+		pfd.events = POLLOUT;
+		pfd.revents = 0;
+
+		int rc = poll (&pfd, 1, -1);
+		if (rc < 0) {
 			int errcode = errno;
-			if (errcode == EINTR || errcode == EAGAIN)
+			if (errcode == EINTR)
 				continue; // Retry.
 			SYSERROR (abstract->context, errcode);
 			status = syserror (errcode);
 			goto out;
-		} else if (n == 0) {
-			 break; // EOF.
+		} else if (rc == 0) {
+			break; // Timeout.
 		}
-
-		nbytes += n;
 	}
 
 	// Wait until all data has been transmitted.
@@ -738,7 +783,8 @@ dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 
 	if (device->halfduplex) {
 		// Get the current time.
-		if (gettimeofday (&tve, NULL) != 0) {
+		unsigned long long end = 0;
+		if (dc_serial_clock (&end) != 0) {
 			int errcode = errno;
 			SYSERROR (abstract->context, errcode);
 			status = syserror (errcode);
@@ -746,9 +792,7 @@ dc_serial_write (dc_iostream_t *abstract, const void *data, size_t size, size_t
 		}
 
 		// Calculate the elapsed time (microseconds).
-		struct timeval tvt;
-		timersub (&tve, &tvb, &tvt);
-		unsigned long elapsed = tvt.tv_sec * 1000000 + tvt.tv_usec;
+		unsigned long elapsed = end - begin;
 
 		// Calculate the expected duration (microseconds). A 2 millisecond fudge
 		// factor is added because it improves the success rate significantly.
@@ -876,6 +920,17 @@ dc_serial_get_available (dc_iostream_t *abstract, size_t *value)
 	return DC_STATUS_SUCCESS;
 }
 
+static dc_status_t
+dc_serial_get_handle (dc_iostream_t *abstract, int *value)
+{
+	dc_serial_t *device = (dc_serial_t *) abstract;
+
+	if (value)
+		*value = device->fd;
+
+	return DC_STATUS_SUCCESS;
+}
+
 static dc_status_t
 dc_serial_get_lines (dc_iostream_t *abstract, unsigned int *value)
 {
@@ -29,6 +29,7 @@
 #include "common-private.h"
 #include "context-private.h"
 #include "iostream-private.h"
+#include "trace.h"
 
 static dc_status_t dc_serial_set_timeout (dc_iostream_t *iostream, int timeout);
 static dc_status_t dc_serial_set_latency (dc_iostream_t *iostream, unsigned int value);
@@ -75,6 +76,7 @@ static const dc_iostream_vtable_t dc_serial_vtable = {
 	dc_serial_set_rts, /* set_rts */
 	dc_serial_get_lines, /* get_lines */
 	dc_serial_get_available, /* get_received */
+	NULL, /* get_handle */
 	dc_serial_configure, /* configure */
 	dc_serial_read, /* read */
 	dc_serial_write, /* write */
@@ -166,6 +168,10 @@ dc_serial_open (dc_iostream_t **out, dc_context_t *context, const char *name)
 
 	INFO (context, "Open: name=%s", name);
 
+	// Replay a recorded trace instead of opening the device.
+	if (dc_context_get_trace (context, NULL, NULL) == DC_TRACE_REPLAY)
+		return dc_trace_replay_open (out, context);
+
 	// Build the device name.
 	const char *devname = NULL;
 	char buffer[MAX_PATH] = "\\\\.\\";
@@ -219,7 +225,8 @@ dc_serial_open (dc_iostream_t **out, dc_context_t *context, const char *name)
 
 	*out = (dc_iostream_t *) device;
 
-	return DC_STATUS_SUCCESS;
+	// Record the traffic, if enabled.
+	return dc_trace_record_open (out, context);
 
 error_close:
 	CloseHandle (device->hFile);
@@ -0,0 +1,460 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+
+#ifndef _WIN32
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include <libdivecomputer/session.h>
+
+#include "workqueue.h"
+#include "context-private.h"
+#include "device-private.h"
+
+// Maximum time to wait before checking the cancellation flag again.
+#define CANCEL_INTERVAL 100
+
+typedef struct dc_session_t dc_session_t;
+
+struct dc_session_manager_t {
+	dc_context_t *context;
+	dc_workqueue_t *workqueue;
+	int cancelled;
+	// The resumable downloads, driven by dc_session_manager_wait.
+	dc_session_t *sessions;
+};
+
+struct dc_session_t {
+	dc_session_manager_t *manager;
+	dc_device_t *device;
+	dc_dive_callback_t callback;
+	dc_session_callback_t complete;
+	void *userdata;
+	// Resumable download.
+	dc_device_download_t *download;
+	int started;
+	int finished;
+	dc_status_t status;
+	unsigned long long deadline;
+	dc_session_t *next;
+};
+
+static int
+dc_session_cancelled (dc_session_manager_t *manager)
+{
+	// The flag is shared with the worker threads, and is therefore only
+	// accessed with the context lock held.
+	dc_context_lock (manager->context);
+	int cancelled = manager->cancelled;
+	dc_context_unlock (manager->context);
+
+	return cancelled;
+}
+
+static void
+dc_session_set_cancelled (dc_session_manager_t *manager, int value)
+{
+	dc_context_lock (manager->context);
+	manager->cancelled = value;
+	dc_context_unlock (manager->context);
+}
+
+static int
+dc_session_cancel (void *userdata)
+{
+	dc_session_manager_t *manager = (dc_session_manager_t *) userdata;
+
+	return dc_session_cancelled (manager);
+}
+
+static void
+dc_session_finish (dc_session_t *session, dc_status_t status)
+{
+	dc_session_manager_t *manager = session->manager;
+
+	if (status != DC_STATUS_SUCCESS && status != DC_STATUS_CANCELLED) {
+		ERROR (manager->context, "Failed to download the dives.");
+	}
+
+	if (session->complete) {
+		session->complete (session->device, status, session->userdata);
+	}
+
+	dc_device_download_free (session->download);
+	dc_context_deallocate (manager->context, session);
+}
+
+static void
+dc_session_run (void *userdata)
+{
+	dc_session_t *session = (dc_session_t *) userdata;
+	dc_session_manager_t *manager = session->manager;
+	dc_status_t status = DC_STATUS_CANCELLED;
+
+	if (!dc_session_cancelled (manager)) {
+		dc_device_set_cancel (session->device, dc_session_cancel, manager);
+		status = dc_device_foreach (session->device, session->callback, session->userdata);
+	}
+
+	dc_session_finish (session, status);
+}
+
+#ifndef _WIN32
+/*
+ * Get the value of a monotonic clock in microseconds.
+ */
+static unsigned long long
+dc_session_now (void)
+{
+#if defined(HAVE_CLOCK_GETTIME) && defined(CLOCK_MONOTONIC)
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec * 1000000ULL + tv.tv_usec;
+#endif
+}
+
+/*
+ * Run the download until it waits for a read or a delay. Once the
+ * download has finished, its result is stored in the session.
+ */
+static void
+dc_session_resume (dc_session_t *session)
+{
+	dc_device_download_t *download = session->download;
+
+	while (1) {
+		dc_status_t status = dc_device_download_step (download);
+		if (status != DC_STATUS_SUCCESS) {
+			session->finished = 1;
+			session->status = status == DC_STATUS_DONE ? DC_STATUS_SUCCESS : status;
+			return;
+		}
+
+		if (download->reading) {
+			session->deadline = dc_session_now () + download->timeout * 1000ULL;
+			return;
+		}
+
+		if (download->delay) {
+			session->deadline = dc_session_now () + download->delay * 1000ULL;
+			download->delay = 0;
+			return;
+		}
+	}
+}
+
+/*
+ * Abort all running downloads, after a fatal error in the event loop.
+ */
+static void
+dc_session_abort (dc_session_manager_t *manager)
+{
+	dc_session_set_cancelled (manager, 1);
+
+	for (dc_session_t *session = manager->sessions; session; session = session->next) {
+		if (!session->started || session->finished)
+			continue;
+
+		if (session->download->reading)
+			dc_iostream_cancel (session->download->iostream);
+
+		dc_session_resume (session);
+	}
+}
+
+/*
+ * The event loop. All resumable downloads are driven from the calling
+ * thread, by waiting for the handles of their I/O streams with poll.
+ */
+static void
+dc_session_reactor (dc_session_manager_t *manager)
+{
+	struct pollfd *fds = NULL;
+	unsigned int capacity = 0;
+
+	while (manager->sessions) {
+		int cancelled = dc_session_cancelled (manager);
+
+		// Start the new downloads.
+		for (dc_session_t *session = manager->sessions; session; session = session->next) {
+			if (session->started)
+				continue;
+
+			session->started = 1;
+			if (cancelled) {
+				session->finished = 1;
+				session->status = DC_STATUS_CANCELLED;
+				continue;
+			}
+
+			dc_device_set_cancel (session->device, dc_session_cancel, manager);
+			dc_session_resume (session);
+		}
+
+		// Remove the finished downloads. The completion callback is
+		// allowed to add new downloads.
+		dc_session_t **link = &manager->sessions;
+		while (*link) {
+			dc_session_t *session = *link;
+			if (session->finished) {
+				*link = session->next;
+				dc_session_finish (session, session->status);
+			} else {
+				link = &session->next;
+			}
+		}
+
+		unsigned int count = 0;
+		for (dc_session_t *session = manager->sessions; session; session = session->next) {
+			count++;
+		}
+
+		if (count > capacity) {
+			struct pollfd *tmp = (struct pollfd *) dc_context_reallocate (manager->context, fds, count * sizeof (struct pollfd));
+			if (tmp == NULL) {
+				ERROR (manager->context, "Failed to allocate memory.");
+				dc_session_abort (manager);
+				continue;
+			}
+			fds = tmp;
+			capacity = count;
+		}
+
+		// Wait for incoming data, the first deadline, or the next check
+		// of the cancellation flag.
+		unsigned long long now = dc_session_now ();
+		unsigned long long timeout = CANCEL_INTERVAL;
+		unsigned int n = 0;
+		for (dc_session_t *session = manager->sessions; session; session = session->next, n++) {
+			fds[n].fd = -1;
+			fds[n].events = POLLIN;
+			fds[n].revents = 0;
+
+			if (!session->started || session->deadline <= now) {
+				timeout = 0;
+				continue;
+			}
+
+			if (session->download->reading)
+				dc_iostream_get_handle (session->download->iostream, &fds[n].fd);
+
+			if (timeout > (session->deadline - now + 999) / 1000)
+				timeout = (session->deadline - now + 999) / 1000;
+		}
+
+		if (n && poll (fds, n, (int) timeout) < 0) {
+			int errcode = errno;
+			if (errcode != EINTR) {
+				SYSERROR (manager->context, errcode);
+				dc_session_abort (manager);
+				continue;
+			}
+		}
+
+		cancelled = dc_session_cancelled (manager);
+		now = dc_session_now ();
+
+		// Resume the downloads that can make progress.
+		n = 0;
+		for (dc_session_t *session = manager->sessions; session; session = session->next, n++) {
+			dc_device_download_t *download = session->download;
+			int ready = 0;
+
+			if (!session->started || session->finished)
+				continue;
+
+			if (download->reading) {
+				if (cancelled) {
+					dc_iostream_cancel (download->iostream);
+				} else {
+					if (fds[n].revents)
+						dc_iostream_process (download->iostream);
+					if (download->reading && now >= session->deadline)
+						dc_device_download_timeout (download);
+				}
+				ready = !download->reading;
+			} else {
+				ready = cancelled || now >= session->deadline;
+			}
+
+			if (ready)
+				dc_session_resume (session);
+		}
+	}
+
+	dc_context_deallocate (manager->context, fds);
+}
+#endif
+
+dc_status_t
+dc_session_manager_new (dc_session_manager_t **out, dc_context_t *context, unsigned int nworkers)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_session_manager_t *manager = NULL;
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	manager = (dc_session_manager_t *) dc_context_allocate (context, sizeof (dc_session_manager_t));
+	if (manager == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	manager->context = context;
+	manager->workqueue = NULL;
+	manager->cancelled = 0;
+	manager->sessions = NULL;
+
+	// Start the worker threads.
+	if (nworkers) {
+		status = dc_workqueue_new (&manager->workqueue, context, nworkers);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (context, "Failed to create the work queue.");
+			dc_context_deallocate (context, manager);
+			return status;
+		}
+	}
+
+	*out = manager;
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_session_manager_add (dc_session_manager_t *manager, dc_device_t *device, dc_dive_callback_t callback, dc_session_callback_t complete, void *userdata)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_session_t *session = NULL;
+
+	if (manager == NULL || device == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	session = (dc_session_t *) dc_context_allocate (manager->context, sizeof (dc_session_t));
+	if (session == NULL) {
+		ERROR (manager->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	session->manager = manager;
+	session->device = device;
+	session->callback = callback;
+	session->complete = complete;
+	session->userdata = userdata;
+	session->download = NULL;
+	session->started = 0;
+	session->finished = 0;
+	session->status = DC_STATUS_SUCCESS;
+	session->deadline = 0;
+	session->next = NULL;
+
+#ifndef _WIN32
+	// Prefer the event loop, if the backend supports it.
+	status = dc_device_download_new (&session->download, device, callback, userdata);
+	if (status == DC_STATUS_SUCCESS) {
+		dc_session_t **link = &manager->sessions;
+		while (*link) {
+			link = &(*link)->next;
+		}
+		*link = session;
+		return DC_STATUS_SUCCESS;
+	} else if (status != DC_STATUS_UNSUPPORTED) {
+		dc_context_deallocate (manager->context, session);
+		return status;
+	}
+#endif
+
+	if (manager->workqueue == NULL) {
+		ERROR (manager->context, "The device does not support resumable downloads.");
+		dc_context_deallocate (manager->context, session);
+		return DC_STATUS_UNSUPPORTED;
+	}
+
+	status = dc_workqueue_submit (manager->workqueue, dc_session_run, session);
+	if (status != DC_STATUS_SUCCESS) {
+		dc_context_deallocate (manager->context, session);
+		return status;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_session_manager_wait (dc_session_manager_t *manager)
+{
+	if (manager == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+#ifndef _WIN32
+	dc_session_reactor (manager);
+#endif
+
+	if (manager->workqueue) {
+		dc_workqueue_wait (manager->workqueue);
+	}
+
+	// All downloads have finished, so the manager can be reused.
+	dc_session_set_cancelled (manager, 0);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_session_manager_cancel (dc_session_manager_t *manager)
+{
+	if (manager == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_session_set_cancelled (manager, 1);
+
+	return DC_STATUS_SUCCESS;
+}
+
+dc_status_t
+dc_session_manager_free (dc_session_manager_t *manager)
+{
+	if (manager == NULL)
+		return DC_STATUS_SUCCESS;
+
+#ifndef _WIN32
+	dc_session_reactor (manager);
+#endif
+
+	dc_workqueue_free (manager->workqueue);
+	dc_context_deallocate (manager->context, manager);
+
+	return DC_STATUS_SUCCESS;
+}
@@ -19,7 +19,7 @@
  * MA 02110-1301 USA
  */
 
-#include <string.h> // memcmp, memcpy
+#include <string.h> // memcmp, memcpy, memset
 #include <stdlib.h> // malloc, free
 
 #include "shearwater_common.h"
@@ -47,6 +47,8 @@ shearwater_common_open (shearwater_common_device_t *device, dc_context_t *contex
 		return status;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (115200 8N1).
 	status = dc_iostream_configure (device->iostream, 115200, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -81,60 +83,105 @@ shearwater_common_close (shearwater_common_device_t *device)
 }
 
 
+/*
+ * Emit a run of zero bytes. Because the XOR phase is fused into the
+ * decompression, each byte is XOR'ed with the byte 32 positions earlier
+ * in the decompressed stream, except for the first block, which is
+ * passed through unchanged. For a zero byte, that is simply a copy of
+ * the earlier byte.
+ */
+static void
+shearwater_common_decompress_zeros (unsigned char *stream, unsigned int offset, unsigned int count)
+{
+	if (offset < 32) {
+		unsigned int n = 32 - offset;
+		if (n > count)
+			n = count;
+		memset (stream + offset, 0, n);
+		offset += n;
+		count -= n;
+	}
+
+	while (count) {
+		unsigned int n = count > 32 ? 32 : count;
+		memcpy (stream + offset, stream + offset - 32, n);
+		offset += n;
+		count -= n;
+	}
+}
+
+
 static int
-shearwater_common_decompress_lre (unsigned char *data, unsigned int size, dc_buffer_t *buffer, unsigned int *isfinal)
+shearwater_common_decompress (const unsigned char *data, unsigned int size, dc_buffer_t *buffer, unsigned int *isfinal)
 {
 	// The RLE decompression algorithm does interpret the binary data as a
 	// stream of 9 bit values. Therefore, the total number of bits needs to be
-	// a multiple of 9 bits.
-	unsigned int nbits = size * 8;
-	if (nbits % 9 != 0)
+	// a multiple of 9 bits, and every group of 9 bytes contains exactly 8
+	// values.
+	if (size % 9 != 0)
 		return -1;
 
-	unsigned int offset = 0;
-	while (offset + 9 <= nbits) {
-		// Extract the 9 bit value.
-		unsigned int byte = offset / 8;
-		unsigned int bit  = offset % 8;
-		unsigned int shift = 16 - (bit + 9);
-		unsigned int value = (array_uint16_be (data + byte) >> shift) & 0x1FF;
-
-		// The 9th bit indicates whether the remaining 8 bits represent
-		// a run of zero bytes or not. If the bit is set, the value is
-		// not a run and doesn’t need expansion. If the bit is not set,
-		// the value contains the number of zero bytes in the run. A
-		// zero-length run indicates the end of the compressed stream.
-		if (value & 0x100) {
-			// Append the data byte directly.
-			unsigned char c = value & 0xFF;
-			if (!dc_buffer_append (buffer, &c, 1))
-				return -1;
-		} else if (value == 0) {
-			// Reached the end of the compressed stream.
-			if (isfinal)
-				*isfinal = 1;
-			break;
-		} else {
-			// Expand the run with zero bytes.
-			if (!dc_buffer_resize (buffer, dc_buffer_get_size (buffer) + value))
+	// Write the output directly into the buffer. The buffer contains the
+	// entire decompressed stream, which is needed for the XOR phase. A
+	// group expands to at most 8 runs of 255 zero bytes. Space for that
+	// worst case is reserved in advance, and the reserved space is
+	// doubled every time it runs out.
+	unsigned int length = dc_buffer_get_size (buffer);
+	unsigned char *stream = dc_buffer_get_data (buffer);
+	unsigned int reserved = length;
+	unsigned int n = length;
+
+	for (unsigned int offset = 0; offset < size; offset += 9) {
+		if (reserved - n < 8 * 255) {
+			unsigned int extra = reserved - length;
+			if (extra < 8 * 255)
+				extra = 8 * 255;
+			if (dc_buffer_append_uninit (buffer, extra) == NULL)
 				return -1;
+			stream = dc_buffer_get_data (buffer);
+			reserved += extra;
 		}
 
-		offset += 9;
+		// Load the 72 bits of the group into a 64 bit word and the
+		// remaining byte.
+		unsigned long long word =
+			((unsigned long long) array_uint32_be (data + offset) << 32) |
+			array_uint32_be (data + offset + 4);
+		unsigned int last = data[offset + 8];
+
+		for (unsigned int i = 0; i < 8; ++i) {
+			unsigned int value = 0;
+			if (i < 7)
+				value = (word >> (55 - 9 * i)) & 0x1FF;
+			else
+				value = ((word & 0x01) << 8) | last;
+
+			// The 9th bit indicates whether the remaining 8 bits represent
+			// a run of zero bytes or not. If the bit is set, the value is
+			// not a run and doesn’t need expansion. If the bit is not set,
+			// the value contains the number of zero bytes in the run. A
+			// zero-length run indicates the end of the compressed stream.
+			if (value & 0x100) {
+				// Append the data byte directly.
+				unsigned char c = value & 0xFF;
+				stream[n] = n < 32 ? c : c ^ stream[n - 32];
+				n++;
+			} else if (value == 0) {
+				// Reached the end of the compressed stream.
+				if (isfinal)
+					*isfinal = 1;
+				goto done;
+			} else {
+				// Expand the run with zero bytes.
+				shearwater_common_decompress_zeros (stream, n, value);
+				n += value;
+			}
+		}
 	}
 
-	return 0;
-}
-
-
-static int
-shearwater_common_decompress_xor (unsigned char *data, unsigned int size)
-{
-	// Each block of 32 bytes is XOR'ed (in-place) with the previous block,
-	// except for the first block, which is passed through unchanged.
-	for (unsigned int i = 32; i < size; ++i) {
-		data[i] ^= data[i - 32];
-	}
+done:
+	// Drop the unused part of the reserved space.
+	dc_buffer_resize (buffer, n);
 
 	return 0;
 }
@@ -364,7 +411,7 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 	unsigned char response[SZ_PACKET];
 
 	// Erase the current contents of the buffer.
-	if (!dc_buffer_clear (buffer)) {
+	if (!dc_buffer_clear (buffer) || !dc_buffer_reserve (buffer, size)) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
 		return DC_STATUS_NOMEMORY;
 	}
@@ -427,8 +474,8 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		}
 
 		if (compression) {
-			if (shearwater_common_decompress_lre (response + 2, length, buffer, &done) != 0) {
-				ERROR (abstract->context, "Decompression error (LRE phase).");
+			if (shearwater_common_decompress (response + 2, length, buffer, &done) != 0) {
+				ERROR (abstract->context, "Decompression error.");
 				return DC_STATUS_PROTOCOL;
 			}
 		} else {
@@ -442,13 +489,6 @@ shearwater_common_download (shearwater_common_device_t *device, dc_buffer_t *buf
 		block++;
 	}
 
-	if (compression) {
-		if (shearwater_common_decompress_xor (dc_buffer_get_data (buffer), dc_buffer_get_size (buffer)) != 0) {
-			ERROR (abstract->context, "Decompression error (XOR phase).");
-			return DC_STATUS_PROTOCOL;
-		}
-	}
-
 	// Transfer the quit request.
 	rc = shearwater_common_transfer (device, req_quit, sizeof (req_quit), response, 2, &n);
 	if (rc != DC_STATUS_SUCCESS) {
@@ -56,6 +56,7 @@ static const dc_device_vtable_t shearwater_petrel_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	shearwater_petrel_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	shearwater_petrel_device_close /* close */
 };
@@ -159,8 +160,8 @@ shearwater_petrel_device_foreach (dc_device_t *abstract, dc_dive_callback_t call
 	dc_status_t rc = DC_STATUS_SUCCESS;
 
 	// Allocate memory buffers for the manifests.
-	dc_buffer_t *buffer = dc_buffer_new (MANIFEST_SIZE);
-	dc_buffer_t *manifests = dc_buffer_new (MANIFEST_SIZE);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, MANIFEST_SIZE);
+	dc_buffer_t *manifests = dc_buffer_new2 (abstract->context, MANIFEST_SIZE);
 	if (buffer == NULL || manifests == NULL) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
 		dc_buffer_free (buffer);
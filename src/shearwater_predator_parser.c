@@ -74,6 +74,7 @@ static dc_status_t shearwater_predator_parser_set_data (dc_parser_t *abstract, c
 static dc_status_t shearwater_predator_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t shearwater_predator_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t shearwater_predator_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns);
 
 static const dc_parser_vtable_t shearwater_predator_parser_vtable = {
 	sizeof(shearwater_predator_parser_t),
@@ -82,6 +83,8 @@ static const dc_parser_vtable_t shearwater_predator_parser_vtable = {
 	shearwater_predator_parser_get_datetime, /* datetime */
 	shearwater_predator_parser_get_field, /* fields */
 	shearwater_predator_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	shearwater_predator_parser_samples_columns, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -92,6 +95,8 @@ static const dc_parser_vtable_t shearwater_petrel_parser_vtable = {
 	shearwater_predator_parser_get_datetime, /* datetime */
 	shearwater_predator_parser_get_field, /* fields */
 	shearwater_predator_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	shearwater_predator_parser_samples_columns, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -567,3 +572,108 @@ shearwater_predator_parser_samples_foreach (dc_parser_t *abstract, dc_sample_cal
 
 	return DC_STATUS_SUCCESS;
 }
+
+
+static dc_status_t
+shearwater_predator_parser_samples_columns (dc_parser_t *abstract, dc_sample_columns_t *columns)
+{
+	shearwater_predator_parser_t *parser = (shearwater_predator_parser_t *) abstract;
+
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	// Only the columns that are present in every sample are supported.
+	// The others depend on the status flags and the log version.
+	if (columns->fields || columns->pressure || columns->ppo2 || columns->cns)
+		return DC_STATUS_UNSUPPORTED;
+
+	// Cache the parser data.
+	dc_status_t rc = shearwater_predator_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Get the unit system.
+	unsigned int units = data[8];
+
+	// Previous gas mix.
+	unsigned int o2_previous = 0, he_previous = 0;
+
+	unsigned int count = 0;
+	unsigned int offset = parser->headersize;
+	unsigned int length = size - parser->footersize;
+	while (offset < length) {
+		// Ignore empty samples.
+		if (array_isequal (data + offset, parser->samplesize, 0x00)) {
+			offset += parser->samplesize;
+			continue;
+		}
+
+		// Gaschange.
+		unsigned int o2 = data[offset + 7];
+		unsigned int he = data[offset + 8];
+		if (o2 != o2_previous || he != he_previous) {
+			unsigned int idx = shearwater_predator_find_gasmix (parser, o2, he);
+			if (idx >= parser->ngasmixes) {
+				ERROR (abstract->context, "Invalid gas mix.");
+				return DC_STATUS_DATAFORMAT;
+			}
+
+			o2_previous = o2;
+			he_previous = he;
+		}
+
+		if (count < columns->capacity) {
+			// Time (seconds).
+			if (columns->time)
+				columns->time[count] = (count + 1) * 10;
+
+			// Depth (1/10 m or ft).
+			if (columns->depth) {
+				unsigned int depth = array_uint16_be (data + offset);
+				if (units == IMPERIAL)
+					columns->depth[count] = depth * FEET / 10.0;
+				else
+					columns->depth[count] = depth / 10.0;
+			}
+
+			// Temperature (°C or °F).
+			if (columns->temperature) {
+				int temperature = (signed char) data[offset + 13];
+				if (temperature < 0) {
+					// Fix negative temperatures.
+					temperature += 102;
+					if (temperature > 0) {
+						temperature = 0;
+					}
+				}
+				if (units == IMPERIAL)
+					columns->temperature[count] = (temperature - 32.0) * (5.0 / 9.0);
+				else
+					columns->temperature[count] = temperature;
+			}
+
+			// Deco stop / NDL.
+			unsigned int decostop = array_uint16_be (data + offset + 2);
+			if (columns->deco_type)
+				columns->deco_type[count] = decostop ? DC_DECO_DECOSTOP : DC_DECO_NDL;
+			if (columns->deco_time)
+				columns->deco_time[count] = data[offset + 9] * 60;
+			if (columns->deco_depth) {
+				if (decostop == 0)
+					columns->deco_depth[count] = 0.0;
+				else if (units == IMPERIAL)
+					columns->deco_depth[count] = decostop * FEET;
+				else
+					columns->deco_depth[count] = decostop;
+			}
+		}
+
+		count++;
+
+		offset += parser->samplesize;
+	}
+
+	columns->count = count;
+
+	return DC_STATUS_SUCCESS;
+}
@@ -225,6 +225,21 @@ dc_socket_get_available (dc_iostream_t *abstract, size_t *value)
 	return DC_STATUS_SUCCESS;
 }
 
+dc_status_t
+dc_socket_get_handle (dc_iostream_t *abstract, int *value)
+{
+#ifdef _WIN32
+	return DC_STATUS_UNSUPPORTED;
+#else
+	dc_socket_t *socket = (dc_socket_t *) abstract;
+
+	if (value)
+		*value = socket->fd;
+
+	return DC_STATUS_SUCCESS;
+#endif
+}
+
 dc_status_t
 dc_socket_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
 {
@@ -125,6 +125,9 @@ dc_socket_get_lines (dc_iostream_t *iostream, unsigned int *value);
 dc_status_t
 dc_socket_get_available (dc_iostream_t *iostream, size_t *value);
 
+dc_status_t
+dc_socket_get_handle (dc_iostream_t *iostream, int *value);
+
 dc_status_t
 dc_socket_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
 
@@ -27,6 +27,7 @@
 #include "suunto_common2.h"
 #include "ringbuffer.h"
 #include "rbstream.h"
+#include "pagecache.h"
 #include "checksum.h"
 #include "array.h"
 
@@ -35,6 +36,7 @@
 #define SZ_VERSION    0x04
 #define SZ_PACKET     0x78
 #define SZ_MINIMUM    8
+#define SZ_PAGE       8
 
 #define RB_PROFILE_DISTANCE(l,a,b,m)  ringbuffer_distance (a, b, m, l->rb_profile_begin, l->rb_profile_end)
 
@@ -52,6 +54,40 @@ suunto_common2_device_init (suunto_common2_device_t *device)
 }
 
 
+dc_status_t
+suunto_common2_device_verify (dc_device_t *abstract, const unsigned char command[], const unsigned char answer[], unsigned int asize, unsigned int size)
+{
+	// Verify the header of the package.
+	if (answer[0] != command[0]) {
+		ERROR (abstract->context, "Unexpected answer header.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	// Verify the size of the package.
+	if (array_uint16_be (answer + 1) + 4 != asize) {
+		ERROR (abstract->context, "Unexpected answer size.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	// Verify the parameters of the package.
+	if (memcmp (command + 3, answer + 3, asize - size - 4) != 0) {
+		ERROR (abstract->context, "Unexpected answer parameters.");
+		return DC_STATUS_PROTOCOL;
+	}
+
+	// Verify the checksum of the package.
+	unsigned char crc = answer[asize - 1];
+	unsigned char ccrc = checksum_xor_uint8 (answer, asize - 1, 0x00);
+	if (crc != ccrc) {
+		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
+		return DC_STATUS_PROTOCOL;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+
 static dc_status_t
 suunto_common2_transfer (dc_device_t *abstract, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size)
 {
@@ -76,6 +112,8 @@ suunto_common2_transfer (dc_device_t *abstract, const unsigned char command[], u
 		// Abort if the maximum number of retries is reached.
 		if (nretries++ >= MAXRETRIES)
 			return rc;
+
+		device_stats_increment (abstract, DEVICE_STATS_RETRY);
 	}
 
 	return rc;
@@ -201,13 +239,16 @@ dc_status_t
 suunto_common2_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 {
 	suunto_common2_device_t *device = (suunto_common2_device_t *) abstract;
+	dc_pagecache_t *pagecache = NULL;
 
 	assert (device != NULL);
 	assert (device->layout != NULL);
 
+	const suunto_common2_layout_t *layout = device->layout;
+
 	// Erase the current contents of the buffer and
 	// allocate the required amount of memory.
-	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, device->layout->memsize)) {
+	if (!dc_buffer_clear (buffer) || !dc_buffer_resize (buffer, layout->memsize)) {
 		ERROR (abstract->context, "Insufficient buffer space available.");
 		return DC_STATUS_NOMEMORY;
 	}
@@ -218,8 +259,50 @@ suunto_common2_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 	vendor.size = sizeof (device->version);
 	device_event_emit (abstract, DC_EVENT_VENDOR, &vendor);
 
-	return device_dump_read (abstract, dc_buffer_get_data (buffer),
-		dc_buffer_get_size (buffer), SZ_PACKET);
+	unsigned char *data = dc_buffer_get_data (buffer);
+
+	// Read the memory in front of the profile ringbuffer, which contains
+	// the serial number and the ringbuffer pointers.
+	dc_status_t rc = suunto_common2_device_read (abstract, 0, data, layout->rb_profile_begin);
+	if (rc != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to read the memory header.");
+		return rc;
+	}
+
+	rc = dc_pagecache_new (&pagecache, abstract, array_uint32_be (data + layout->serial), layout->memsize, SZ_PAGE);
+	if (rc != DC_STATUS_SUCCESS) {
+		return rc;
+	}
+
+	// New dives are appended to the profile ringbuffer, starting at the
+	// previous end of profile pointer. Only that part of the ringbuffer,
+	// and the memory outside the ringbuffer, can be different from the
+	// cached data. Data from a different device is never re-used.
+	unsigned char serial[4] = {0};
+	unsigned char previous[2] = {0};
+	rc = dc_pagecache_get (pagecache, layout->serial, serial, sizeof (serial));
+	if (rc == DC_STATUS_SUCCESS)
+		rc = dc_pagecache_get (pagecache, 0x0190 + 4, previous, sizeof (previous));
+	unsigned int begin = array_uint16_le (previous);
+	unsigned int end = array_uint16_le (data + 0x0190 + 4);
+	if (rc == DC_STATUS_SUCCESS && memcmp (serial, data + layout->serial, sizeof (serial)) == 0 &&
+		begin >= layout->rb_profile_begin && begin < layout->rb_profile_end &&
+		end >= layout->rb_profile_begin && end < layout->rb_profile_end) {
+		unsigned int length = RB_PROFILE_DISTANCE (layout, begin, end, 0);
+		dc_pagecache_invalidate_ringbuffer (pagecache, layout->rb_profile_begin, layout->rb_profile_end, begin, length + SZ_PACKET);
+		dc_pagecache_invalidate (pagecache, 0, layout->rb_profile_begin);
+		dc_pagecache_invalidate (pagecache, layout->rb_profile_end, layout->memsize - layout->rb_profile_end);
+	} else {
+		dc_pagecache_invalidate (pagecache, 0, layout->memsize);
+	}
+
+	dc_pagecache_put (pagecache, 0, data, layout->rb_profile_begin);
+
+	rc = dc_pagecache_dump (pagecache, data, layout->memsize, SZ_PACKET);
+
+	dc_pagecache_free (pagecache);
+
+	return rc;
 }
 
 
@@ -395,3 +478,447 @@ suunto_common2_device_foreach (dc_device_t *abstract, dc_dive_callback_t callbac
 
 	return status;
 }
+
+
+/*
+ * The resumable download. It performs the same transfers as the foreach
+ * function, but each packet is a small state machine on top of the
+ * asynchronous reads of the I/O stream.
+ */
+
+typedef enum suunto_common2_phase_t {
+	PHASE_DELAY,
+	PHASE_SEND,
+	PHASE_ECHO,
+	PHASE_ANSWER,
+} suunto_common2_phase_t;
+
+typedef enum suunto_common2_state_t {
+	STATE_INIT,
+	STATE_SERIAL,
+	STATE_HEADER,
+	STATE_DIVE,
+	STATE_PROFILE,
+	STATE_PACKET,
+} suunto_common2_state_t;
+
+typedef struct suunto_common2_download_t {
+	dc_device_download_t base;
+	const suunto_common2_transport_t *transport;
+	// The packet in progress.
+	unsigned int pending;
+	suunto_common2_phase_t phase;
+	unsigned int nretries;
+	unsigned char command[7];
+	unsigned char echo[7];
+	unsigned char answer[SZ_PACKET + 7];
+	unsigned int asize;
+	unsigned int size;
+	// The download.
+	suunto_common2_state_t state;
+	dc_status_t status;
+	dc_event_progress_t progress;
+	unsigned int current;
+	unsigned int previous;
+	unsigned int offset;
+	unsigned int length;
+	unsigned int nbytes;
+	unsigned char *data;
+	// The ringbuffer stream, with a cache of one packet.
+	unsigned int address;
+	unsigned int available;
+	unsigned char cache[SZ_PACKET];
+} suunto_common2_download_t;
+
+static void
+suunto_common2_download_request (suunto_common2_download_t *download, unsigned int address, unsigned int len)
+{
+	download->command[0] = 0x05;
+	download->command[1] = 0x00;
+	download->command[2] = 0x03;
+	download->command[3] = (address >> 8) & 0xFF; // high
+	download->command[4] = (address     ) & 0xFF; // low
+	download->command[5] = len; // count
+	download->command[6] = checksum_xor_uint8 (download->command, 6, 0x00);
+	download->asize = len + 7;
+	download->size = len;
+
+	download->pending = 1;
+	download->phase = PHASE_DELAY;
+	download->nretries = 0;
+}
+
+static dc_status_t
+suunto_common2_download_receive (suunto_common2_download_t *download)
+{
+	dc_device_t *abstract = download->base.device;
+
+	// Switch RTS to receive the reply.
+	dc_status_t status = dc_iostream_set_rts (download->base.iostream, !download->transport->rts);
+	if (status != DC_STATUS_SUCCESS) {
+		ERROR (abstract->context, "Failed to set the RTS line.");
+		return status;
+	}
+
+	download->phase = PHASE_ANSWER;
+
+	return device_download_read (&download->base, download->answer, download->asize);
+}
+
+static dc_status_t
+suunto_common2_download_packet (suunto_common2_download_t *download)
+{
+	dc_device_t *abstract = download->base.device;
+	dc_iostream_t *iostream = download->base.iostream;
+	const suunto_common2_transport_t *transport = download->transport;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	switch (download->phase) {
+	case PHASE_DELAY:
+		download->phase = PHASE_SEND;
+		if (transport->delay) {
+			device_download_sleep (&download->base, transport->delay);
+			return DC_STATUS_SUCCESS;
+		}
+		// Fall through.
+	case PHASE_SEND:
+		if (device_is_cancelled (abstract))
+			return DC_STATUS_CANCELLED;
+
+		// Switch RTS to send the command.
+		status = dc_iostream_set_rts (iostream, transport->rts);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to set the RTS line.");
+			return status;
+		}
+
+		// Send the command to the dive computer.
+		status = dc_iostream_write (iostream, download->command, sizeof (download->command), NULL);
+		if (status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to send the command.");
+			return status;
+		}
+
+		if (!transport->echo)
+			return suunto_common2_download_receive (download);
+
+		download->phase = PHASE_ECHO;
+		return device_download_read (&download->base, download->echo, sizeof (download->echo));
+	case PHASE_ECHO:
+		if (download->base.status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to receive the echo.");
+			return download->base.status;
+		}
+
+		// Verify the echo.
+		if (memcmp (download->command, download->echo, sizeof (download->command)) != 0) {
+			ERROR (abstract->context, "Unexpected echo.");
+			return DC_STATUS_PROTOCOL;
+		}
+
+		return suunto_common2_download_receive (download);
+	case PHASE_ANSWER:
+		if (download->base.status != DC_STATUS_SUCCESS) {
+			ERROR (abstract->context, "Failed to receive the answer.");
+			return download->base.status;
+		}
+
+		status = suunto_common2_device_verify (abstract, download->command, download->answer, download->asize, download->size);
+		if (status != DC_STATUS_SUCCESS)
+			return status;
+
+		return DC_STATUS_DONE;
+	}
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+suunto_common2_download_transfer (suunto_common2_download_t *download)
+{
+	dc_device_t *abstract = download->base.device;
+
+	dc_status_t rc = DC_STATUS_SUCCESS;
+	while ((rc = suunto_common2_download_packet (download)) != DC_STATUS_SUCCESS) {
+		if (rc == DC_STATUS_DONE) {
+			download->pending = 0;
+			break;
+		}
+
+		// Automatically discard a corrupted packet,
+		// and request a new one.
+		if (rc != DC_STATUS_TIMEOUT && rc != DC_STATUS_PROTOCOL)
+			return rc;
+
+		// Abort if the maximum number of retries is reached.
+		if (download->nretries++ >= MAXRETRIES)
+			return rc;
+
+		device_stats_increment (abstract, DEVICE_STATS_RETRY);
+
+		download->phase = PHASE_DELAY;
+	}
+
+	return rc;
+}
+
+static dc_status_t
+suunto_common2_download_dive (suunto_common2_download_t *download)
+{
+	suunto_common2_device_t *device = (suunto_common2_device_t *) download->base.device;
+	dc_device_t *abstract = download->base.device;
+	const suunto_common2_layout_t *layout = device->layout;
+
+	unsigned char *p = download->data + download->offset;
+	unsigned int size = download->length;
+	unsigned int current = download->current;
+	unsigned int previous = download->previous;
+
+	unsigned int prev = array_uint16_le (p + 0);
+	unsigned int next = array_uint16_le (p + 2);
+	if (prev < layout->rb_profile_begin ||
+		prev >= layout->rb_profile_end ||
+		next < layout->rb_profile_begin ||
+		next >= layout->rb_profile_end)
+	{
+		ERROR (abstract->context, "Invalid ringbuffer pointer detected (0x%04x 0x%04x).", prev, next);
+		return DC_STATUS_DATAFORMAT;
+	}
+	if (next != previous && next != current) {
+		ERROR (abstract->context, "Profiles are not continuous (0x%04x 0x%04x 0x%04x).", current, next, previous);
+		return DC_STATUS_DATAFORMAT;
+	}
+
+	if (next != current) {
+		unsigned int fp_offset = layout->fingerprint + 4;
+		if (memcmp (p + fp_offset, device->fingerprint, sizeof (device->fingerprint)) == 0)
+			return DC_STATUS_DONE;
+
+		if (download->base.callback && !download->base.callback (p + 4, size - 4, p + fp_offset, sizeof (device->fingerprint), download->base.userdata))
+			return DC_STATUS_DONE;
+	} else {
+		ERROR (abstract->context, "Skipping incomplete dive (0x%04x 0x%04x 0x%04x).", current, next, previous);
+		download->status = DC_STATUS_DATAFORMAT;
+	}
+
+	// Next dive.
+	download->previous = current;
+	download->current = prev;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+suunto_common2_download_step (dc_device_download_t *abstract)
+{
+	suunto_common2_download_t *download = (suunto_common2_download_t *) abstract;
+	suunto_common2_device_t *device = (suunto_common2_device_t *) abstract->device;
+	const suunto_common2_layout_t *layout = device->layout;
+	dc_context_t *context = abstract->device->context;
+	dc_status_t rc = DC_STATUS_SUCCESS;
+
+	while (1) {
+		// Continue the packet in progress.
+		if (download->pending) {
+			rc = suunto_common2_download_transfer (download);
+			if (rc != DC_STATUS_DONE) {
+				if (rc != DC_STATUS_SUCCESS) {
+					if (download->state == STATE_PACKET)
+						ERROR (context, "Failed to read the dive.");
+					else
+						ERROR (context, "Failed to read the memory header.");
+				}
+				return rc;
+			}
+		}
+
+		const unsigned char *packet = download->answer + 6;
+
+		switch (download->state) {
+		case STATE_INIT:
+			// Enable progress notifications.
+			download->progress.maximum = layout->rb_profile_end - layout->rb_profile_begin +
+				8 + (SZ_MINIMUM > 4 ? SZ_MINIMUM : 4);
+			device_event_emit (abstract->device, DC_EVENT_PROGRESS, &download->progress);
+
+			// Emit a vendor event.
+			dc_event_vendor_t vendor;
+			vendor.data = device->version;
+			vendor.size = sizeof (device->version);
+			device_event_emit (abstract->device, DC_EVENT_VENDOR, &vendor);
+
+			// Read the serial number.
+			suunto_common2_download_request (download, layout->serial, SZ_MINIMUM > 4 ? SZ_MINIMUM : 4);
+			download->state = STATE_SERIAL;
+			break;
+		case STATE_SERIAL:
+			// Update and emit a progress event.
+			download->progress.current += download->size;
+			device_event_emit (abstract->device, DC_EVENT_PROGRESS, &download->progress);
+
+			// Emit a device info event.
+			dc_event_devinfo_t devinfo;
+			devinfo.model = device->version[0];
+			devinfo.firmware = array_uint24_be (device->version + 1);
+			devinfo.serial = 0;
+			for (unsigned int i = 0; i < 4; ++i) {
+				devinfo.serial *= 100;
+				devinfo.serial += packet[i];
+			}
+			device_event_emit (abstract->device, DC_EVENT_DEVINFO, &devinfo);
+
+			// Read the header bytes.
+			suunto_common2_download_request (download, 0x0190, 8);
+			download->state = STATE_HEADER;
+			break;
+		case STATE_HEADER:
+			{
+			// Obtain the pointers from the header.
+			unsigned int last  = array_uint16_le (packet + 0);
+			unsigned int count = array_uint16_le (packet + 2);
+			unsigned int end   = array_uint16_le (packet + 4);
+			unsigned int begin = array_uint16_le (packet + 6);
+			if (last < layout->rb_profile_begin ||
+				last >= layout->rb_profile_end ||
+				end < layout->rb_profile_begin ||
+				end >= layout->rb_profile_end ||
+				begin < layout->rb_profile_begin ||
+				begin >= layout->rb_profile_end)
+			{
+				ERROR (context, "Invalid ringbuffer pointer detected (0x%04x 0x%04x 0x%04x %u).", begin, last, end, count);
+				return DC_STATUS_DATAFORMAT;
+			}
+
+			// Calculate the total amount of bytes.
+			unsigned int remaining = RB_PROFILE_DISTANCE (layout, begin, end, count != 0);
+
+			// Update and emit a progress event.
+			download->progress.maximum -= (layout->rb_profile_end - layout->rb_profile_begin) - remaining;
+			download->progress.current += download->size;
+			device_event_emit (abstract->device, DC_EVENT_PROGRESS, &download->progress);
+
+			// Memory buffer to store all the dives.
+			download->data = (unsigned char *) dc_context_allocate (context, layout->rb_profile_end - layout->rb_profile_begin);
+			if (download->data == NULL) {
+				ERROR (context, "Failed to allocate memory.");
+				return DC_STATUS_NOMEMORY;
+			}
+
+			// The ring buffer is traversed backwards to retrieve the most recent
+			// dives first. This allows us to download only the new dives.
+			download->current = last;
+			download->previous = end;
+			download->offset = remaining;
+			download->address = end;
+			download->available = 0;
+			download->state = STATE_DIVE;
+			}
+			break;
+		case STATE_DIVE:
+			if (download->offset == 0)
+				return download->status == DC_STATUS_SUCCESS ? DC_STATUS_DONE : download->status;
+
+			// Calculate the size of the current dive.
+			download->length = RB_PROFILE_DISTANCE (layout, download->current, download->previous, 1);
+			if (download->length < 4 || download->length > download->offset) {
+				ERROR (context, "Unexpected profile size (%u %u).", download->length, download->offset);
+				return DC_STATUS_DATAFORMAT;
+			}
+
+			// Move to the begin of the current dive.
+			download->offset -= download->length;
+			download->nbytes = 0;
+			download->state = STATE_PROFILE;
+			break;
+		case STATE_PACKET:
+			memcpy (download->cache, packet, download->size);
+			download->available = download->size;
+			download->state = STATE_PROFILE;
+			// Fall through.
+		case STATE_PROFILE:
+			while (download->nbytes < download->length) {
+				if (download->available == 0) {
+					// Handle the ringbuffer wrap point.
+					if (download->address == layout->rb_profile_begin)
+						download->address = layout->rb_profile_end;
+
+					// Read the next packet, up to the begin of the ringbuffer.
+					unsigned int len = SZ_PACKET;
+					if (layout->rb_profile_begin + len > download->address)
+						len = download->address - layout->rb_profile_begin;
+					download->address -= len;
+
+					suunto_common2_download_request (download, download->address, len);
+					download->state = STATE_PACKET;
+					break;
+				}
+
+				unsigned int length = download->available;
+				if (download->nbytes + length > download->length)
+					length = download->length - download->nbytes;
+
+				download->available -= length;
+				download->nbytes += length;
+
+				memcpy (download->data + download->offset + download->length - download->nbytes,
+					download->cache + download->available, length);
+
+				// Update and emit a progress event.
+				download->progress.current += length;
+				device_event_emit (abstract->device, DC_EVENT_PROGRESS, &download->progress);
+			}
+
+			if (download->pending)
+				break;
+
+			rc = suunto_common2_download_dive (download);
+			if (rc != DC_STATUS_SUCCESS)
+				return rc;
+
+			download->state = STATE_DIVE;
+			break;
+		}
+	}
+}
+
+static void
+suunto_common2_download_cleanup (dc_device_download_t *abstract)
+{
+	suunto_common2_download_t *download = (suunto_common2_download_t *) abstract;
+
+	dc_context_deallocate (abstract->device->context, download->data);
+}
+
+dc_status_t
+suunto_common2_device_download (dc_device_t *abstract, dc_iostream_t *iostream, const suunto_common2_transport_t *transport, dc_dive_callback_t callback, void *userdata, dc_device_download_t **out)
+{
+	suunto_common2_device_t *device = (suunto_common2_device_t *) abstract;
+
+	assert (device != NULL);
+	assert (device->layout != NULL);
+
+	suunto_common2_download_t *download = (suunto_common2_download_t *) device_download_allocate (abstract,
+		sizeof (suunto_common2_download_t), iostream, transport->timeout, callback, userdata);
+	if (download == NULL)
+		return DC_STATUS_NOMEMORY;
+
+	download->base.step = suunto_common2_download_step;
+	download->base.cleanup = suunto_common2_download_cleanup;
+	download->transport = transport;
+	download->pending = 0;
+	download->phase = PHASE_DELAY;
+	download->nretries = 0;
+	download->asize = 0;
+	download->size = 0;
+	download->state = STATE_INIT;
+	download->status = DC_STATUS_SUCCESS;
+	download->progress.current = 0;
+	download->progress.maximum = 0;
+	download->data = NULL;
+	download->address = 0;
+	download->available = 0;
+
+	*out = &download->base;
+
+	return DC_STATUS_SUCCESS;
+}
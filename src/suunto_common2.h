@@ -47,6 +47,20 @@ typedef struct suunto_common2_device_t {
 	unsigned char fingerprint[7];
 } suunto_common2_device_t;
 
+/*
+ * The settings of the packet function, for the resumable download.
+ */
+typedef struct suunto_common2_transport_t {
+	// Delay before sending a command (milliseconds).
+	unsigned int delay;
+	// Level of the RTS line while sending a command.
+	unsigned int rts;
+	// Whether the dive computer echoes the command.
+	unsigned int echo;
+	// Timeout for receiving the answer (milliseconds).
+	unsigned int timeout;
+} suunto_common2_transport_t;
+
 typedef struct suunto_common2_device_vtable_t {
 	dc_device_vtable_t base;
 	dc_status_t (*packet) (dc_device_t *device, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size);
@@ -55,6 +69,9 @@ typedef struct suunto_common2_device_vtable_t {
 void
 suunto_common2_device_init (suunto_common2_device_t *device);
 
+dc_status_t
+suunto_common2_device_verify (dc_device_t *device, const unsigned char command[], const unsigned char answer[], unsigned int asize, unsigned int size);
+
 dc_status_t
 suunto_common2_device_set_fingerprint (dc_device_t *device, const unsigned char data[], unsigned int size);
 
@@ -73,6 +90,9 @@ suunto_common2_device_dump (dc_device_t *device, dc_buffer_t *buffer);
 dc_status_t
 suunto_common2_device_foreach (dc_device_t *device, dc_dive_callback_t callback, void *userdata);
 
+dc_status_t
+suunto_common2_device_download (dc_device_t *device, dc_iostream_t *iostream, const suunto_common2_transport_t *transport, dc_dive_callback_t callback, void *userdata, dc_device_download_t **download);
+
 dc_status_t
 suunto_common2_device_reset_maxdepth (dc_device_t *device);
 
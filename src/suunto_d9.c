@@ -47,6 +47,7 @@ typedef struct suunto_d9_device_t {
 	dc_iostream_t *iostream;
 } suunto_d9_device_t;
 
+static dc_status_t suunto_d9_device_download (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata, dc_device_download_t **download);
 static dc_status_t suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size);
 static dc_status_t suunto_d9_device_close (dc_device_t *abstract);
 
@@ -59,12 +60,20 @@ static const suunto_common2_device_vtable_t suunto_d9_device_vtable = {
 		suunto_common2_device_write, /* write */
 		suunto_common2_device_dump, /* dump */
 		suunto_common2_device_foreach, /* foreach */
+		suunto_d9_device_download, /* download */
 		NULL, /* timesync */
 		suunto_d9_device_close /* close */
 	},
 	suunto_d9_device_packet
 };
 
+static const suunto_common2_transport_t suunto_d9_transport = {
+	0, /* delay */
+	0, /* rts */
+	1, /* echo */
+	3000 /* timeout */
+};
+
 static const suunto_common2_layout_t suunto_d9_layout = {
 	0x8000, /* memsize */
 	0x0011, /* fingerprint */
@@ -156,6 +165,8 @@ suunto_d9_device_open (dc_device_t **out, dc_context_t *context, const char *nam
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (9600 8N1).
 	status = dc_iostream_configure (device->iostream, 9600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -230,6 +241,16 @@ suunto_d9_device_close (dc_device_t *abstract)
 }
 
 
+static dc_status_t
+suunto_d9_device_download (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata, dc_device_download_t **download)
+{
+	suunto_d9_device_t *device = (suunto_d9_device_t *) abstract;
+
+	return suunto_common2_device_download (abstract, device->iostream, &suunto_d9_transport, callback, userdata, download);
+}
+
+
+
 static dc_status_t
 suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], unsigned int csize, unsigned char answer[], unsigned int asize, unsigned int size)
 {
@@ -282,33 +303,7 @@ suunto_d9_device_packet (dc_device_t *abstract, const unsigned char command[], u
 		return status;
 	}
 
-	// Verify the header of the package.
-	if (answer[0] != command[0]) {
-		ERROR (abstract->context, "Unexpected answer header.");
-		return DC_STATUS_PROTOCOL;
-	}
-
-	// Verify the size of the package.
-	if (array_uint16_be (answer + 1) + 4 != asize) {
-		ERROR (abstract->context, "Unexpected answer size.");
-		return DC_STATUS_PROTOCOL;
-	}
-
-	// Verify the parameters of the package.
-	if (memcmp (command + 3, answer + 3, asize - size - 4) != 0) {
-		ERROR (abstract->context, "Unexpected answer parameters.");
-		return DC_STATUS_PROTOCOL;
-	}
-
-	// Verify the checksum of the package.
-	unsigned char crc = answer[asize - 1];
-	unsigned char ccrc = checksum_xor_uint8 (answer, asize - 1, 0x00);
-	if (crc != ccrc) {
-		ERROR (abstract->context, "Unexpected answer checksum.");
-		return DC_STATUS_PROTOCOL;
-	}
-
-	return DC_STATUS_SUCCESS;
+	return suunto_common2_device_verify (abstract, command, answer, asize, size);
 }
 
 
@@ -101,6 +101,8 @@ static const dc_parser_vtable_t suunto_d9_parser_vtable = {
 	suunto_d9_parser_get_datetime, /* datetime */
 	suunto_d9_parser_get_field, /* fields */
 	suunto_d9_parser_samples_foreach, /* samples_foreach */
+	NULL, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -128,6 +130,9 @@ suunto_d9_parser_cache (suunto_d9_parser_t *parser)
 		return DC_STATUS_SUCCESS;
 	}
 
+	if (size < 5)
+		return DC_STATUS_DATAFORMAT;
+
 	// Get the logbook id tag.
 	unsigned int id = array_uint32_le (data + 1);
 
@@ -88,17 +88,18 @@ static const dc_device_vtable_t suunto_eonsteel_device_vtable = {
 	NULL, /* write */
 	NULL, /* dump */
 	suunto_eonsteel_device_foreach, /* foreach */
+	NULL, /* download */
 	suunto_eonsteel_device_timesync, /* timesync */
 	suunto_eonsteel_device_close /* close */
 };
 
 static const char dive_directory[] = "0:/dives";
 
-static struct directory_entry *alloc_dirent(int type, int len, const char *name)
+static struct directory_entry *alloc_dirent(dc_context_t *context, int type, int len, const char *name)
 {
 	struct directory_entry *res;
 
-	res = (struct directory_entry *) malloc(offsetof(struct directory_entry, name) + len + 1);
+	res = (struct directory_entry *) dc_context_allocate(context, offsetof(struct directory_entry, name) + len + 1);
 	if (res) {
 		res->next = NULL;
 		res->type = type;
@@ -376,6 +377,12 @@ static int read_file(suunto_eonsteel_device_t *eon, const char *filename, dc_buf
 	size = array_uint32_le(result+4);
 	offset = 0;
 
+	// Allocate the space for the entire file at once.
+	if (!dc_buffer_reserve(buf, dc_buffer_get_size(buf) + size)) {
+		ERROR(eon->base.context, "out of memory");
+		return -1;
+	}
+
 	while (size > 0) {
 		unsigned int ask, got, at;
 
@@ -452,7 +459,7 @@ static struct directory_entry *parse_dirent(suunto_eonsteel_device_t *eon, int n
 
 		p += 8 + namelen + 1;
 		len -= 8 + namelen + 1;
-		entry = alloc_dirent(type, namelen, (const char *) name);
+		entry = alloc_dirent(eon->base.context, type, namelen, (const char *) name);
 		if (!entry) {
 			ERROR(eon->base.context, "out of memory");
 			break;
@@ -587,6 +594,8 @@ suunto_eonsteel_device_open(dc_device_t **out, dc_context_t *context, unsigned i
 		goto error_free;
 	}
 
+	device_set_iostream((dc_device_t *) eon, eon->iostream);
+
 	if (initialize_eonsteel(eon) < 0) {
 		ERROR(context, "unable to initialize device");
 		status = DC_STATUS_IO;
@@ -600,7 +609,7 @@ suunto_eonsteel_device_open(dc_device_t **out, dc_context_t *context, unsigned i
 error_close:
 	dc_iostream_close(eon->iostream);
 error_free:
-	free(eon);
+	dc_device_deallocate((dc_device_t *) eon);
 	return status;
 }
 
@@ -727,7 +736,7 @@ suunto_eonsteel_device_foreach(dc_device_t *abstract, dc_dive_callback_t callbac
 		progress.current++;
 		device_event_emit(abstract, DC_EVENT_PROGRESS, &progress);
 
-		free(de);
+		dc_context_deallocate(abstract->context, de);
 		de = next;
 	}
 	dc_buffer_free(file);
@@ -67,14 +67,47 @@ struct type_desc {
 	const char *desc, *format, *mod;
 	unsigned int size;
 	enum eon_sample type[EON_MAX_GROUP];
+	// Enumeration strings and sample events, indexed by value.
+	const char **enums;
+	parser_sample_event_t *events;
+	unsigned int nenums;
+	// Raw descriptor text, to detect unchanged descriptors.
+	const char *text;
+	unsigned int textlen;
+	unsigned int generation;
+	// Single allocation for all the data above. Descriptors installed
+	// from a shared descriptor set don't own their data.
+	void *arena;
+	unsigned int arenasize;
+	unsigned int shared;
 };
 
 #define MAXTYPE 512
 #define MAXGASES 16
 
+/*
+ * A compiled descriptor set. All dives of the same dive computer (and
+ * firmware version) declare the same descriptors, so the compiled sets
+ * are shared by all the parsers of a context, and are immutable once
+ * they are shared.
+ */
+typedef struct eon_descset_t {
+	dc_context_t *context;
+	unsigned int hash;
+	unsigned int count;
+	unsigned short *type;
+	struct type_desc *desc;
+} eon_descset_t;
+
 typedef struct suunto_eonsteel_parser_t {
 	dc_parser_t base;
 	struct type_desc type_desc[MAXTYPE];
+	// The descriptors are kept across dives, and are only valid for
+	// the current dive if they have the current generation.
+	unsigned int generation;
+	// Shared descriptor set matching the current dive, if any. The
+	// parser holds a reference to it, as long as it is installed.
+	const eon_descset_t *descset;
 	// field cache
 	struct {
 		unsigned int initialized;
@@ -95,6 +128,7 @@ typedef struct suunto_eonsteel_parser_t {
 	} cache;
 } suunto_eonsteel_parser_t;
 
+typedef int (*eon_desc_cb_t)(suunto_eonsteel_parser_t *eon, unsigned short type, const char *name, int namelen, void *user);
 typedef int (*eon_data_cb_t)(unsigned short type, const struct type_desc *desc, const unsigned char *data, int len, void *user);
 
 typedef struct eon_event_t {
@@ -135,6 +169,63 @@ static const struct {
 	{ "Events.DiveTimer.Time",		ES_none },
 };
 
+static const eon_event_t eon_states[] = {
+	{"Wet Outside",                SAMPLE_EVENT_NONE},
+	{"Below Wet Activation Depth", SAMPLE_EVENT_NONE},
+	{"Below Surface",              SAMPLE_EVENT_NONE},
+	{"Dive Active",                SAMPLE_EVENT_NONE},
+	{"Surface Calculation",        SAMPLE_EVENT_NONE},
+	{"Tank pressure available",    SAMPLE_EVENT_NONE},
+	{"Closed Circuit Mode",        SAMPLE_EVENT_NONE},
+};
+
+static const eon_event_t eon_notifications[] = {
+	{"NoFly Time",         SAMPLE_EVENT_NONE},
+	{"Depth",              SAMPLE_EVENT_NONE},
+	{"Surface Time",       SAMPLE_EVENT_NONE},
+	{"Tissue Level",       SAMPLE_EVENT_TISSUELEVEL},
+	{"Deco",               SAMPLE_EVENT_NONE},
+	{"Deco Window",        SAMPLE_EVENT_NONE},
+	{"Safety Stop Ahead",  SAMPLE_EVENT_NONE},
+	{"Safety Stop",        SAMPLE_EVENT_SAFETYSTOP},
+	{"Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Deep Stop Ahead",    SAMPLE_EVENT_NONE},
+	{"Deep Stop",          SAMPLE_EVENT_DEEPSTOP},
+	{"Dive Time",          SAMPLE_EVENT_DIVETIME},
+	{"Gas Available",      SAMPLE_EVENT_NONE},
+	{"SetPoint Switch",    SAMPLE_EVENT_NONE},
+	{"Diluent Hypoxia",    SAMPLE_EVENT_NONE},
+	{"Air Time",           SAMPLE_EVENT_NONE},
+	{"Tank Pressure",      SAMPLE_EVENT_NONE},
+};
+
+static const eon_event_t eon_warnings[] = {
+	{"ICD Penalty",           SAMPLE_EVENT_NONE},
+	{"Deep Stop Penalty",     SAMPLE_EVENT_VIOLATION},
+	{"Mandatory Safety Stop", SAMPLE_EVENT_SAFETYSTOP_MANDATORY},
+	{"OTU250",                SAMPLE_EVENT_NONE},
+	{"OTU300",                SAMPLE_EVENT_NONE},
+	{"CNS80%",                SAMPLE_EVENT_NONE},
+	{"CNS100%",               SAMPLE_EVENT_NONE},
+	{"Max.Depth",             SAMPLE_EVENT_MAXDEPTH},
+	{"Air Time",              SAMPLE_EVENT_AIRTIME},
+	{"Tank Pressure",         SAMPLE_EVENT_NONE},
+	{"Safety Stop Broken",    SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Deep Stop Broken",      SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Ceiling Broken",        SAMPLE_EVENT_CEILING},
+	{"PO2 High",              SAMPLE_EVENT_PO2},
+};
+
+static const eon_event_t eon_alarms[] = {
+	{"Mandatory Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
+	{"Ascent Speed",                 SAMPLE_EVENT_ASCENT},
+	{"Diluent Hyperoxia",            SAMPLE_EVENT_NONE},
+	{"Violated Deep Stop",           SAMPLE_EVENT_VIOLATION},
+	{"Ceiling Broken",               SAMPLE_EVENT_CEILING},
+	{"PO2 High",                     SAMPLE_EVENT_PO2},
+	{"PO2 Low",                      SAMPLE_EVENT_PO2},
+};
+
 static enum eon_sample lookup_descriptor_type(suunto_eonsteel_parser_t *eon, struct type_desc *desc)
 {
 	int i;
@@ -227,7 +318,7 @@ static int fill_in_group_details(suunto_eonsteel_parser_t *eon, struct type_desc
 			break;
 		}
 		base = eon->type_desc + index;
-		if (!base->desc) {
+		if (!base->desc || base->generation != eon->generation) {
 			ERROR(eon->base.context, "Group type descriptor '%s' has undescribed index %ld", desc->desc, index);
 			break;
 		}
@@ -263,6 +354,93 @@ static int fill_in_group_details(suunto_eonsteel_parser_t *eon, struct type_desc
 	return -1;
 }
 
+/*
+ * Parse the next entry of an enumeration.
+ *
+ * Enumerations have the enum values in the "format" string,
+ * and all start with "enum:" followed by a comma-separated list
+ * of enumeration values and strings. Example:
+ *
+ * "enum:0=NoFly Time,1=Depth,2=Surface Time,3=..."
+ *
+ * Returns the position after the entry, or NULL at the end.
+ */
+static const char *enum_next(const char *str, const char *stop, unsigned int *value, const char **name, unsigned int *len)
+{
+	while (str < stop) {
+		unsigned char c = *str++;
+		unsigned int n;
+		const char *begin, *end;
+
+		if (!isdigit(c))
+			continue;
+		n = c - '0';
+
+		// We only handle one or two digits
+		if (str < stop && isdigit((unsigned char) *str)) {
+			n = n*10 + *str - '0';
+			str++;
+		}
+
+		begin = end = str;
+		while (str < stop) {
+			c = *str++;
+			if (c == ',')
+				break;
+			end = str;
+		}
+
+		// Verify that it has the 'n=string' format and skip the equals sign
+		if (begin == stop || *begin != '=')
+			continue;
+
+		*value = n;
+		*name = begin + 1;
+		*len = end - begin - 1;
+		return str;
+	}
+
+	return NULL;
+}
+
+/*
+ * The sample events only depend on the enumeration value, so
+ * they are resolved once for each event type descriptor.
+ */
+static void fill_in_enum_events(struct type_desc *desc)
+{
+	const eon_event_t *events = NULL;
+	size_t n = 0;
+
+	switch (desc->type[0]) {
+	case ES_state:
+		events = eon_states;
+		n = C_ARRAY_SIZE(eon_states);
+		break;
+	case ES_notify:
+		events = eon_notifications;
+		n = C_ARRAY_SIZE(eon_notifications);
+		break;
+	case ES_warning:
+		events = eon_warnings;
+		n = C_ARRAY_SIZE(eon_warnings);
+		break;
+	case ES_alarm:
+		events = eon_alarms;
+		n = C_ARRAY_SIZE(eon_alarms);
+		break;
+	default:
+		break;
+	}
+
+	for (unsigned int i = 0; i < desc->nenums; ++i) {
+		if (events && desc->enums[i])
+			desc->events[i] = lookup_event(desc->enums[i], events, n);
+		else
+			desc->events[i] = SAMPLE_EVENT_NONE;
+	}
+}
+
 /*
  * Here we cache descriptor data so that we don't have
  * to re-parse the string all the time. That way we can
@@ -283,28 +461,64 @@ static int fill_in_desc_details(suunto_eonsteel_parser_t *eon, struct type_desc
 
 	desc->size = lookup_descriptor_size(eon, desc);
 	desc->type[0] = lookup_descriptor_type(eon, desc);
+	fill_in_enum_events(desc);
 	return 0;
 }
 
 static void
-desc_free (struct type_desc desc[], unsigned int count)
+desc_free (dc_context_t *context, struct type_desc desc[], unsigned int count)
 {
 	for (unsigned int i = 0; i < count; ++i) {
-		free((void *)desc[i].desc);
-		free((void *)desc[i].format);
-		free((void *)desc[i].mod);
+		if (!desc[i].shared)
+			dc_context_deallocate(context, desc[i].arena);
 	}
 }
 
-static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const char *name, int namelen)
+static char *copy_line(char *dst, const char *line, unsigned int len, const char **out)
+{
+	if (!line)
+		return dst;
+
+	memcpy(dst, line, len);
+	dst[len] = 0;
+	*out = dst;
+	return dst + len + 1;
+}
+
+/*
+ * All the data of a descriptor is stored in a single allocation: the
+ * enumeration tables, the raw descriptor text and the individual
+ * lines (path or group, format and modifier) as strings.
+ */
+static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const char *name, int namelen, void *user)
 {
 	struct type_desc desc;
 	const char *next;
+	const char *text = name;
+	const char *line[3] = {NULL, NULL, NULL};
+	unsigned int linelen[3] = {0, 0, 0};
+
+	// The descriptors of a matching descriptor set, including the
+	// groups, are already installed.
+	if (eon->descset && type < MAXTYPE) {
+		eon->type_desc[type].generation = eon->generation;
+		return 0;
+	}
+
+	// Keep the existing descriptor if the text is unchanged. Group
+	// descriptors depend on their sub-entries, and are always parsed.
+	if (type < MAXTYPE && namelen > 0) {
+		struct type_desc *current = eon->type_desc + type;
+		if (current->text && current->textlen == (unsigned int) namelen &&
+			!(current->desc && isdigit(current->desc[0])) &&
+			memcmp(current->text, text, namelen) == 0) {
+			current->generation = eon->generation;
+			return 0;
+		}
+	}
 
-	memset(&desc, 0, sizeof(desc));
 	do {
 		int len;
-		char *p;
 
 		next = strchr(name, '\n');
 		if (next) {
@@ -320,53 +534,109 @@ static int record_type(suunto_eonsteel_parser_t *eon, unsigned short type, const
 			ERROR(eon->base.context, "Unexpected type description: %.*s", len, name);
 			return -1;
 		}
-		p = (char *) malloc(len-4);
-		if (!p) {
-			ERROR(eon->base.context, "out of memory");
-			desc_free(&desc, 1);
-			return -1;
-		}
-		memcpy(p, name+5, len-5);
-		p[len-5] = 0;
 
 		// PTH, GRP, FRM, MOD
 		switch (name[1]) {
 		case 'P':
 		case 'G':
-			desc.desc = p;
+			line[0] = name + 5;
+			linelen[0] = len - 5;
 			break;
 		case 'F':
-			desc.format = p;
+			line[1] = name + 5;
+			linelen[1] = len - 5;
 			break;
 		case 'M':
-			desc.mod = p;
+			line[2] = name + 5;
+			linelen[2] = len - 5;
 			break;
 		default:
 			ERROR(eon->base.context, "Unknown type descriptor: %.*s", len, name);
-			desc_free(&desc, 1);
-			free(p);
 			return -1;
 		}
 	} while ((name = next) != NULL);
 
 	if (type >= MAXTYPE) {
-		ERROR(eon->base.context, "Type out of range (%04x: '%s' '%s' '%s')",
+		ERROR(eon->base.context, "Type out of range (%04x: '%.*s' '%.*s' '%.*s')",
 			type,
-			desc.desc ? desc.desc : "",
-			desc.format ? desc.format : "",
-			desc.mod ? desc.mod : "");
-		desc_free(&desc, 1);
+			linelen[0], line[0] ? line[0] : "",
+			linelen[1], line[1] ? line[1] : "",
+			linelen[2], line[2] ? line[2] : "");
 		return -1;
 	}
 
+	// Measure the enumeration.
+	unsigned int nenums = 0, enumsize = 0;
+	const char *enumstr = NULL, *enumstop = NULL;
+	if (line[1] && linelen[1] >= 5 && !strncmp(line[1], "enum:", 5)) {
+		const char *str, *value_name;
+		unsigned int value, len;
+
+		enumstr = line[1] + 5;
+		enumstop = line[1] + linelen[1];
+		str = enumstr;
+		while ((str = enum_next(str, enumstop, &value, &value_name, &len)) != NULL) {
+			if (value >= nenums)
+				nenums = value + 1;
+			enumsize += len + 1;
+		}
+	}
+
+	unsigned int textlen = namelen > 0 ? namelen : 0;
+	size_t size = nenums * (sizeof(*desc.enums) + sizeof(*desc.events)) +
+		textlen + linelen[0] + linelen[1] + linelen[2] + 3 + enumsize;
+
+	memset(&desc, 0, sizeof(desc));
+	desc.arena = dc_context_allocate(eon->base.context, size);
+	desc.arenasize = size;
+	if (!desc.arena) {
+		ERROR(eon->base.context, "out of memory");
+		return -1;
+	}
+
+	// The pointer arrays go first, to keep them aligned.
+	char *p = (char *) desc.arena;
+	if (nenums) {
+		desc.enums = (const char **) p;
+		p += nenums * sizeof(*desc.enums);
+		desc.events = (parser_sample_event_t *) p;
+		p += nenums * sizeof(*desc.events);
+		desc.nenums = nenums;
+		for (unsigned int i = 0; i < nenums; ++i)
+			desc.enums[i] = NULL;
+	}
+
+	memcpy(p, text, textlen);
+	desc.text = p;
+	desc.textlen = textlen;
+	p += textlen;
+
+	p = copy_line(p, line[0], linelen[0], &desc.desc);
+	p = copy_line(p, line[1], linelen[1], &desc.format);
+	p = copy_line(p, line[2], linelen[2], &desc.mod);
+
+	if (nenums) {
+		const char *str = enumstr, *value_name;
+		unsigned int value, len;
+
+		while ((str = enum_next(str, enumstop, &value, &value_name, &len)) != NULL) {
+			// The first entry for a value wins.
+			if (desc.enums[value])
+				continue;
+			p = copy_line(p, value_name, len, &desc.enums[value]);
+		}
+	}
+
 	fill_in_desc_details(eon, &desc);
 
-	desc_free(eon->type_desc + type, 1);
+	desc.generation = eon->generation;
+
+	desc_free(eon->base.context, eon->type_desc + type, 1);
 	eon->type_desc[type] = desc;
 	return 0;
 }
 
-static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p, int len, eon_data_cb_t callback, void *user)
+static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p, int len, eon_desc_cb_t desc_callback, eon_data_cb_t callback, void *user)
 {
 	const unsigned char *name, *data, *end, *last, *one_past_end = p + len;
 	int textlen, type;
@@ -396,7 +666,7 @@ static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p,
 		return -1;
 	}
 
-	record_type(eon, type, (const char *) name, textlen-3);
+	desc_callback(eon, type, (const char *) name, textlen-3, user);
 
 	end = data;
 	last = data;
@@ -418,7 +688,10 @@ static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p,
 			end += 4;
 		}
 
-		if (type >= MAXTYPE || !eon->type_desc[type].desc) {
+		if (!callback) {
+			// Only the descriptors are wanted.
+		} else if (type >= MAXTYPE || !eon->type_desc[type].desc ||
+			eon->type_desc[type].generation != eon->generation) {
 			HEXDUMP(eon->base.context, DC_LOGLEVEL_DEBUG, "last", last, 16);
 			HEXDUMP(eon->base.context, DC_LOGLEVEL_DEBUG, "this", begin, 16);
 		} else {
@@ -434,37 +707,54 @@ static int traverse_entry(suunto_eonsteel_parser_t *eon, const unsigned char *p,
 	return end - p;
 }
 
-static int traverse_data(suunto_eonsteel_parser_t *eon, eon_data_cb_t callback, void *user)
+// Offset of the first entry, or the size of the data if there are no
+// entries to traverse.
+static unsigned int traverse_begin(suunto_eonsteel_parser_t *eon)
 {
-	const unsigned char *data = eon->base.data;
-	int len = eon->base.size;
-
 	// Dive files start with "SBEM" and four NUL characters
 	// Additionally, we've prepended the time as an extra
 	// 4-byte pre-header
-	if (len < 12 || memcmp(data+4, "SBEM", 4))
-		return 0;
+	if (eon->base.size < 12 || memcmp(eon->base.data+4, "SBEM", 4))
+		return eon->base.size;
+
+	return 12;
+}
 
-	data += 12;
-	len -= 12;
+// Traverse a single entry, and advance the offset to the next one.
+// Returns 1 at the end of the data, and -1 for a bad entry.
+static int traverse_next(suunto_eonsteel_parser_t *eon, unsigned int *offset, eon_desc_cb_t desc_callback, eon_data_cb_t callback, void *user)
+{
+	int len = eon->base.size - *offset;
 
-	while (len > 4) {
-		int i = traverse_entry(eon, data, len, callback, user);
-		if (i < 0)
-			return 1;
-		len -= i;
-		data += i;
-	}
+	if (len <= 4)
+		return 1;
+
+	int i = traverse_entry(eon, eon->base.data + *offset, len, desc_callback, callback, user);
+	if (i < 0)
+		return -1;
+
+	*offset += i;
 	return 0;
 }
 
+static int traverse_data(suunto_eonsteel_parser_t *eon, eon_desc_cb_t desc_callback, eon_data_cb_t callback, void *user)
+{
+	unsigned int offset = traverse_begin(eon);
+	int rc;
+
+	while ((rc = traverse_next(eon, &offset, desc_callback, callback, user)) == 0)
+		;
+
+	return rc < 0;
+}
+
 struct sample_data {
 	suunto_eonsteel_parser_t *eon;
 	dc_sample_callback_t callback;
 	void *userdata;
 	unsigned int time;
-	const char *state_type, *notify_type;
-	const char *warning_type, *alarm_type;
+	parser_sample_event_t state_type, notify_type;
+	parser_sample_event_t warning_type, alarm_type;
 
 	/* We gather up deco and cylinder pressure information */
 	int gasnr;
@@ -606,66 +896,24 @@ static void sample_gas_switch_event(struct sample_data *info, unsigned short idx
 
 /*
  * Look up the string from an enumeration.
- *
- * Enumerations have the enum values in the "format" string,
- * and all start with "enum:" followed by a comma-separated list
- * of enumeration values and strings. Example:
- *
- * "enum:0=NoFly Time,1=Depth,2=Surface Time,3=..."
  */
 static const char *lookup_enum(const struct type_desc *desc, unsigned char value)
 {
-	const char *str = desc->format;
-	unsigned char c;
-
-	if (!str)
-		return NULL;
-	if (strncmp(str, "enum:", 5))
+	if (value >= desc->nenums)
 		return NULL;
-	str += 5;
-
-	while ((c = *str) != 0) {
-		unsigned char n;
-		const char *begin, *end;
-		char *ret;
 
-		str++;
-		if (!isdigit(c))
-			continue;
-		n = c - '0';
-
-		// We only handle one or two digits
-		if (isdigit(*str)) {
-			n = n*10 + *str - '0';
-			str++;
-		}
-
-		begin = end = str;
-		while ((c = *str) != 0) {
-			str++;
-			if (c == ',')
-				break;
-			end = str;
-		}
-
-		// Verify that it has the 'n=string' format and skip the equals sign
-		if (*begin != '=')
-			continue;
-		begin++;
-
-		// Is it the value we're looking for?
-		if (n != value)
-			continue;
+	return desc->enums[value];
+}
 
-		ret = (char *)malloc(end - begin + 1);
-		if (!ret)
-			break;
+/*
+ * Look up the sample event from an enumeration.
+ */
+static parser_sample_event_t lookup_enum_event(const struct type_desc *desc, unsigned char value)
+{
+	if (value >= desc->nenums)
+		return SAMPLE_EVENT_NONE;
 
-		memcpy(ret, begin, end-begin);
-		ret[end-begin] = 0;
-		return ret;
-	}
-	return NULL;
+	return desc->events[value];
 }
 
 /*
@@ -674,72 +922,34 @@ static const char *lookup_enum(const struct type_desc *desc, unsigned char value
  */
 static void sample_event_state_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	info->state_type = lookup_enum(desc, type);
+	info->state_type = lookup_enum_event(desc, type);
 }
 
 static void sample_event_state_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
 	dc_sample_value_t sample = {0};
-	static const eon_event_t states[] = {
-		{"Wet Outside",                SAMPLE_EVENT_NONE},
-		{"Below Wet Activation Depth", SAMPLE_EVENT_NONE},
-		{"Below Surface",              SAMPLE_EVENT_NONE},
-		{"Dive Active",                SAMPLE_EVENT_NONE},
-		{"Surface Calculation",        SAMPLE_EVENT_NONE},
-		{"Tank pressure available",    SAMPLE_EVENT_NONE},
-		{"Closed Circuit Mode",        SAMPLE_EVENT_NONE},
-	};
-	const char *name;
-
-	name = info->state_type;
-	if (!name)
-		return;
 
-	sample.event.type = lookup_event(name, states, C_ARRAY_SIZE(states));
-	if (sample.event.type == SAMPLE_EVENT_NONE)
+	if (info->state_type == SAMPLE_EVENT_NONE)
 		return;
 
+	sample.event.type = info->state_type;
 	sample.event.flags = value ? SAMPLE_FLAGS_BEGIN : SAMPLE_FLAGS_END;
 	if (info->callback) info->callback(DC_SAMPLE_EVENT, sample, info->userdata);
 }
 
 static void sample_event_notify_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	info->notify_type = lookup_enum(desc, type);
+	info->notify_type = lookup_enum_event(desc, type);
 }
 
 static void sample_event_notify_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
-	static const eon_event_t notifications[] = {
-		{"NoFly Time",         SAMPLE_EVENT_NONE},
-		{"Depth",              SAMPLE_EVENT_NONE},
-		{"Surface Time",       SAMPLE_EVENT_NONE},
-		{"Tissue Level",       SAMPLE_EVENT_TISSUELEVEL},
-		{"Deco",               SAMPLE_EVENT_NONE},
-		{"Deco Window",        SAMPLE_EVENT_NONE},
-		{"Safety Stop Ahead",  SAMPLE_EVENT_NONE},
-		{"Safety Stop",        SAMPLE_EVENT_SAFETYSTOP},
-		{"Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Deep Stop Ahead",    SAMPLE_EVENT_NONE},
-		{"Deep Stop",          SAMPLE_EVENT_DEEPSTOP},
-		{"Dive Time",          SAMPLE_EVENT_DIVETIME},
-		{"Gas Available",      SAMPLE_EVENT_NONE},
-		{"SetPoint Switch",    SAMPLE_EVENT_NONE},
-		{"Diluent Hypoxia",    SAMPLE_EVENT_NONE},
-		{"Air Time",           SAMPLE_EVENT_NONE},
-		{"Tank Pressure",      SAMPLE_EVENT_NONE},
-	};
 	dc_sample_value_t sample = {0};
-	const char *name;
-
-	name = info->notify_type;
-	if (!name)
-		return;
 
-	sample.event.type = lookup_event(name, notifications, C_ARRAY_SIZE(notifications));
-	if (sample.event.type == SAMPLE_EVENT_NONE)
+	if (info->notify_type == SAMPLE_EVENT_NONE)
 		return;
 
+	sample.event.type = info->notify_type;
 	sample.event.flags = value ? SAMPLE_FLAGS_BEGIN : SAMPLE_FLAGS_END;
 	if (info->callback) info->callback(DC_SAMPLE_EVENT, sample, info->userdata);
 }
@@ -747,70 +957,35 @@ static void sample_event_notify_value(const struct type_desc *desc, struct sampl
 
 static void sample_event_warning_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	info->warning_type = lookup_enum(desc, type);
+	info->warning_type = lookup_enum_event(desc, type);
 }
 
 static void sample_event_warning_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
-	static const eon_event_t warnings[] = {
-		{"ICD Penalty",           SAMPLE_EVENT_NONE},
-		{"Deep Stop Penalty",     SAMPLE_EVENT_VIOLATION},
-		{"Mandatory Safety Stop", SAMPLE_EVENT_SAFETYSTOP_MANDATORY},
-		{"OTU250",                SAMPLE_EVENT_NONE},
-		{"OTU300",                SAMPLE_EVENT_NONE},
-		{"CNS80%",                SAMPLE_EVENT_NONE},
-		{"CNS100%",               SAMPLE_EVENT_NONE},
-		{"Max.Depth",             SAMPLE_EVENT_MAXDEPTH},
-		{"Air Time",              SAMPLE_EVENT_AIRTIME},
-		{"Tank Pressure",         SAMPLE_EVENT_NONE},
-		{"Safety Stop Broken",    SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Deep Stop Broken",      SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Ceiling Broken",        SAMPLE_EVENT_CEILING},
-		{"PO2 High",              SAMPLE_EVENT_PO2},
-	};
 	dc_sample_value_t sample = {0};
-	const char *name;
-
-	name = info->warning_type;
-	if (!name)
-		return;
 
-	sample.event.type = lookup_event(name, warnings, C_ARRAY_SIZE(warnings));
-	if (sample.event.type == SAMPLE_EVENT_NONE)
+	if (info->warning_type == SAMPLE_EVENT_NONE)
 		return;
 
+	sample.event.type = info->warning_type;
 	sample.event.flags = value ? SAMPLE_FLAGS_BEGIN : SAMPLE_FLAGS_END;
 	if (info->callback) info->callback(DC_SAMPLE_EVENT, sample, info->userdata);
 }
 
 static void sample_event_alarm_type(const struct type_desc *desc, struct sample_data *info, unsigned char type)
 {
-	info->alarm_type = lookup_enum(desc, type);
+	info->alarm_type = lookup_enum_event(desc, type);
 }
 
 
 static void sample_event_alarm_value(const struct type_desc *desc, struct sample_data *info, unsigned char value)
 {
-	static const eon_event_t alarms[] = {
-		{"Mandatory Safety Stop Broken", SAMPLE_EVENT_CEILING_SAFETYSTOP},
-		{"Ascent Speed",                 SAMPLE_EVENT_ASCENT},
-		{"Diluent Hyperoxia",            SAMPLE_EVENT_NONE},
-		{"Violated Deep Stop",           SAMPLE_EVENT_VIOLATION},
-		{"Ceiling Broken",               SAMPLE_EVENT_CEILING},
-		{"PO2 High",                     SAMPLE_EVENT_PO2},
-		{"PO2 Low",                      SAMPLE_EVENT_PO2},
-	};
 	dc_sample_value_t sample = {0};
-	const char *name;
-
-	name = info->alarm_type;
-	if (!name)
-		return;
 
-	sample.event.type = lookup_event(name, alarms, C_ARRAY_SIZE(alarms));
-	if (sample.event.type == SAMPLE_EVENT_NONE)
+	if (info->alarm_type == SAMPLE_EVENT_NONE)
 		return;
 
+	sample.event.type = info->alarm_type;
 	sample.event.flags = value ? SAMPLE_FLAGS_BEGIN : SAMPLE_FLAGS_END;
 	if (info->callback) info->callback(DC_SAMPLE_EVENT, sample, info->userdata);
 }
@@ -834,12 +1009,10 @@ static void sample_setpoint_type(const struct type_desc *desc, struct sample_dat
 		sample.ppo2 = info->eon->cache.customsetpoint;
 	else {
 		DEBUG(info->eon->base.context, "sample_setpoint_type(%u) unknown type '%s'", value, type);
-		free((void *)type);
 		return;
 	}
 
 	if (info->callback) info->callback(DC_SAMPLE_SETPOINT, sample, info->userdata);
-	free((void *)type);
 }
 
 // uint32
@@ -1006,14 +1179,61 @@ static int traverse_samples(unsigned short type, const struct type_desc *desc, c
 	return 0;
 }
 
+// The samples are decoded one entry at a time, which allows to resume
+// the decoding for the sample iterator.
+typedef struct suunto_eonsteel_decoder_t {
+	dc_sample_decoder_t base;
+	struct sample_data info;
+	unsigned int offset;
+} suunto_eonsteel_decoder_t;
+
+static dc_status_t
+suunto_eonsteel_decoder_step(dc_sample_decoder_t *base, dc_sample_callback_t callback, void *userdata)
+{
+	suunto_eonsteel_decoder_t *decoder = (suunto_eonsteel_decoder_t *) base;
+	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) base->parser;
+
+	decoder->info.callback = callback;
+	decoder->info.userdata = userdata;
+
+	// A bad entry ends the profile, without an error.
+	if (traverse_next(eon, &decoder->offset, record_type, traverse_samples, &decoder->info))
+		return DC_STATUS_DONE;
+
+	return DC_STATUS_SUCCESS;
+}
+
+static void
+suunto_eonsteel_decoder_init(suunto_eonsteel_decoder_t *decoder, suunto_eonsteel_parser_t *eon)
+{
+	struct sample_data info = { eon, NULL, NULL, 0 };
+
+	decoder->base.parser = (dc_parser_t *) eon;
+	decoder->base.step = suunto_eonsteel_decoder_step;
+	decoder->info = info;
+	decoder->offset = traverse_begin(eon);
+}
+
 static dc_status_t
 suunto_eonsteel_parser_samples_foreach(dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) abstract;
-	struct sample_data data = { eon, callback, userdata, 0 };
+	suunto_eonsteel_decoder_t decoder;
 
-	traverse_data(eon, traverse_samples, &data);
-	return DC_STATUS_SUCCESS;
+	suunto_eonsteel_decoder_init(&decoder, eon);
+
+	return dc_sample_decoder_run(&decoder.base, callback, userdata);
+}
+
+static dc_status_t
+suunto_eonsteel_parser_samples_iterator(dc_parser_t *abstract, dc_iterator_t **iterator)
+{
+	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) abstract;
+	suunto_eonsteel_decoder_t decoder;
+
+	suunto_eonsteel_decoder_init(&decoder, eon);
+
+	return dc_sample_decoder_iterator(iterator, &decoder.base, sizeof(decoder));
 }
 
 // Ugly define thing makes the code much easier to read
@@ -1170,7 +1390,6 @@ static int add_gas_type(suunto_eonsteel_parser_t *eon, const struct type_desc *d
 
 	eon->cache.initialized |= 1 << DC_FIELD_GASMIX_COUNT;
 	eon->cache.initialized |= 1 << DC_FIELD_TANK_COUNT;
-	free((void *)name);
 	return 0;
 }
 
@@ -1438,12 +1657,186 @@ static int traverse_fields(unsigned short type, const struct type_desc *desc, co
 }
 
 
+/*
+ * The descriptor declarations of a dive, collected before parsing it.
+ */
+struct descset_state {
+	unsigned int hash;
+	unsigned int count;
+	unsigned int invalid;
+	unsigned short type[MAXTYPE];
+	const char *text[MAXTYPE];
+	unsigned int textlen[MAXTYPE];
+	unsigned char seen[MAXTYPE];
+};
+
+static int hash_descriptor(suunto_eonsteel_parser_t *eon, unsigned short type, const char *name, int namelen, void *user)
+{
+	struct descset_state *state = (struct descset_state *) user;
+
+	// Only dives that declare every type once can use a shared set,
+	// because all its descriptors are installed at the same time.
+	if (type >= MAXTYPE || namelen <= 0 || state->seen[type]) {
+		state->invalid = 1;
+		return 0;
+	}
+
+	state->seen[type] = 1;
+	state->type[state->count] = type;
+	state->text[state->count] = name;
+	state->textlen[state->count] = namelen;
+	state->count++;
+
+	// FNV-1a hash of the type and the descriptor text.
+	unsigned int hash = state->hash;
+	hash = (hash ^ (type & 0xFF)) * 16777619u;
+	hash = (hash ^ (type >> 8)) * 16777619u;
+	for (int i = 0; i < namelen; ++i)
+		hash = (hash ^ (unsigned char) name[i]) * 16777619u;
+	state->hash = hash;
+
+	return 0;
+}
+
+static int descset_matches(const eon_descset_t *set, const struct descset_state *state)
+{
+	if (set->count != state->count)
+		return 0;
+
+	for (unsigned int i = 0; i < set->count; ++i) {
+		const struct type_desc *desc = set->desc + i;
+		if (set->type[i] != state->type[i] ||
+			desc->textlen != state->textlen[i] ||
+			memcmp(desc->text, state->text[i], desc->textlen) != 0)
+			return 0;
+	}
+
+	return 1;
+}
+
+static void install_descset(suunto_eonsteel_parser_t *eon, const eon_descset_t *set)
+{
+	for (unsigned int i = 0; i < set->count; ++i) {
+		struct type_desc *desc = eon->type_desc + set->type[i];
+
+		desc_free(eon->base.context, desc, 1);
+		*desc = set->desc[i];
+		desc->shared = 1;
+
+		// Revalidated when the dive declares the descriptor.
+		desc->generation = eon->generation - 1;
+	}
+
+	eon->descset = set;
+}
+
+/*
+ * Remove the descriptors of the installed descriptor set, and release
+ * the reference to it. The context may destroy the set afterwards.
+ */
+static void release_descset(suunto_eonsteel_parser_t *eon)
+{
+	if (!eon->descset)
+		return;
+
+	for (unsigned int i = 0; i < MAXTYPE; ++i) {
+		if (eon->type_desc[i].shared)
+			memset(eon->type_desc + i, 0, sizeof(eon->type_desc[i]));
+	}
+
+	dc_context_release_shared(eon->base.context, (void *) eon->descset);
+	eon->descset = NULL;
+}
+
+#define REBASE(base, ptr, src) \
+	((ptr) ? (base) + ((const char *) (ptr) - (const char *) (src)) : NULL)
+
+static int desc_copy(dc_context_t *context, struct type_desc *dst, const struct type_desc *src)
+{
+	char *base;
+
+	*dst = *src;
+	dst->shared = 0;
+	dst->arena = dc_context_allocate(context, src->arenasize);
+	if (!dst->arena)
+		return -1;
+	memcpy(dst->arena, src->arena, src->arenasize);
+
+	base = (char *) dst->arena;
+	dst->desc = REBASE(base, src->desc, src->arena);
+	dst->format = REBASE(base, src->format, src->arena);
+	dst->mod = REBASE(base, src->mod, src->arena);
+	dst->text = REBASE(base, src->text, src->arena);
+	dst->enums = (const char **) REBASE(base, src->enums, src->arena);
+	dst->events = (parser_sample_event_t *) REBASE(base, src->events, src->arena);
+	for (unsigned int i = 0; i < dst->nenums; ++i)
+		dst->enums[i] = REBASE(base, src->enums[i], src->arena);
+
+	return 0;
+}
+
+static void descset_free(void *data)
+{
+	eon_descset_t *set = (eon_descset_t *) data;
+
+	if (!set)
+		return;
+
+	if (set->desc)
+		desc_free(set->context, set->desc, set->count);
+	dc_context_deallocate(set->context, set->desc);
+	dc_context_deallocate(set->context, set->type);
+	dc_context_deallocate(set->context, set);
+}
+
+/*
+ * Compile the descriptors of the current dive into a descriptor set,
+ * and share it with the other parsers of the context.
+ */
+static void share_descset(suunto_eonsteel_parser_t *eon, const struct descset_state *state)
+{
+	dc_context_t *context = eon->base.context;
+	eon_descset_t *set = (eon_descset_t *) dc_context_allocate(context, sizeof(*set));
+	if (!set)
+		return;
+
+	memset(set, 0, sizeof(*set));
+	set->context = context;
+	set->hash = state->hash;
+	set->type = (unsigned short *) dc_context_allocate(context, state->count * sizeof(*set->type));
+	set->desc = (struct type_desc *) dc_context_allocate(context, state->count * sizeof(*set->desc));
+	if (!set->type || !set->desc)
+		goto error;
+
+	for (unsigned int i = 0; i < state->count; ++i) {
+		const struct type_desc *desc = eon->type_desc + state->type[i];
+
+		// Descriptors that failed to parse are not shared.
+		if (!desc->desc || desc->generation != eon->generation)
+			goto error;
+
+		if (desc_copy(context, set->desc + i, desc) < 0)
+			goto error;
+
+		set->type[i] = state->type[i];
+		set->count++;
+	}
+
+	if (dc_context_add_shared(context, DC_FAMILY_SUUNTO_EONSTEEL, set->hash, set, descset_free) != DC_STATUS_SUCCESS)
+		goto error;
+
+	return;
+
+error:
+	descset_free(set);
+}
+
 static void initialize_field_caches(suunto_eonsteel_parser_t *eon)
 {
 	memset(&eon->cache, 0, sizeof(eon->cache));
 	eon->cache.initialized = 1 << DC_FIELD_DIVETIME;
 
-	traverse_data(eon, traverse_fields, eon);
+	traverse_data(eon, record_type, traverse_fields, eon);
 
 	// The internal time fields are in ms and have to be added up
 	// like that. At the end, we translate it back to seconds.
@@ -1454,7 +1847,7 @@ static void show_descriptor(suunto_eonsteel_parser_t *eon, int nr, struct type_d
 {
 	int i;
 
-	if (!desc->desc)
+	if (!desc->desc || desc->generation != eon->generation)
 		return;
 	DEBUG(eon->base.context, "Descriptor %d: '%s', size %d bytes", nr, desc->desc, desc->size);
 	if (desc->format)
@@ -1480,9 +1873,36 @@ suunto_eonsteel_parser_set_data(dc_parser_t *parser, const unsigned char *data,
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) parser;
 
-	desc_free(eon->type_desc, MAXTYPE);
-	memset(eon->type_desc, 0, sizeof(eon->type_desc));
+	// Invalidate the descriptors of the previous dive. They are
+	// revalidated without parsing them again if they are unchanged.
+	eon->generation++;
+
+	// Look for a compiled descriptor set shared by another dive.
+	struct descset_state state;
+	const eon_descset_t *set = NULL;
+	memset(&state, 0, sizeof(state));
+	state.hash = 2166136261u;
+	if (parser->context) {
+		traverse_data(eon, hash_descriptor, NULL, &state);
+		if (!state.invalid && state.count)
+			set = (const eon_descset_t *) dc_context_get_shared(parser->context, DC_FAMILY_SUUNTO_EONSTEEL, state.hash);
+	}
+
+	// Replace the descriptor set of the previous dive. The reference
+	// to the new set is taken first, to keep it alive if unchanged.
+	release_descset(eon);
+	if (set) {
+		if (descset_matches(set, &state))
+			install_descset(eon, set);
+		else
+			dc_context_release_shared(parser->context, (void *) set);
+	}
+
 	initialize_field_caches(eon);
+
+	if (parser->context && !state.invalid && state.count && set == NULL)
+		share_descset(eon, &state);
+
 	show_all_descriptors(eon);
 	return DC_STATUS_SUCCESS;
 }
@@ -1492,7 +1912,8 @@ suunto_eonsteel_parser_destroy(dc_parser_t *parser)
 {
 	suunto_eonsteel_parser_t *eon = (suunto_eonsteel_parser_t *) parser;
 
-	desc_free(eon->type_desc, MAXTYPE);
+	release_descset(eon);
+	desc_free(parser->context, eon->type_desc, MAXTYPE);
 
 	return DC_STATUS_SUCCESS;
 }
@@ -1504,6 +1925,8 @@ static const dc_parser_vtable_t suunto_eonsteel_parser_vtable = {
 	suunto_eonsteel_parser_get_datetime, /* datetime */
 	suunto_eonsteel_parser_get_field, /* fields */
 	suunto_eonsteel_parser_samples_foreach, /* samples_foreach */
+	suunto_eonsteel_parser_samples_iterator, /* samples_iterator */
+	NULL, /* samples_columns */
 	suunto_eonsteel_parser_destroy /* destroy */
 };
 
@@ -1523,6 +1946,8 @@ suunto_eonsteel_parser_create(dc_parser_t **out, dc_context_t *context, unsigned
 
 	memset(&parser->type_desc, 0, sizeof(parser->type_desc));
 	memset(&parser->cache, 0, sizeof(parser->cache));
+	parser->generation = 0;
+	parser->descset = NULL;
 
 	*out = (dc_parser_t *) parser;
 
@@ -0,0 +1,793 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#define NOGDI
+#include <windows.h>
+#else
+#include <time.h>
+#ifndef HAVE_CLOCK_GETTIME
+#include <sys/time.h>
+#endif
+#endif
+
+#include <libdivecomputer/buffer.h>
+
+#include "trace.h"
+#include "common-private.h"
+#include "context-private.h"
+#include "iostream-private.h"
+#include "array.h"
+
+/*
+ * The trace file starts with a magic string, followed by one record for
+ * every operation. Each record has a fixed size header (type, status,
+ * duration in microseconds, value and payload size), followed by the
+ * payload. All numbers are stored in little endian byte order.
+ */
+#define MAGIC    "DCTRACE1"
+#define SZ_MAGIC 8
+#define SZ_HEADER 14
+
+#define TRACE_SET_TIMEOUT    0x01
+#define TRACE_SET_LATENCY    0x02
+#define TRACE_SET_HALFDUPLEX 0x03
+#define TRACE_SET_BREAK      0x04
+#define TRACE_SET_DTR        0x05
+#define TRACE_SET_RTS        0x06
+#define TRACE_GET_LINES      0x07
+#define TRACE_GET_AVAILABLE  0x08
+#define TRACE_CONFIGURE      0x09
+#define TRACE_READ           0x0A
+#define TRACE_WRITE          0x0B
+#define TRACE_FLUSH          0x0C
+#define TRACE_PURGE          0x0D
+#define TRACE_SLEEP          0x0E
+
+static dc_status_t dc_record_set_timeout (dc_iostream_t *iostream, int timeout);
+static dc_status_t dc_record_set_latency (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_record_set_halfduplex (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_record_set_break (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_record_set_dtr (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_record_set_rts (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_record_get_lines (dc_iostream_t *iostream, unsigned int *value);
+static dc_status_t dc_record_get_available (dc_iostream_t *iostream, size_t *value);
+static dc_status_t dc_record_get_handle (dc_iostream_t *iostream, int *value);
+static dc_status_t dc_record_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
+static dc_status_t dc_record_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+static dc_status_t dc_record_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+static dc_status_t dc_record_flush (dc_iostream_t *iostream);
+static dc_status_t dc_record_purge (dc_iostream_t *iostream, dc_direction_t direction);
+static dc_status_t dc_record_sleep (dc_iostream_t *iostream, unsigned int milliseconds);
+static dc_status_t dc_record_close (dc_iostream_t *iostream);
+
+static dc_status_t dc_replay_set_timeout (dc_iostream_t *iostream, int timeout);
+static dc_status_t dc_replay_set_latency (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_replay_set_halfduplex (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_replay_set_break (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_replay_set_dtr (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_replay_set_rts (dc_iostream_t *iostream, unsigned int value);
+static dc_status_t dc_replay_get_lines (dc_iostream_t *iostream, unsigned int *value);
+static dc_status_t dc_replay_get_available (dc_iostream_t *iostream, size_t *value);
+static dc_status_t dc_replay_configure (dc_iostream_t *iostream, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol);
+static dc_status_t dc_replay_read (dc_iostream_t *iostream, void *data, size_t size, size_t *actual);
+static dc_status_t dc_replay_write (dc_iostream_t *iostream, const void *data, size_t size, size_t *actual);
+static dc_status_t dc_replay_flush (dc_iostream_t *iostream);
+static dc_status_t dc_replay_purge (dc_iostream_t *iostream, dc_direction_t direction);
+static dc_status_t dc_replay_sleep (dc_iostream_t *iostream, unsigned int milliseconds);
+static dc_status_t dc_replay_close (dc_iostream_t *iostream);
+
+typedef struct dc_trace_t {
+	/* Base class. */
+	dc_iostream_t base;
+	/* Internal state. */
+	dc_iostream_t *iostream;
+	FILE *fp;
+	unsigned int speed;
+	dc_buffer_t *payload;
+} dc_trace_t;
+
+static const dc_iostream_vtable_t dc_record_vtable = {
+	sizeof(dc_trace_t),
+	dc_record_set_timeout, /* set_timeout */
+	dc_record_set_latency, /* set_latency */
+	dc_record_set_halfduplex, /* set_halfduplex */
+	dc_record_set_break, /* set_break */
+	dc_record_set_dtr, /* set_dtr */
+	dc_record_set_rts, /* set_rts */
+	dc_record_get_lines, /* get_lines */
+	dc_record_get_available, /* get_received */
+	dc_record_get_handle, /* get_handle */
+	dc_record_configure, /* configure */
+	dc_record_read, /* read */
+	dc_record_write, /* write */
+	dc_record_flush, /* flush */
+	dc_record_purge, /* purge */
+	dc_record_sleep, /* sleep */
+	dc_record_close, /* close */
+};
+
+static const dc_iostream_vtable_t dc_replay_vtable = {
+	sizeof(dc_trace_t),
+	dc_replay_set_timeout, /* set_timeout */
+	dc_replay_set_latency, /* set_latency */
+	dc_replay_set_halfduplex, /* set_halfduplex */
+	dc_replay_set_break, /* set_break */
+	dc_replay_set_dtr, /* set_dtr */
+	dc_replay_set_rts, /* set_rts */
+	dc_replay_get_lines, /* get_lines */
+	dc_replay_get_available, /* get_received */
+	NULL, /* get_handle */
+	dc_replay_configure, /* configure */
+	dc_replay_read, /* read */
+	dc_replay_write, /* write */
+	dc_replay_flush, /* flush */
+	dc_replay_purge, /* purge */
+	dc_replay_sleep, /* sleep */
+	dc_replay_close, /* close */
+};
+
+/*
+ * Call an operation of the recorded I/O stream directly, instead of with
+ * the dc_iostream_* functions. These already log the operation for the
+ * recorder itself, and would log it a second time.
+ */
+#define INNER(trace, op, ...) \
+	((trace)->iostream->vtable->op ? \
+	(trace)->iostream->vtable->op ((trace)->iostream, __VA_ARGS__) : \
+	DC_STATUS_UNSUPPORTED)
+
+/*
+ * Get the value of a monotonic clock in microseconds.
+ */
+static unsigned long long
+dc_trace_now (void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER counter, frequency;
+	QueryPerformanceCounter (&counter);
+	QueryPerformanceFrequency (&frequency);
+	return counter.QuadPart * 1000000ULL / frequency.QuadPart;
+#elif defined (HAVE_CLOCK_GETTIME)
+	struct timespec ts;
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+#else
+	struct timeval tv;
+	gettimeofday (&tv, NULL);
+	return tv.tv_sec * 1000000ULL + tv.tv_usec;
+#endif
+}
+
+static void
+dc_trace_delay (unsigned long long microseconds)
+{
+	if (microseconds == 0)
+		return;
+
+#ifdef _WIN32
+	Sleep ((DWORD) ((microseconds + 999) / 1000));
+#else
+	struct timespec ts;
+	ts.tv_sec  = microseconds / 1000000;
+	ts.tv_nsec = (microseconds % 1000000) * 1000;
+	while (nanosleep (&ts, &ts) != 0) {
+		// Resume the sleep when interrupted by a signal.
+	}
+#endif
+}
+
+/*
+ * Open the trace file of the I/O stream with the given sequence number.
+ * The first stream uses the filename as is, the next ones get the
+ * sequence number appended.
+ */
+static FILE *
+dc_trace_fopen (dc_context_t *context, const char *filename, unsigned int index, const char *mode)
+{
+	if (index == 0)
+		return fopen (filename, mode);
+
+	size_t length = strlen (filename) + 16;
+	char *name = (char *) dc_context_allocate (context, length);
+	if (name == NULL)
+		return NULL;
+
+	snprintf (name, length, "%s.%u", filename, index);
+
+	FILE *fp = fopen (name, mode);
+
+	dc_context_deallocate (context, name);
+
+	return fp;
+}
+
+static dc_status_t
+dc_trace_record (dc_trace_t *trace, unsigned int type, dc_status_t status, unsigned long long start, unsigned int value, const void *data, size_t size)
+{
+	unsigned long long elapsed = dc_trace_now () - start;
+	if (elapsed > 0xFFFFFFFF)
+		elapsed = 0xFFFFFFFF;
+
+	unsigned char header[SZ_HEADER] = {0};
+	header[0] = type;
+	header[1] = (unsigned char) (signed char) status;
+	array_uint32_le_set (header + 2, elapsed);
+	array_uint32_le_set (header + 6, value);
+	array_uint32_le_set (header + 10, size);
+
+	if (fwrite (header, sizeof (header), 1, trace->fp) != 1 ||
+		(size && fwrite (data, size, 1, trace->fp) != 1)) {
+		ERROR (trace->base.context, "Failed to write the trace file.");
+		return DC_STATUS_IO;
+	}
+
+	return status;
+}
+
+dc_status_t
+dc_trace_record_open (dc_iostream_t **out, dc_context_t *context)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_trace_t *trace = NULL;
+	const char *filename = NULL;
+
+	if (out == NULL || *out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (dc_context_get_trace (context, &filename, NULL) != DC_TRACE_RECORD)
+		return DC_STATUS_SUCCESS;
+
+	unsigned int index = dc_context_next_trace (context, 0);
+
+	INFO (context, "Record: filename=%s, index=%u", filename, index);
+
+	// Allocate memory.
+	trace = (dc_trace_t *) dc_iostream_allocate (context, &dc_record_vtable);
+	if (trace == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_close;
+	}
+
+	trace->iostream = *out;
+	trace->speed = 0;
+	trace->payload = NULL;
+
+	trace->fp = dc_trace_fopen (context, filename, index, "wb");
+	if (trace->fp == NULL) {
+		ERROR (context, "Failed to create the trace file.");
+		status = DC_STATUS_IO;
+		goto error_free;
+	}
+
+	if (fwrite (MAGIC, SZ_MAGIC, 1, trace->fp) != 1) {
+		ERROR (context, "Failed to write the trace file.");
+		status = DC_STATUS_IO;
+		goto error_fclose;
+	}
+
+	*out = (dc_iostream_t *) trace;
+
+	return DC_STATUS_SUCCESS;
+
+error_fclose:
+	fclose (trace->fp);
+error_free:
+	dc_iostream_deallocate ((dc_iostream_t *) trace);
+error_close:
+	dc_iostream_close (*out);
+	*out = NULL;
+	return status;
+}
+
+static dc_status_t
+dc_record_set_timeout (dc_iostream_t *abstract, int timeout)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, set_timeout, timeout);
+
+	return dc_trace_record (trace, TRACE_SET_TIMEOUT, status, start, timeout, NULL, 0);
+}
+
+static dc_status_t
+dc_record_set_latency (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, set_latency, value);
+
+	return dc_trace_record (trace, TRACE_SET_LATENCY, status, start, value, NULL, 0);
+}
+
+static dc_status_t
+dc_record_set_halfduplex (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, set_halfduplex, value);
+
+	return dc_trace_record (trace, TRACE_SET_HALFDUPLEX, status, start, value, NULL, 0);
+}
+
+static dc_status_t
+dc_record_set_break (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, set_break, value);
+
+	return dc_trace_record (trace, TRACE_SET_BREAK, status, start, value, NULL, 0);
+}
+
+static dc_status_t
+dc_record_set_dtr (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, set_dtr, value);
+
+	return dc_trace_record (trace, TRACE_SET_DTR, status, start, value, NULL, 0);
+}
+
+static dc_status_t
+dc_record_set_rts (dc_iostream_t *abstract, unsigned int value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, set_rts, value);
+
+	return dc_trace_record (trace, TRACE_SET_RTS, status, start, value, NULL, 0);
+}
+
+static dc_status_t
+dc_record_get_lines (dc_iostream_t *abstract, unsigned int *value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+	unsigned int lines = 0;
+
+	dc_status_t status = INNER (trace, get_lines, &lines);
+
+	if (value)
+		*value = lines;
+
+	return dc_trace_record (trace, TRACE_GET_LINES, status, start, lines, NULL, 0);
+}
+
+static dc_status_t
+dc_record_get_available (dc_iostream_t *abstract, size_t *value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+	size_t available = 0;
+
+	dc_status_t status = INNER (trace, get_available, &available);
+
+	if (value)
+		*value = available;
+
+	return dc_trace_record (trace, TRACE_GET_AVAILABLE, status, start, available, NULL, 0);
+}
+
+static dc_status_t
+dc_record_get_handle (dc_iostream_t *abstract, int *value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+
+	return dc_iostream_get_handle (trace->iostream, value);
+}
+
+static dc_status_t
+dc_record_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, configure, baudrate, databits, parity, stopbits, flowcontrol);
+
+	const unsigned char settings[] = {databits, parity, stopbits, flowcontrol};
+
+	return dc_trace_record (trace, TRACE_CONFIGURE, status, start, baudrate, settings, sizeof (settings));
+}
+
+static dc_status_t
+dc_record_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+	size_t nbytes = 0;
+
+	dc_status_t status = INNER (trace, read, data, size, &nbytes);
+
+	if (actual)
+		*actual = nbytes;
+
+	return dc_trace_record (trace, TRACE_READ, status, start, size, data, nbytes);
+}
+
+static dc_status_t
+dc_record_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+	size_t nbytes = 0;
+
+	dc_status_t status = INNER (trace, write, data, size, &nbytes);
+
+	if (actual)
+		*actual = nbytes;
+
+	return dc_trace_record (trace, TRACE_WRITE, status, start, size, data, nbytes);
+}
+
+static dc_status_t
+dc_record_flush (dc_iostream_t *abstract)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = DC_STATUS_UNSUPPORTED;
+	if (trace->iostream->vtable->flush)
+		status = trace->iostream->vtable->flush (trace->iostream);
+
+	return dc_trace_record (trace, TRACE_FLUSH, status, start, 0, NULL, 0);
+}
+
+static dc_status_t
+dc_record_purge (dc_iostream_t *abstract, dc_direction_t direction)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, purge, direction);
+
+	return dc_trace_record (trace, TRACE_PURGE, status, start, direction, NULL, 0);
+}
+
+static dc_status_t
+dc_record_sleep (dc_iostream_t *abstract, unsigned int milliseconds)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	unsigned long long start = dc_trace_now ();
+
+	dc_status_t status = INNER (trace, sleep, milliseconds);
+
+	return dc_trace_record (trace, TRACE_SLEEP, status, start, milliseconds, NULL, 0);
+}
+
+static dc_status_t
+dc_record_close (dc_iostream_t *abstract)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+
+	if (fclose (trace->fp) != 0) {
+		ERROR (abstract->context, "Failed to write the trace file.");
+		dc_status_set_error (&status, DC_STATUS_IO);
+	}
+
+	dc_status_set_error (&status, dc_iostream_close (trace->iostream));
+
+	return status;
+}
+
+dc_status_t
+dc_trace_replay_open (dc_iostream_t **out, dc_context_t *context)
+{
+	dc_status_t status = DC_STATUS_SUCCESS;
+	dc_trace_t *trace = NULL;
+	const char *filename = NULL;
+	unsigned int speed = 0;
+	unsigned char magic[SZ_MAGIC] = {0};
+
+	if (out == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	if (dc_context_get_trace (context, &filename, &speed) != DC_TRACE_REPLAY)
+		return DC_STATUS_INVALIDARGS;
+
+	unsigned int index = dc_context_next_trace (context, 0);
+
+	// Allocate memory.
+	trace = (dc_trace_t *) dc_iostream_allocate (context, &dc_replay_vtable);
+	if (trace == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	trace->iostream = NULL;
+	trace->speed = speed;
+
+	trace->payload = dc_buffer_new2 (context, 0);
+	if (trace->payload == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		status = DC_STATUS_NOMEMORY;
+		goto error_free;
+	}
+
+	trace->fp = dc_trace_fopen (context, filename, index, "rb");
+	if (trace->fp == NULL && index) {
+		// All streams have been replayed, start again.
+		index = dc_context_next_trace (context, 1);
+		trace->fp = dc_trace_fopen (context, filename, index, "rb");
+	}
+
+	INFO (context, "Replay: filename=%s, index=%u, speed=%u", filename, index, speed);
+
+	if (trace->fp == NULL) {
+		ERROR (context, "Failed to open the trace file.");
+		status = DC_STATUS_IO;
+		goto error_buffer_free;
+	}
+
+	if (fread (magic, sizeof (magic), 1, trace->fp) != 1 ||
+		memcmp (magic, MAGIC, SZ_MAGIC) != 0) {
+		ERROR (context, "Invalid trace file.");
+		status = DC_STATUS_DATAFORMAT;
+		goto error_fclose;
+	}
+
+	*out = (dc_iostream_t *) trace;
+
+	return DC_STATUS_SUCCESS;
+
+error_fclose:
+	fclose (trace->fp);
+error_buffer_free:
+	dc_buffer_free (trace->payload);
+error_free:
+	dc_iostream_deallocate ((dc_iostream_t *) trace);
+	return status;
+}
+
+/*
+ * Read the next record from the trace file, and wait for the recorded
+ * duration of the operation, scaled by the replay speed. The payload is
+ * stored in the internal buffer.
+ */
+static dc_status_t
+dc_trace_next (dc_trace_t *trace, unsigned int type, dc_status_t *status, unsigned int *value)
+{
+	dc_context_t *context = trace->base.context;
+	unsigned char header[SZ_HEADER] = {0};
+
+	if (fread (header, sizeof (header), 1, trace->fp) != 1) {
+		ERROR (context, "Unexpected end of the trace file.");
+		return DC_STATUS_IO;
+	}
+
+	if (header[0] != type) {
+		ERROR (context, "Unexpected trace record (type=%u, expected=%u).", header[0], type);
+		return DC_STATUS_IO;
+	}
+
+	unsigned int elapsed = array_uint32_le (header + 2);
+	unsigned int size = array_uint32_le (header + 10);
+
+	if (!dc_buffer_resize (trace->payload, size) ||
+		(size && fread (dc_buffer_get_data (trace->payload), size, 1, trace->fp) != 1)) {
+		ERROR (context, "Unexpected end of the trace file.");
+		return DC_STATUS_IO;
+	}
+
+	if (trace->speed) {
+		dc_trace_delay (elapsed / trace->speed);
+	}
+
+	*status = (dc_status_t) (signed char) header[1];
+
+	if (value)
+		*value = array_uint32_le (header + 6);
+
+	return DC_STATUS_SUCCESS;
+}
+
+static dc_status_t
+dc_replay_simple (dc_iostream_t *abstract, unsigned int type)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+
+	dc_status_t rc = dc_trace_next (trace, type, &status, NULL);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	return status;
+}
+
+static dc_status_t
+dc_replay_set_timeout (dc_iostream_t *abstract, int timeout)
+{
+	return dc_replay_simple (abstract, TRACE_SET_TIMEOUT);
+}
+
+static dc_status_t
+dc_replay_set_latency (dc_iostream_t *abstract, unsigned int value)
+{
+	return dc_replay_simple (abstract, TRACE_SET_LATENCY);
+}
+
+static dc_status_t
+dc_replay_set_halfduplex (dc_iostream_t *abstract, unsigned int value)
+{
+	return dc_replay_simple (abstract, TRACE_SET_HALFDUPLEX);
+}
+
+static dc_status_t
+dc_replay_set_break (dc_iostream_t *abstract, unsigned int value)
+{
+	return dc_replay_simple (abstract, TRACE_SET_BREAK);
+}
+
+static dc_status_t
+dc_replay_set_dtr (dc_iostream_t *abstract, unsigned int value)
+{
+	return dc_replay_simple (abstract, TRACE_SET_DTR);
+}
+
+static dc_status_t
+dc_replay_set_rts (dc_iostream_t *abstract, unsigned int value)
+{
+	return dc_replay_simple (abstract, TRACE_SET_RTS);
+}
+
+static dc_status_t
+dc_replay_get_lines (dc_iostream_t *abstract, unsigned int *value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	unsigned int lines = 0;
+
+	dc_status_t rc = dc_trace_next (trace, TRACE_GET_LINES, &status, &lines);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	if (value)
+		*value = lines;
+
+	return status;
+}
+
+static dc_status_t
+dc_replay_get_available (dc_iostream_t *abstract, size_t *value)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	unsigned int available = 0;
+
+	dc_status_t rc = dc_trace_next (trace, TRACE_GET_AVAILABLE, &status, &available);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	if (value)
+		*value = available;
+
+	return status;
+}
+
+static dc_status_t
+dc_replay_configure (dc_iostream_t *abstract, unsigned int baudrate, unsigned int databits, dc_parity_t parity, dc_stopbits_t stopbits, dc_flowcontrol_t flowcontrol)
+{
+	return dc_replay_simple (abstract, TRACE_CONFIGURE);
+}
+
+static dc_status_t
+dc_replay_read (dc_iostream_t *abstract, void *data, size_t size, size_t *actual)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	size_t nbytes = 0;
+
+	dc_status_t rc = dc_trace_next (trace, TRACE_READ, &status, NULL);
+	if (rc != DC_STATUS_SUCCESS) {
+		status = rc;
+		goto out;
+	}
+
+	nbytes = dc_buffer_get_size (trace->payload);
+	if (nbytes > size) {
+		WARNING (abstract->context, "Read request smaller than the recorded data (%u %u).",
+			(unsigned int) size, (unsigned int) nbytes);
+		nbytes = size;
+	}
+
+	if (nbytes) {
+		memcpy (data, dc_buffer_get_data (trace->payload), nbytes);
+	}
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+dc_replay_write (dc_iostream_t *abstract, const void *data, size_t size, size_t *actual)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+	dc_status_t status = DC_STATUS_SUCCESS;
+	size_t nbytes = 0;
+
+	dc_status_t rc = dc_trace_next (trace, TRACE_WRITE, &status, NULL);
+	if (rc != DC_STATUS_SUCCESS) {
+		status = rc;
+		goto out;
+	}
+
+	nbytes = dc_buffer_get_size (trace->payload);
+	if (nbytes > size ||
+		(nbytes && memcmp (data, dc_buffer_get_data (trace->payload), nbytes) != 0)) {
+		WARNING (abstract->context, "Written data differs from the recorded data.");
+		if (nbytes > size)
+			nbytes = size;
+	}
+
+out:
+	if (actual)
+		*actual = nbytes;
+
+	return status;
+}
+
+static dc_status_t
+dc_replay_flush (dc_iostream_t *abstract)
+{
+	return dc_replay_simple (abstract, TRACE_FLUSH);
+}
+
+static dc_status_t
+dc_replay_purge (dc_iostream_t *abstract, dc_direction_t direction)
+{
+	return dc_replay_simple (abstract, TRACE_PURGE);
+}
+
+static dc_status_t
+dc_replay_sleep (dc_iostream_t *abstract, unsigned int milliseconds)
+{
+	return dc_replay_simple (abstract, TRACE_SLEEP);
+}
+
+static dc_status_t
+dc_replay_close (dc_iostream_t *abstract)
+{
+	dc_trace_t *trace = (dc_trace_t *) abstract;
+
+	fclose (trace->fp);
+	dc_buffer_free (trace->payload);
+
+	return DC_STATUS_SUCCESS;
+}
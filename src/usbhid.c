@@ -54,6 +54,7 @@
 #include "common-private.h"
 #include "context-private.h"
 #include "iostream-private.h"
+#include "trace.h"
 #include "platform.h"
 
 #ifdef _WIN32
@@ -98,6 +99,7 @@ static const dc_iostream_vtable_t dc_usbhid_vtable = {
 	NULL, /* set_rts */
 	NULL, /* get_lines */
 	NULL, /* get_received */
+	NULL, /* get_handle */
 	NULL, /* configure */
 	dc_usbhid_read, /* read */
 	dc_usbhid_write, /* write */
@@ -216,6 +218,10 @@ dc_usbhid_exit (void)
 dc_status_t
 dc_usbhid_open (dc_iostream_t **out, dc_context_t *context, unsigned int vid, unsigned int pid)
 {
+	// Replay a recorded trace instead of opening the device.
+	if (dc_context_get_trace (context, NULL, NULL) == DC_TRACE_REPLAY)
+		return dc_trace_replay_open (out, context);
+
 #ifdef USBHID
 	dc_status_t status = DC_STATUS_SUCCESS;
 	dc_usbhid_t *usbhid = NULL;
@@ -376,7 +382,8 @@ dc_usbhid_open (dc_iostream_t **out, dc_context_t *context, unsigned int vid, un
 
 	*out = (dc_iostream_t *) usbhid;
 
-	return DC_STATUS_SUCCESS;
+	// Record the traffic, if enabled.
+	return dc_trace_record_open (out, context);
 
 #if defined(USE_LIBUSB)
 error_usb_close:
@@ -58,6 +58,7 @@ static const dc_device_vtable_t uwatec_g2_device_vtable = {
 	NULL, /* write */
 	uwatec_g2_device_dump, /* dump */
 	uwatec_g2_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	uwatec_g2_device_close /* close */
 };
@@ -216,6 +217,8 @@ uwatec_g2_device_open (dc_device_t **out, dc_context_t *context, unsigned int mo
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Perform the handshaking.
 	status = uwatec_g2_handshake (device);
 	if (status != DC_STATUS_SUCCESS) {
@@ -393,7 +396,7 @@ uwatec_g2_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 static dc_status_t
 uwatec_g2_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
-	dc_buffer_t *buffer = dc_buffer_new (0);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, 0);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
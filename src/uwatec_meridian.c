@@ -56,6 +56,7 @@ static const dc_device_vtable_t uwatec_meridian_device_vtable = {
 	NULL, /* write */
 	uwatec_meridian_device_dump, /* dump */
 	uwatec_meridian_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	uwatec_meridian_device_close /* close */
 };
@@ -138,6 +139,7 @@ uwatec_meridian_transfer (uwatec_meridian_device_t *device, const unsigned char
 	ccsum = checksum_xor_uint8 (answer, asize, ccsum);
 	if (csum != ccsum) {
 		ERROR (abstract->context, "Unexpected answer checksum.");
+		device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 		return DC_STATUS_PROTOCOL;
 	}
 
@@ -211,6 +213,8 @@ uwatec_meridian_device_open (dc_device_t **out, dc_context_t *context, const cha
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Set the serial communication protocol (57600 8N1).
 	status = dc_iostream_configure (device->iostream, 57600, 8, DC_PARITY_NONE, DC_STOPBITS_ONE, DC_FLOWCONTROL_NONE);
 	if (status != DC_STATUS_SUCCESS) {
@@ -432,6 +436,7 @@ uwatec_meridian_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 		ccsum = checksum_xor_uint8 (data + nbytes, packetsize - 1, ccsum);
 		if (csum != ccsum) {
 			ERROR (abstract->context, "Unexpected answer checksum.");
+			device_stats_increment (abstract, DEVICE_STATS_CHECKSUM);
 			return DC_STATUS_PROTOCOL;
 		}
 
@@ -450,7 +455,7 @@ uwatec_meridian_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 static dc_status_t
 uwatec_meridian_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
-	dc_buffer_t *buffer = dc_buffer_new (0);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, 0);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
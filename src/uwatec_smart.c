@@ -52,6 +52,7 @@ static const dc_device_vtable_t uwatec_smart_device_vtable = {
 	NULL, /* write */
 	uwatec_smart_device_dump, /* dump */
 	uwatec_smart_device_foreach, /* foreach */
+	NULL, /* download */
 	NULL, /* timesync */
 	uwatec_smart_device_close /* close */
 };
@@ -171,6 +172,8 @@ uwatec_smart_device_open (dc_device_t **out, dc_context_t *context)
 		goto error_free;
 	}
 
+	device_set_iostream ((dc_device_t *) device, device->iostream);
+
 	// Discover the device.
 	status = dc_irda_discover (device->iostream, uwatec_smart_discovery, device);
 	if (status != DC_STATUS_SUCCESS) {
@@ -383,7 +386,7 @@ uwatec_smart_device_dump (dc_device_t *abstract, dc_buffer_t *buffer)
 static dc_status_t
 uwatec_smart_device_foreach (dc_device_t *abstract, dc_dive_callback_t callback, void *userdata)
 {
-	dc_buffer_t *buffer = dc_buffer_new (0);
+	dc_buffer_t *buffer = dc_buffer_new2 (abstract->context, 0);
 	if (buffer == NULL)
 		return DC_STATUS_NOMEMORY;
 
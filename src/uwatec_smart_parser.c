@@ -114,6 +114,13 @@ typedef struct uwatec_smart_sample_info_t {
 	unsigned int extrabytes;
 } uwatec_smart_sample_info_t;
 
+typedef struct uwatec_smart_decode_t {
+	const uwatec_smart_sample_info_t *info;
+	unsigned char nbytes;
+	unsigned char nbits;
+	unsigned char mask;
+} uwatec_smart_decode_t;
+
 typedef struct uwatec_smart_event_info_t {
 	uwatec_smart_event_t type;
 	unsigned int mask;
@@ -144,6 +151,8 @@ struct uwatec_smart_parser_t {
 	const uwatec_smart_header_info_t *header;
 	unsigned int headersize;
 	unsigned int nsamples;
+	unsigned int galileo;
+	uwatec_smart_decode_t decode[256];
 	const uwatec_smart_event_info_t *events[NEVENTS];
 	unsigned int nevents[NEVENTS];
 	unsigned int trimix;
@@ -157,12 +166,38 @@ struct uwatec_smart_parser_t {
 	dc_divemode_t divemode;
 };
 
+typedef struct uwatec_smart_decoder_t {
+	dc_sample_decoder_t base;
+	unsigned int offset;
+	int complete;
+	int calibrated;
+	unsigned int time;
+	unsigned int rbt;
+	unsigned int tank;
+	unsigned int gasmix;
+	double depth, depth_calibration;
+	double temperature;
+	double pressure;
+	unsigned int heartrate;
+	unsigned int bearing;
+	unsigned int bookmark;
+	unsigned int gasmix_previous;
+	double salinity;
+	unsigned int interval;
+	int have_depth, have_temperature, have_pressure, have_rbt,
+		have_heartrate, have_bearing;
+} uwatec_smart_decoder_t;
+
+static dc_status_t uwatec_smart_decoder_step (dc_sample_decoder_t *base, dc_sample_callback_t callback, void *userdata);
+
 static dc_status_t uwatec_smart_parser_set_data (dc_parser_t *abstract, const unsigned char *data, unsigned int size);
 static dc_status_t uwatec_smart_parser_get_datetime (dc_parser_t *abstract, dc_datetime_t *datetime);
 static dc_status_t uwatec_smart_parser_get_field (dc_parser_t *abstract, dc_field_type_t type, unsigned int flags, void *value);
 static dc_status_t uwatec_smart_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata);
+static dc_status_t uwatec_smart_parser_samples_iterator (dc_parser_t *abstract, dc_iterator_t **iterator);
 
 static dc_status_t uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata);
+static void uwatec_smart_parser_plan (uwatec_smart_parser_t *parser);
 
 static const dc_parser_vtable_t uwatec_smart_parser_vtable = {
 	sizeof(uwatec_smart_parser_t),
@@ -171,6 +206,8 @@ static const dc_parser_vtable_t uwatec_smart_parser_vtable = {
 	uwatec_smart_parser_get_datetime, /* datetime */
 	uwatec_smart_parser_get_field, /* fields */
 	uwatec_smart_parser_samples_foreach, /* samples_foreach */
+	uwatec_smart_parser_samples_iterator, /* samples_iterator */
+	NULL, /* samples_columns */
 	NULL /* destroy */
 };
 
@@ -461,6 +498,9 @@ uwatec_smart_parser_cache (uwatec_smart_parser_t *parser)
 		}
 	}
 
+	if (size < parser->headersize)
+		return DC_STATUS_DATAFORMAT;
+
 	const uwatec_smart_header_info_t *header = parser->header;
 
 	// Get the settings.
@@ -520,11 +560,7 @@ uwatec_smart_parser_cache (uwatec_smart_parser_t *parser)
 			unsigned int endpressure = 0;
 			if (header->tankpressure != UNSUPPORTED &&
 				divemode != DC_DIVEMODE_FREEDIVE) {
-				if (parser->model == GALILEO || parser->model == GALILEOTRIMIX ||
-					parser->model == ALADIN2G || parser->model == MERIDIAN ||
-					parser->model == CHROMIS || parser->model == MANTIS2 ||
-					parser->model == G2 || parser->model == ALADINSPORTMATRIX ||
-					parser->model == ALADINSQUARE) {
+				if (parser->galileo) {
 					unsigned int offset = header->tankpressure + 2 * i;
 					endpressure   = array_uint16_le(data + offset);
 					beginpressure = array_uint16_le(data + offset + 2 * header->ngases);
@@ -583,6 +619,7 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 	parser->devtime = devtime;
 	parser->systime = systime;
 	parser->trimix = 0;
+	parser->galileo = 0;
 	for (unsigned int i = 0; i < NEVENTS; ++i) {
 		parser->events[i] = NULL;
 		parser->nevents[i] = 0;
@@ -613,6 +650,7 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 		parser->nevents[0] = C_ARRAY_SIZE (uwatec_smart_galileo_events_0);
 		parser->nevents[1] = C_ARRAY_SIZE (uwatec_smart_galileo_events_1);
 		parser->nevents[2] = C_ARRAY_SIZE (uwatec_smart_galileo_events_2);
+		parser->galileo = 1;
 		break;
 	case G2:
 	case ALADINSPORTMATRIX:
@@ -627,6 +665,7 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 		parser->nevents[1] = C_ARRAY_SIZE (uwatec_smart_galileo_events_1);
 		parser->nevents[2] = C_ARRAY_SIZE (uwatec_smart_trimix_events_2);
 		parser->trimix = 1;
+		parser->galileo = 1;
 		break;
 	case ALADINTEC:
 		parser->headersize = 108;
@@ -668,6 +707,9 @@ uwatec_smart_parser_create (dc_parser_t **out, dc_context_t *context, unsigned i
 		goto error_free;
 	}
 
+	// Build the decode table for the sample type bits.
+	uwatec_smart_parser_plan (parser);
+
 	parser->cached = 0;
 	parser->ngasmixes = 0;
 	parser->ntanks = 0;
@@ -898,341 +940,392 @@ uwatec_smart_fixsignbit (unsigned int x, unsigned int n)
 }
 
 
-static dc_status_t
-uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata)
+static void
+uwatec_smart_decode_init (uwatec_smart_decode_t *decode, const uwatec_smart_sample_info_t *info)
 {
-	dc_parser_t *abstract = (dc_parser_t *) parser;
+	unsigned int n = info->ntypebits % NBITS;
+
+	decode->info = info;
+	decode->nbytes = (info->ntypebits + NBITS - 1) / NBITS;
+	if (n > 0 && !info->ignoretype) {
+		// The remaining bits of the last type byte are data bits.
+		decode->nbits = NBITS - n;
+		decode->mask = 0xFF >> n;
+	} else {
+		// Ignore any data bits that are stored in
+		// the last type byte for certain samples.
+		decode->nbits = 0;
+		decode->mask = 0;
+	}
+}
 
-	const unsigned char *data = abstract->data;
-	unsigned int size = abstract->size;
 
-	const uwatec_smart_sample_info_t *table = parser->samples;
-	unsigned int entries = parser->nsamples;
+static void
+uwatec_smart_parser_plan (uwatec_smart_parser_t *parser)
+{
+	// Map every possible first byte of a sample to its sample type.
+	// Type bits that continue in the next byte (Smart models only)
+	// remain unresolved, and are handled by the bit scanner.
+	for (unsigned int i = 0; i < C_ARRAY_SIZE (parser->decode); ++i) {
+		unsigned char value = i;
+		unsigned int id = 0;
+		if (parser->galileo) {
+			id = uwatec_galileo_identify (value);
+		} else {
+			id = uwatec_smart_identify (&value, 1);
+		}
 
-	// Get the maximum number of alarm bytes.
-	unsigned int nalarms = 0;
-	for (unsigned int i = 0; i < entries; ++i) {
-		if (table[i].type == ALARMS &&
-			table[i].index >= nalarms)
-		{
-			nalarms = table[i].index + 1;
+		if (id < parser->nsamples) {
+			uwatec_smart_decode_init (&parser->decode[i], parser->samples + id);
+		} else {
+			parser->decode[i].info = NULL;
+			parser->decode[i].nbytes = 0;
+			parser->decode[i].nbits = 0;
+			parser->decode[i].mask = 0;
 		}
 	}
+}
 
-	int complete = 0;
-	int calibrated = 0;
 
-	unsigned int time = 0;
-	unsigned int rbt = 99;
-	unsigned int tank = 0;
-	unsigned int gasmix = 0;
-	double depth = 0, depth_calibration = 0;
-	double temperature = 0;
-	double pressure = 0;
-	unsigned int heartrate = 0;
-	unsigned int bearing = 0;
-	unsigned int bookmark = 0;
+static void
+uwatec_smart_decoder_init (uwatec_smart_decoder_t *decoder, uwatec_smart_parser_t *parser)
+{
+	decoder->base.parser = (dc_parser_t *) parser;
+	decoder->base.step = uwatec_smart_decoder_step;
+	decoder->offset = parser->headersize;
+
+	decoder->complete = 0;
+	decoder->calibrated = 0;
+
+	decoder->time = 0;
+	decoder->rbt = 99;
+	decoder->tank = 0;
+	decoder->gasmix = 0;
+	decoder->depth = 0;
+	decoder->depth_calibration = 0;
+	decoder->temperature = 0;
+	decoder->pressure = 0;
+	decoder->heartrate = 0;
+	decoder->bearing = 0;
+	decoder->bookmark = 0;
 
 	// Previous gas mix - initialize with impossible value
-	unsigned int gasmix_previous = 0xFFFFFFFF;
+	decoder->gasmix_previous = 0xFFFFFFFF;
 
-	double salinity = (parser->watertype == DC_WATER_SALT ? SALT : FRESH);
+	decoder->salinity = (parser->watertype == DC_WATER_SALT ? SALT : FRESH);
 
-	unsigned int interval = 4;
+	decoder->interval = 4;
 	if (parser->divemode == DC_DIVEMODE_FREEDIVE) {
-		interval = 1;
+		decoder->interval = 1;
 	}
 
-	int have_depth = 0, have_temperature = 0, have_pressure = 0, have_rbt = 0,
-		have_heartrate = 0, have_bearing = 0;
+	decoder->have_depth = 0;
+	decoder->have_temperature = 0;
+	decoder->have_pressure = 0;
+	decoder->have_rbt = 0;
+	decoder->have_heartrate = 0;
+	decoder->have_bearing = 0;
+}
 
-	unsigned int offset = parser->headersize;
-	while (offset < size) {
-		dc_sample_value_t sample = {0};
 
-		// Process the type bits in the bitstream.
-		unsigned int id = 0;
-		if (parser->model == GALILEO || parser->model == GALILEOTRIMIX ||
-			parser->model == ALADIN2G || parser->model == MERIDIAN ||
-			parser->model == CHROMIS || parser->model == MANTIS2 ||
-			parser->model == G2 || parser->model == ALADINSPORTMATRIX ||
-			parser->model == ALADINSQUARE) {
-			// Uwatec Galileo
-			id = uwatec_galileo_identify (data[offset]);
-		} else {
-			// Uwatec Smart
-			id = uwatec_smart_identify (data + offset, size - offset);
+static dc_status_t
+uwatec_smart_decoder_step (dc_sample_decoder_t *base, dc_sample_callback_t callback, void *userdata)
+{
+	uwatec_smart_decoder_t *decoder = (uwatec_smart_decoder_t *) base;
+	uwatec_smart_parser_t *parser = (uwatec_smart_parser_t *) base->parser;
+	dc_parser_t *abstract = base->parser;
+
+	const unsigned char *data = abstract->data;
+	unsigned int size = abstract->size;
+
+	const uwatec_smart_sample_info_t *table = parser->samples;
+	unsigned int entries = parser->nsamples;
+
+	if (decoder->offset >= size) {
+		parser->cached = PROFILE;
+		return DC_STATUS_DONE;
+	}
+
+	dc_sample_value_t sample = {0};
+
+	// Process the type bits in the bitstream.
+	uwatec_smart_decode_t extended;
+	const uwatec_smart_decode_t *decode = parser->decode + data[decoder->offset];
+	if (decode->info == NULL) {
+		unsigned int id = entries;
+		if (!parser->galileo) {
+			id = uwatec_smart_identify (data + decoder->offset, size - decoder->offset);
 		}
 		if (id >= entries) {
 			ERROR (abstract->context, "Invalid type bits.");
 			return DC_STATUS_DATAFORMAT;
 		}
+		uwatec_smart_decode_init (&extended, table + id);
+		decode = &extended;
+	}
 
-		// Skip the processed type bytes.
-		offset += table[id].ntypebits / NBITS;
-
-		// Process the remaining data bits.
-		unsigned int nbits = 0;
-		unsigned int value = 0;
-		unsigned int n = table[id].ntypebits % NBITS;
-		if (n > 0) {
-			nbits = NBITS - n;
-			value = data[offset] & (0xFF >> n);
-			if (table[id].ignoretype) {
-				// Ignore any data bits that are stored in
-				// the last type byte for certain samples.
-				nbits = 0;
-				value = 0;
-			}
-			offset++;
-		}
+	const uwatec_smart_sample_info_t *info = decode->info;
 
-		// Check for buffer overflows.
-		if (offset + table[id].extrabytes > size) {
-			ERROR (abstract->context, "Incomplete sample data.");
-			return DC_STATUS_DATAFORMAT;
-		}
+	// Process the data bits in the last type byte, and
+	// skip the processed type bytes.
+	unsigned int nbits = decode->nbits;
+	unsigned int value = data[decoder->offset + decode->nbytes - 1] & decode->mask;
+	decoder->offset += decode->nbytes;
 
-		// Process the extra data bytes.
-		for (unsigned int i = 0; i < table[id].extrabytes; ++i) {
-			nbits += NBITS;
-			value <<= NBITS;
-			value += data[offset];
-			offset++;
-		}
+	// Check for buffer overflows.
+	if (decoder->offset + info->extrabytes > size) {
+		ERROR (abstract->context, "Incomplete sample data.");
+		return DC_STATUS_DATAFORMAT;
+	}
 
-		// Fix the sign bit.
-		signed int svalue = uwatec_smart_fixsignbit (value, nbits);
-
-		// Parse the value.
-		unsigned int idx = 0;
-		unsigned int subtype = 0;
-		unsigned int nevents = 0;
-		const uwatec_smart_event_info_t *events = NULL;
-		switch (table[id].type) {
-		case PRESSURE_DEPTH:
-			pressure += ((signed char) ((svalue >> NBITS) & 0xFF)) / 4.0;
-			depth += ((signed char) (svalue & 0xFF)) / 50.0;
-			complete = 1;
-			break;
-		case RBT:
-			if (table[id].absolute) {
-				rbt = value;
-				have_rbt = 1;
-			} else {
-				rbt += svalue;
-			}
-			break;
-		case TEMPERATURE:
-			if (table[id].absolute) {
-				temperature = svalue / 2.5;
-				have_temperature = 1;
-			} else {
-				temperature += svalue / 2.5;
-			}
-			break;
-		case PRESSURE:
-			if (table[id].absolute) {
-				if (parser->trimix) {
-					tank = (value & 0xF000) >> 12;
-					pressure = (value & 0x0FFF) / 4.0;
-				} else {
-					tank = table[id].index;
-					pressure = value / 4.0;
-				}
-				have_pressure = 1;
-				gasmix = tank;
-			} else {
-				pressure += svalue / 4.0;
-			}
-			break;
-		case DEPTH:
-			if (table[id].absolute) {
-				depth = value / 50.0;
-				if (!calibrated) {
-					calibrated = 1;
-					depth_calibration = depth;
-				}
-				have_depth = 1;
-			} else {
-				depth += svalue / 50.0;
-			}
-			complete = 1;
-			break;
-		case HEARTRATE:
-			if (table[id].absolute) {
-				heartrate = value;
-				have_heartrate = 1;
+	// Process the extra data bytes.
+	for (unsigned int i = 0; i < info->extrabytes; ++i) {
+		nbits += NBITS;
+		value <<= NBITS;
+		value += data[decoder->offset];
+		decoder->offset++;
+	}
+
+	// Fix the sign bit.
+	signed int svalue = uwatec_smart_fixsignbit (value, nbits);
+
+	// Parse the value.
+	unsigned int idx = 0;
+	unsigned int subtype = 0;
+	unsigned int nevents = 0;
+	const uwatec_smart_event_info_t *events = NULL;
+	switch (info->type) {
+	case PRESSURE_DEPTH:
+		decoder->pressure += ((signed char) ((svalue >> NBITS) & 0xFF)) / 4.0;
+		decoder->depth += ((signed char) (svalue & 0xFF)) / 50.0;
+		decoder->complete = 1;
+		break;
+	case RBT:
+		if (info->absolute) {
+			decoder->rbt = value;
+			decoder->have_rbt = 1;
+		} else {
+			decoder->rbt += svalue;
+		}
+		break;
+	case TEMPERATURE:
+		if (info->absolute) {
+			decoder->temperature = svalue / 2.5;
+			decoder->have_temperature = 1;
+		} else {
+			decoder->temperature += svalue / 2.5;
+		}
+		break;
+	case PRESSURE:
+		if (info->absolute) {
+			if (parser->trimix) {
+				decoder->tank = (value & 0xF000) >> 12;
+				decoder->pressure = (value & 0x0FFF) / 4.0;
 			} else {
-				heartrate += svalue;
+				decoder->tank = info->index;
+				decoder->pressure = value / 4.0;
 			}
-			break;
-		case BEARING:
-			bearing = value;
-			have_bearing = 1;
-			break;
-		case ALARMS:
-			idx = table[id].index;
-			if (idx >= NEVENTS || parser->events[idx] == NULL) {
-				ERROR (abstract->context, "Unexpected event index.");
-				return DC_STATUS_DATAFORMAT;
+			decoder->have_pressure = 1;
+			decoder->gasmix = decoder->tank;
+		} else {
+			decoder->pressure += svalue / 4.0;
+		}
+		break;
+	case DEPTH:
+		if (info->absolute) {
+			decoder->depth = value / 50.0;
+			if (!decoder->calibrated) {
+				decoder->calibrated = 1;
+				decoder->depth_calibration = decoder->depth;
 			}
+			decoder->have_depth = 1;
+		} else {
+			decoder->depth += svalue / 50.0;
+		}
+		decoder->complete = 1;
+		break;
+	case HEARTRATE:
+		if (info->absolute) {
+			decoder->heartrate = value;
+			decoder->have_heartrate = 1;
+		} else {
+			decoder->heartrate += svalue;
+		}
+		break;
+	case BEARING:
+		decoder->bearing = value;
+		decoder->have_bearing = 1;
+		break;
+	case ALARMS:
+		idx = info->index;
+		if (idx >= NEVENTS || parser->events[idx] == NULL) {
+			ERROR (abstract->context, "Unexpected event index.");
+			return DC_STATUS_DATAFORMAT;
+		}
 
-			events = parser->events[idx];
-			nevents = parser->nevents[idx];
-
-			for (unsigned int i = 0; i < nevents; ++i) {
-				uwatec_smart_event_t ev_type = events[i].type;
-				unsigned int ev_value = (value & events[i].mask) >> events[i].shift;
-				switch (ev_type) {
-				case EV_BOOKMARK:
-					bookmark = ev_value;
-					break;
-				case EV_GASMIX:
-					gasmix = ev_value;
-					break;
-				default:
-					break;
-				}
+		events = parser->events[idx];
+		nevents = parser->nevents[idx];
+
+		for (unsigned int i = 0; i < nevents; ++i) {
+			uwatec_smart_event_t ev_type = events[i].type;
+			unsigned int ev_value = (value & events[i].mask) >> events[i].shift;
+			switch (ev_type) {
+			case EV_BOOKMARK:
+				decoder->bookmark = ev_value;
+				break;
+			case EV_GASMIX:
+				decoder->gasmix = ev_value;
+				break;
+			default:
+				break;
 			}
-			break;
-		case TIME:
-			complete = value;
-			break;
-		case APNEA:
-			if (offset + 8 > size) {
-				ERROR (abstract->context, "Incomplete sample data.");
-				return DC_STATUS_DATAFORMAT;
-			}
-			offset += 8;
-			break;
-		case MISC:
-			if (value < 1 || offset + value - 1 > size) {
+		}
+		break;
+	case TIME:
+		decoder->complete = value;
+		break;
+	case APNEA:
+		if (decoder->offset + 8 > size) {
+			ERROR (abstract->context, "Incomplete sample data.");
+			return DC_STATUS_DATAFORMAT;
+		}
+		decoder->offset += 8;
+		break;
+	case MISC:
+		if (value < 1 || decoder->offset + value - 1 > size) {
+			ERROR (abstract->context, "Incomplete sample data.");
+			return DC_STATUS_DATAFORMAT;
+		}
+
+		subtype = data[decoder->offset];
+		if (subtype >= 32 && subtype <= 41) {
+			if (value < 16) {
 				ERROR (abstract->context, "Incomplete sample data.");
 				return DC_STATUS_DATAFORMAT;
 			}
-
-			subtype = data[offset];
-			if (subtype >= 32 && subtype <= 41) {
-				if (value < 16) {
-					ERROR (abstract->context, "Incomplete sample data.");
-					return DC_STATUS_DATAFORMAT;
-				}
-				unsigned int mixid = subtype - 32;
-				unsigned int mixidx = DC_GASMIX_UNKNOWN;
-				unsigned int o2 = array_uint16_le (data + offset + 1);
-				unsigned int he = array_uint16_le (data + offset + 3);
-				unsigned int beginpressure = array_uint16_le (data + offset + 5);
-				unsigned int endpressure   = array_uint16_le (data + offset + 7);
-
-				if (o2 != 0 || he != 0) {
-					idx = uwatec_smart_find_gasmix (parser, mixid);
-					if (idx >= parser->ngasmixes) {
-						if (idx >= NGASMIXES) {
-							ERROR (abstract->context, "Maximum number of gas mixes reached.");
-							return DC_STATUS_NOMEMORY;
-						}
-						parser->gasmix[idx].id = mixid;
-						parser->gasmix[idx].oxygen = o2;
-						parser->gasmix[idx].helium = he;
-						parser->ngasmixes++;
+			unsigned int mixid = subtype - 32;
+			unsigned int mixidx = DC_GASMIX_UNKNOWN;
+			unsigned int o2 = array_uint16_le (data + decoder->offset + 1);
+			unsigned int he = array_uint16_le (data + decoder->offset + 3);
+			unsigned int beginpressure = array_uint16_le (data + decoder->offset + 5);
+			unsigned int endpressure   = array_uint16_le (data + decoder->offset + 7);
+
+			if (o2 != 0 || he != 0) {
+				idx = uwatec_smart_find_gasmix (parser, mixid);
+				if (idx >= parser->ngasmixes) {
+					if (idx >= NGASMIXES) {
+						ERROR (abstract->context, "Maximum number of gas mixes reached.");
+						return DC_STATUS_NOMEMORY;
 					}
-					mixidx = idx;
+					parser->gasmix[idx].id = mixid;
+					parser->gasmix[idx].oxygen = o2;
+					parser->gasmix[idx].helium = he;
+					parser->ngasmixes++;
 				}
+				mixidx = idx;
+			}
 
-				if ((beginpressure != 0 || endpressure != 0) &&
-					(beginpressure != 0xFFFF) && (endpressure != 0xFFFF)) {
-					idx = uwatec_smart_find_tank (parser, mixid);
-					if (idx >= parser->ntanks) {
-						if (idx >= NGASMIXES) {
-							ERROR (abstract->context, "Maximum number of tanks reached.");
-							return DC_STATUS_NOMEMORY;
-						}
-						parser->tank[idx].id = mixid;
-						parser->tank[idx].beginpressure = beginpressure;
-						parser->tank[idx].endpressure = endpressure;
-						parser->tank[idx].gasmix = mixidx;
-						parser->ntanks++;
+			if ((beginpressure != 0 || endpressure != 0) &&
+				(beginpressure != 0xFFFF) && (endpressure != 0xFFFF)) {
+				idx = uwatec_smart_find_tank (parser, mixid);
+				if (idx >= parser->ntanks) {
+					if (idx >= NGASMIXES) {
+						ERROR (abstract->context, "Maximum number of tanks reached.");
+						return DC_STATUS_NOMEMORY;
 					}
+					parser->tank[idx].id = mixid;
+					parser->tank[idx].beginpressure = beginpressure;
+					parser->tank[idx].endpressure = endpressure;
+					parser->tank[idx].gasmix = mixidx;
+					parser->ntanks++;
 				}
 			}
-
-			offset += value - 1;
-			break;
-		default:
-			WARNING (abstract->context, "Unknown sample type.");
-			break;
 		}
 
-		while (complete) {
-			sample.time = time;
-			if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
+		decoder->offset += value - 1;
+		break;
+	default:
+		WARNING (abstract->context, "Unknown sample type.");
+		break;
+	}
 
-			if (parser->ngasmixes && gasmix != gasmix_previous) {
-				idx = uwatec_smart_find_gasmix (parser, gasmix);
-				if (idx >= parser->ngasmixes) {
-					ERROR (abstract->context, "Invalid gas mix index.");
-					return DC_STATUS_DATAFORMAT;
-				}
-				sample.gasmix = idx;
-				if (callback) callback (DC_SAMPLE_GASMIX, sample, userdata);
-				gasmix_previous = gasmix;
-			}
+	while (decoder->complete) {
+		sample.time = decoder->time;
+		if (callback) callback (DC_SAMPLE_TIME, sample, userdata);
 
-			if (have_temperature) {
-				sample.temperature = temperature;
-				if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+		if (parser->ngasmixes && decoder->gasmix != decoder->gasmix_previous) {
+			idx = uwatec_smart_find_gasmix (parser, decoder->gasmix);
+			if (idx >= parser->ngasmixes) {
+				ERROR (abstract->context, "Invalid gas mix index.");
+				return DC_STATUS_DATAFORMAT;
 			}
+			sample.gasmix = idx;
+			if (callback) callback (DC_SAMPLE_GASMIX, sample, userdata);
+			decoder->gasmix_previous = decoder->gasmix;
+		}
 
-			if (bookmark) {
-				sample.event.type = SAMPLE_EVENT_BOOKMARK;
-				sample.event.time = 0;
-				sample.event.flags = 0;
-				sample.event.value = 0;
-				if (callback) callback (DC_SAMPLE_EVENT, sample, userdata);
-			}
+		if (decoder->have_temperature) {
+			sample.temperature = decoder->temperature;
+			if (callback) callback (DC_SAMPLE_TEMPERATURE, sample, userdata);
+		}
 
-			if (have_rbt || have_pressure) {
-				sample.rbt = rbt;
-				if (callback) callback (DC_SAMPLE_RBT, sample, userdata);
-			}
+		if (decoder->bookmark) {
+			sample.event.type = SAMPLE_EVENT_BOOKMARK;
+			sample.event.time = 0;
+			sample.event.flags = 0;
+			sample.event.value = 0;
+			if (callback) callback (DC_SAMPLE_EVENT, sample, userdata);
+		}
 
-			if (have_pressure) {
-				idx = uwatec_smart_find_tank(parser, tank);
-				if (idx < parser->ntanks) {
-					sample.pressure.tank = idx;
-					sample.pressure.value = pressure;
-					if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
-				}
-			}
+		if (decoder->have_rbt || decoder->have_pressure) {
+			sample.rbt = decoder->rbt;
+			if (callback) callback (DC_SAMPLE_RBT, sample, userdata);
+		}
 
-			if (have_heartrate) {
-				sample.heartbeat = heartrate;
-				if (callback) callback (DC_SAMPLE_HEARTBEAT, sample, userdata);
+		if (decoder->have_pressure) {
+			idx = uwatec_smart_find_tank(parser, decoder->tank);
+			if (idx < parser->ntanks) {
+				sample.pressure.tank = idx;
+				sample.pressure.value = decoder->pressure;
+				if (callback) callback (DC_SAMPLE_PRESSURE, sample, userdata);
 			}
+		}
 
-			if (have_bearing) {
-				sample.bearing = bearing;
-				if (callback) callback (DC_SAMPLE_BEARING, sample, userdata);
-				have_bearing = 0;
-			}
+		if (decoder->have_heartrate) {
+			sample.heartbeat = decoder->heartrate;
+			if (callback) callback (DC_SAMPLE_HEARTBEAT, sample, userdata);
+		}
 
-			if (have_depth) {
-				sample.depth = (depth - depth_calibration) / salinity;
-				if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
-			}
+		if (decoder->have_bearing) {
+			sample.bearing = decoder->bearing;
+			if (callback) callback (DC_SAMPLE_BEARING, sample, userdata);
+			decoder->have_bearing = 0;
+		}
 
-			time += interval;
-			complete--;
+		if (decoder->have_depth) {
+			sample.depth = (decoder->depth - decoder->depth_calibration) / decoder->salinity;
+			if (callback) callback (DC_SAMPLE_DEPTH, sample, userdata);
 		}
-	}
 
-	parser->cached = PROFILE;
+		decoder->time += decoder->interval;
+		decoder->complete--;
+	}
 
 	return DC_STATUS_SUCCESS;
 }
 
 
+static dc_status_t
+uwatec_smart_parse (uwatec_smart_parser_t *parser, dc_sample_callback_t callback, void *userdata)
+{
+	uwatec_smart_decoder_t decoder;
+
+	uwatec_smart_decoder_init (&decoder, parser);
+
+	return dc_sample_decoder_run (&decoder.base, callback, userdata);
+}
+
+
 static dc_status_t
 uwatec_smart_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t callback, void *userdata)
 {
@@ -1252,3 +1345,28 @@ uwatec_smart_parser_samples_foreach (dc_parser_t *abstract, dc_sample_callback_t
 
 	return uwatec_smart_parse (parser, callback, userdata);
 }
+
+
+static dc_status_t
+uwatec_smart_parser_samples_iterator (dc_parser_t *abstract, dc_iterator_t **iterator)
+{
+	uwatec_smart_parser_t *parser = (uwatec_smart_parser_t *) abstract;
+
+	// Cache the parser data.
+	dc_status_t rc = uwatec_smart_parser_cache (parser);
+	if (rc != DC_STATUS_SUCCESS)
+		return rc;
+
+	// Cache the profile data. The gas mixes and tanks are only found
+	// in the profile, and are needed to decode the first sample.
+	if (parser->cached < PROFILE) {
+		rc = uwatec_smart_parse (parser, NULL, NULL);
+		if (rc != DC_STATUS_SUCCESS)
+			return rc;
+	}
+
+	uwatec_smart_decoder_t decoder;
+	uwatec_smart_decoder_init (&decoder, parser);
+
+	return dc_sample_decoder_iterator (iterator, &decoder.base, sizeof (decoder));
+}
@@ -0,0 +1,216 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#ifdef HAVE_PTHREAD_H
+#include <pthread.h>
+#endif
+
+#include "workqueue.h"
+#include "context-private.h"
+
+#ifdef HAVE_PTHREAD_H
+typedef struct dc_workqueue_item_t {
+	struct dc_workqueue_item_t *next;
+	dc_workqueue_func_t func;
+	void *userdata;
+} dc_workqueue_item_t;
+
+struct dc_workqueue_t {
+	dc_context_t *context;
+	pthread_mutex_t mutex;
+	pthread_cond_t work;
+	pthread_cond_t idle;
+	dc_workqueue_item_t *head;
+	dc_workqueue_item_t *tail;
+	unsigned int pending;
+	unsigned int shutdown;
+	unsigned int nthreads;
+	pthread_t *threads;
+};
+
+static void *
+dc_workqueue_worker (void *arg)
+{
+	dc_workqueue_t *workqueue = (dc_workqueue_t *) arg;
+
+	pthread_mutex_lock (&workqueue->mutex);
+	while (1) {
+		while (workqueue->head == NULL && !workqueue->shutdown)
+			pthread_cond_wait (&workqueue->work, &workqueue->mutex);
+
+		if (workqueue->head == NULL)
+			break;
+
+		// Take the first item from the queue.
+		dc_workqueue_item_t *item = workqueue->head;
+		workqueue->head = item->next;
+		if (workqueue->head == NULL)
+			workqueue->tail = NULL;
+
+		pthread_mutex_unlock (&workqueue->mutex);
+
+		item->func (item->userdata);
+		dc_context_deallocate (workqueue->context, item);
+
+		pthread_mutex_lock (&workqueue->mutex);
+		workqueue->pending--;
+		if (workqueue->pending == 0)
+			pthread_cond_broadcast (&workqueue->idle);
+	}
+	pthread_mutex_unlock (&workqueue->mutex);
+
+	return NULL;
+}
+
+static void
+dc_workqueue_shutdown (dc_workqueue_t *workqueue, unsigned int nthreads)
+{
+	pthread_mutex_lock (&workqueue->mutex);
+	workqueue->shutdown = 1;
+	pthread_cond_broadcast (&workqueue->work);
+	pthread_mutex_unlock (&workqueue->mutex);
+
+	for (unsigned int i = 0; i < nthreads; ++i) {
+		pthread_join (workqueue->threads[i], NULL);
+	}
+
+	pthread_cond_destroy (&workqueue->idle);
+	pthread_cond_destroy (&workqueue->work);
+	pthread_mutex_destroy (&workqueue->mutex);
+
+	dc_context_deallocate (workqueue->context, workqueue->threads);
+	dc_context_deallocate (workqueue->context, workqueue);
+}
+#endif
+
+dc_status_t
+dc_workqueue_new (dc_workqueue_t **out, dc_context_t *context, unsigned int nthreads)
+{
+#ifdef HAVE_PTHREAD_H
+	dc_workqueue_t *workqueue = NULL;
+
+	if (out == NULL || nthreads == 0)
+		return DC_STATUS_INVALIDARGS;
+
+	// Allocate memory.
+	workqueue = (dc_workqueue_t *) dc_context_allocate (context, sizeof (dc_workqueue_t));
+	if (workqueue == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	workqueue->threads = (pthread_t *) dc_context_allocate (context, nthreads * sizeof (pthread_t));
+	if (workqueue->threads == NULL) {
+		ERROR (context, "Failed to allocate memory.");
+		dc_context_deallocate (context, workqueue);
+		return DC_STATUS_NOMEMORY;
+	}
+
+	workqueue->context = context;
+	workqueue->head = NULL;
+	workqueue->tail = NULL;
+	workqueue->pending = 0;
+	workqueue->shutdown = 0;
+	workqueue->nthreads = nthreads;
+	pthread_mutex_init (&workqueue->mutex, NULL);
+	pthread_cond_init (&workqueue->work, NULL);
+	pthread_cond_init (&workqueue->idle, NULL);
+
+	// Start the worker threads.
+	for (unsigned int i = 0; i < nthreads; ++i) {
+		if (pthread_create (&workqueue->threads[i], NULL, dc_workqueue_worker, workqueue) != 0) {
+			ERROR (context, "Failed to start the worker thread.");
+			dc_workqueue_shutdown (workqueue, i);
+			return DC_STATUS_NOMEMORY;
+		}
+	}
+
+	*out = workqueue;
+
+	return DC_STATUS_SUCCESS;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+dc_status_t
+dc_workqueue_submit (dc_workqueue_t *workqueue, dc_workqueue_func_t func, void *userdata)
+{
+#ifdef HAVE_PTHREAD_H
+	if (workqueue == NULL || func == NULL)
+		return DC_STATUS_INVALIDARGS;
+
+	dc_workqueue_item_t *item = (dc_workqueue_item_t *) dc_context_allocate (workqueue->context, sizeof (dc_workqueue_item_t));
+	if (item == NULL) {
+		ERROR (workqueue->context, "Failed to allocate memory.");
+		return DC_STATUS_NOMEMORY;
+	}
+
+	item->next = NULL;
+	item->func = func;
+	item->userdata = userdata;
+
+	pthread_mutex_lock (&workqueue->mutex);
+	if (workqueue->tail)
+		workqueue->tail->next = item;
+	else
+		workqueue->head = item;
+	workqueue->tail = item;
+	workqueue->pending++;
+	pthread_cond_signal (&workqueue->work);
+	pthread_mutex_unlock (&workqueue->mutex);
+
+	return DC_STATUS_SUCCESS;
+#else
+	return DC_STATUS_UNSUPPORTED;
+#endif
+}
+
+void
+dc_workqueue_wait (dc_workqueue_t *workqueue)
+{
+#ifdef HAVE_PTHREAD_H
+	if (workqueue == NULL)
+		return;
+
+	pthread_mutex_lock (&workqueue->mutex);
+	while (workqueue->pending)
+		pthread_cond_wait (&workqueue->idle, &workqueue->mutex);
+	pthread_mutex_unlock (&workqueue->mutex);
+#endif
+}
+
+void
+dc_workqueue_free (dc_workqueue_t *workqueue)
+{
+#ifdef HAVE_PTHREAD_H
+	if (workqueue == NULL)
+		return;
+
+	dc_workqueue_wait (workqueue);
+	dc_workqueue_shutdown (workqueue, workqueue->nthreads);
+#endif
+}
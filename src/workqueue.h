@@ -0,0 +1,86 @@
+/*
+ * libdivecomputer
+ *
+ * Copyright (C) 2026 Jef Driesen
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston,
+ * MA 02110-1301 USA
+ */
+
+#ifndef DC_WORKQUEUE_H
+#define DC_WORKQUEUE_H
+
+#include <libdivecomputer/common.h>
+#include <libdivecomputer/context.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * Opaque object representing a pool of worker threads.
+ */
+typedef struct dc_workqueue_t dc_workqueue_t;
+
+/**
+ * Work item function, executed on one of the worker threads.
+ */
+typedef void (*dc_workqueue_func_t) (void *userdata);
+
+/**
+ * Create a new work queue.
+ *
+ * @param[out]  workqueue  A location to store the work queue.
+ * @param[in]   context    A valid context object.
+ * @param[in]   nthreads   The number of worker threads.
+ * @returns #DC_STATUS_SUCCESS on success, #DC_STATUS_UNSUPPORTED if
+ * threads are not available, or another #dc_status_t code on failure.
+ */
+dc_status_t
+dc_workqueue_new (dc_workqueue_t **workqueue, dc_context_t *context, unsigned int nthreads);
+
+/**
+ * Submit a work item. Work items are started in submission order.
+ *
+ * @param[in]   workqueue  A valid work queue.
+ * @param[in]   func       The work item function.
+ * @param[in]   userdata   User data passed to the function.
+ * @returns #DC_STATUS_SUCCESS on success, or another #dc_status_t code
+ * on failure.
+ */
+dc_status_t
+dc_workqueue_submit (dc_workqueue_t *workqueue, dc_workqueue_func_t func, void *userdata);
+
+/**
+ * Wait until all submitted work items have finished.
+ *
+ * @param[in]   workqueue  A valid work queue.
+ */
+void
+dc_workqueue_wait (dc_workqueue_t *workqueue);
+
+/**
+ * Wait for all work items, stop the worker threads and free the work
+ * queue.
+ *
+ * @param[in]   workqueue  A valid work queue.
+ */
+void
+dc_workqueue_free (dc_workqueue_t *workqueue);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+#endif /* DC_WORKQUEUE_H */